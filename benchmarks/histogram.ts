@@ -0,0 +1,30 @@
+// Adds up the weights of samples falling in each of ten buckets, the
+// shape of a weighted histogram kernel.
+export function histogramTotal(xs: number[], weights: number[], lows: number[], highs: number[]): number {
+    let total = 0
+    for (let b = 0; b < lows.length; b = b + 1) {
+        const low = lows[b]
+        const high = highs[b]
+        for (let i = 0; i < xs.length; i = i + 1) {
+            const x = xs[i]
+            const weight = weights[i]
+            if (low <= x) {
+                if (x < high) {
+                    total = total + weight
+                }
+            }
+        }
+    }
+    return total
+}
+
+const samples = [41, 31, 4, 39, 27, 45, 23, 0, 42, 48, 10, 60, 35, 64, 83, 25, 31, 64, 99, 0, 11, 33, 11, 18, 51, 75, 5, 50, 2, 38, 38, 80, 29, 10, 74, 67, 96, 19, 84, 91, 76, 49, 97, 41, 92, 63, 19, 36, 92, 79, 82, 18, 5, 91, 65, 80, 54, 93, 89, 64, 17, 67, 96, 64, 72, 2, 87, 74, 91, 87, 88, 82, 29, 10, 3, 5, 17, 81, 46, 13, 48, 57, 71, 6, 80, 2, 80, 68, 87, 31, 62, 33, 0, 58, 8, 95, 64, 68, 11, 84, 67, 8, 95, 94, 60, 32, 9, 33, 30, 93, 96, 26, 29, 94, 83, 58, 63, 48, 9, 61, 87, 36, 98, 5, 78, 80, 82, 25, 9, 76, 18, 42, 32, 83, 95, 88, 38, 79, 72, 17, 1, 61, 7, 62, 34, 86, 12, 88, 27, 86, 62, 37, 90, 66, 36, 59, 59, 59, 98, 15, 70, 25, 39, 10, 60, 2, 37, 58, 9, 64, 57, 34, 49, 26, 26, 9, 74, 11, 18, 95, 67, 33, 46, 16, 77, 80, 65, 35, 14, 90, 46, 29, 63, 62, 50, 3, 20, 0, 62, 87, 57, 51, 38, 93, 18, 53, 44, 48, 40, 15, 42, 0, 41, 96, 43, 50, 15, 25, 91, 1, 94, 37, 32, 47, 8, 50, 49, 75, 9, 46, 54, 96, 35, 6, 35, 13, 6, 84, 36, 81, 19, 31, 34, 55, 65, 40, 24, 98, 47, 54, 3, 97, 80, 51, 70, 70]
+const weights = [1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1]
+const lows = [0, 10, 20, 30, 40, 50, 60, 70, 80, 90]
+const highs = [10, 20, 30, 40, 50, 60, 70, 80, 90, 100]
+let total = 0
+for (let round = 0; round < 200000; round = round + 1) {
+    total = total + histogramTotal(samples, weights, lows, highs)
+}
+if (!(total === 51200000)) throw "every sample is in exactly one bucket"
+console.log(total)
@@ -0,0 +1,37 @@
+// Sums a 16x32 grid plus a weight per column, the shape of a
+// matrix-vector kernel.
+export function gridTotal(grid: number[][], weights: number[]): number {
+    let total = 0
+    for (const row of grid) {
+        for (let j = 0; j < row.length; j = j + 1) {
+            total = total + row[j] + weights[j]
+        }
+    }
+    return total
+}
+
+const grid = [
+    [5, 2, 6, 0, 1, 8, 1, 5, 9, 0, 8, 3, 0, 1, 6, 6, 1, 3, 1, 8, 6, 0, 9, 1, 3, 9, 0, 9, 9, 6, 0, 3],
+    [0, 8, 2, 4, 6, 2, 8, 1, 9, 4, 8, 2, 1, 9, 9, 3, 5, 1, 8, 1, 9, 0, 9, 3, 7, 8, 6, 5, 7, 9, 7, 5],
+    [4, 3, 2, 3, 1, 9, 4, 8, 7, 5, 7, 4, 9, 1, 1, 8, 6, 2, 5, 2, 7, 6, 0, 1, 8, 9, 5, 5, 5, 9, 7, 9],
+    [7, 1, 1, 4, 7, 1, 0, 4, 9, 7, 4, 6, 5, 0, 7, 5, 2, 9, 1, 7, 0, 3, 4, 2, 3, 6, 6, 7, 1, 2, 7, 6],
+    [8, 4, 2, 6, 8, 4, 6, 5, 6, 3, 2, 1, 2, 2, 3, 3, 0, 7, 9, 2, 4, 4, 0, 2, 6, 8, 5, 9, 9, 5, 2, 8],
+    [9, 0, 7, 8, 6, 6, 6, 6, 1, 7, 6, 0, 3, 1, 3, 7, 2, 1, 5, 9, 0, 1, 0, 9, 2, 8, 1, 5, 9, 0, 1, 3],
+    [9, 6, 2, 4, 5, 9, 5, 7, 1, 1, 7, 7, 7, 7, 4, 1, 2, 1, 5, 4, 7, 2, 8, 0, 3, 8, 5, 2, 8, 0, 8, 4],
+    [1, 4, 8, 5, 2, 5, 3, 8, 8, 8, 5, 3, 9, 3, 3, 6, 3, 3, 8, 7, 5, 0, 0, 4, 7, 4, 3, 9, 5, 7, 5, 5],
+    [1, 3, 1, 3, 7, 3, 5, 3, 7, 9, 9, 0, 7, 5, 1, 1, 6, 3, 7, 2, 6, 5, 1, 6, 7, 6, 1, 2, 2, 2, 0, 2],
+    [9, 7, 2, 9, 9, 7, 5, 2, 8, 8, 2, 0, 0, 1, 8, 2, 6, 3, 3, 0, 4, 3, 4, 8, 3, 9, 5, 4, 8, 6, 2, 0],
+    [5, 7, 9, 8, 6, 8, 2, 8, 2, 8, 8, 0, 7, 2, 9, 0, 2, 2, 2, 7, 9, 1, 8, 0, 5, 8, 8, 8, 7, 1, 8, 0],
+    [3, 3, 4, 0, 1, 8, 7, 8, 0, 1, 7, 5, 9, 8, 9, 8, 3, 4, 7, 8, 8, 7, 8, 3, 8, 4, 8, 3, 7, 2, 6, 1],
+    [6, 7, 5, 1, 3, 6, 1, 3, 4, 1, 2, 5, 2, 4, 2, 7, 3, 1, 6, 7, 2, 3, 2, 6, 8, 6, 5, 6, 3, 5, 5, 1],
+    [5, 0, 5, 8, 7, 7, 0, 6, 5, 8, 9, 4, 8, 1, 1, 3, 1, 1, 4, 4, 0, 2, 4, 2, 6, 4, 6, 2, 8, 8, 9, 7],
+    [5, 1, 4, 0, 2, 6, 1, 4, 0, 1, 4, 1, 9, 3, 1, 4, 1, 7, 0, 5, 8, 6, 4, 9, 2, 0, 8, 3, 1, 2, 4, 0],
+    [2, 3, 4, 4, 8, 3, 4, 7, 8, 2, 4, 5, 0, 4, 0, 0, 0, 8, 8, 3, 8, 7, 3, 7, 1, 6, 7, 8, 6, 8, 4, 3],
+]
+const weights = [3, 5, 3, 2, 6, 5, 0, 2, 0, 1, 4, 6, 2, 0, 1, 6, 8, 4, 9, 3, 4, 0, 7, 2, 2, 4, 7, 0, 4, 5, 5, 8]
+let total = 0
+for (let round = 0; round < 200000; round = round + 1) {
+    total = total + gridTotal(grid, weights)
+}
+if (total < 1) throw "the grid should not be empty"
+console.log(total)
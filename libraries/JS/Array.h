@@ -0,0 +1,73 @@
+#pragma once
+#include <Ty/Base.h>
+#include <Ty/ErrorOr.h>
+#include <Ty/Memory.h>
+#include <Ty/New.h>
+#include <Ty/Verify.h>
+
+namespace JS {
+
+// Compiled code only ever builds arrays front to back, and push gives a
+// new array sharing storage with the old one, which keeps the length it
+// had. Nothing frees arrays.
+template <typename T>
+struct Array {
+    static Array create(u32 capacity)
+    {
+        if (capacity == 0) {
+            return Array();
+        }
+        auto* data = (T*)MUST(Ty::allocate_memory(capacity * sizeof(T)));
+        return Array(data, 0, capacity);
+    }
+
+    // Arrays the compiler worked out ahead of time. They're full, so
+    // pushing onto one fails rather than writing to static storage.
+    static constexpr Array constant(T const* data, u32 length)
+    {
+        return Array(const_cast<T*>(data), length, length);
+    }
+
+    constexpr Array() = default;
+
+    Array push(T value) const
+    {
+        VERIFY(m_length < m_capacity);
+        new (&m_data[m_length]) T(value);
+        return Array(m_data, m_length + 1, m_capacity);
+    }
+
+    T const& operator[](u32 index) const
+    {
+        VERIFY(index < m_length);
+        return data()[index];
+    }
+
+    // For indices the compiler proved in range, either outright or by a
+    // check_length before the loop they're used in.
+    T const& unchecked_at(u32 index) const { return data()[index]; }
+
+    void check_length(u32 length) const { VERIFY(length <= m_length); }
+
+    u32 length() const { return m_length; }
+
+private:
+    // Storage comes straight from malloc, which is aligned for any scalar,
+    // so loops over it can use aligned vector loads.
+    static constexpr usize alignment = 16;
+
+    T const* data() const { return (T const*)__builtin_assume_aligned(m_data, alignment); }
+
+    constexpr Array(T* data, u32 length, u32 capacity)
+        : m_data(data)
+        , m_length(length)
+        , m_capacity(capacity)
+    {
+    }
+
+    T* m_data { nullptr };
+    u32 m_length { 0 };
+    u32 m_capacity { 0 };
+};
+
+}
@@ -3,6 +3,9 @@
 #include <Ty/StringBuffer.h>
 #include <Ty/ErrorOr.h>
 
+#include <stdio.h>
+#include <stdlib.h>
+
 namespace JS {
 
 ErrorOr<StringBuffer> Number::toString() const
@@ -10,4 +13,82 @@ ErrorOr<StringBuffer> Number::toString() const
     return TRY(StringBuffer::create_fill(m_value));
 }
 
+StringView Number::to_text(char (&buffer)[32]) const
+{
+    if (__builtin_isnan(m_value)) {
+        return "NaN"sv;
+    }
+    if (__builtin_isinf(m_value)) {
+        return m_value < 0.0 ? "-Infinity"sv : "Infinity"sv;
+    }
+    if (m_value == 0.0) {
+        return "0"sv;
+    }
+
+    // Try more and more digits until they give back the same number.
+    auto value = m_value < 0.0 ? -m_value : m_value;
+    char scientific[32];
+    for (int precision = 1; precision <= 17; precision++) {
+        snprintf(scientific, sizeof(scientific), "%.*e", precision - 1, value);
+        if (strtod(scientific, nullptr) == value) {
+            break;
+        }
+    }
+    char digits[17];
+    u32 digit_count = 0;
+    char const* at = scientific;
+    for (; *at != 'e'; at++) {
+        if (*at != '.') {
+            digits[digit_count++] = *at;
+        }
+    }
+    while (digit_count > 1 && digits[digit_count - 1] == '0') {
+        digit_count--;
+    }
+    // Where the decimal point goes, counted from the first digit.
+    int point = atoi(at + 1) + 1;
+
+    u32 size = 0;
+    auto put = [&](char c) {
+        buffer[size++] = c;
+    };
+    if (m_value < 0.0) {
+        put('-');
+    }
+    if (point >= (int)digit_count && point <= 21) {
+        for (u32 i = 0; i < digit_count; i++) {
+            put(digits[i]);
+        }
+        for (int i = digit_count; i < point; i++) {
+            put('0');
+        }
+    } else if (point > 0 && point <= 21) {
+        for (u32 i = 0; i < digit_count; i++) {
+            if ((int)i == point) {
+                put('.');
+            }
+            put(digits[i]);
+        }
+    } else if (point > -6 && point <= 0) {
+        put('0');
+        put('.');
+        for (int i = point; i < 0; i++) {
+            put('0');
+        }
+        for (u32 i = 0; i < digit_count; i++) {
+            put(digits[i]);
+        }
+    } else {
+        put(digits[0]);
+        if (digit_count > 1) {
+            put('.');
+        }
+        for (u32 i = 1; i < digit_count; i++) {
+            put(digits[i]);
+        }
+        size += snprintf(&buffer[size], sizeof(buffer) - size, "e%+d", point - 1);
+    }
+    return StringView(buffer, size);
+}
+
 }
@@ -1,9 +1,14 @@
+#pragma once
+#include <Ty/Base.h>
 #include <Ty/Forward.h>
+#include <Ty/StringView.h>
 
 namespace JS {
 
 struct Number {
-    Number(double value)
+    constexpr Number() = default;
+
+    constexpr Number(double value)
         : m_value(value)
     {
     }
@@ -15,7 +20,12 @@ struct Number {
 
     Number operator-(Number other) const
     {
-        return Number(m_value + other.m_value);
+        return Number(m_value - other.m_value);
+    }
+
+    bool operator<(Number other) const
+    {
+        return m_value < other.m_value;
     }
 
     bool operator<=(Number other) const
@@ -28,6 +38,22 @@ struct Number {
         return m_value == other.m_value;
     }
 
+    // Anything that isn't a whole number an array could be indexed with
+    // comes out past the end of every array.
+    u32 as_index() const
+    {
+        if (m_value >= 0.0 && m_value < 4294967295.0 && m_value == (double)(u32)m_value) {
+            return (u32)m_value;
+        }
+        return 0xFFFFFFFF;
+    }
+
+    f64 value() const { return m_value; }
+
+    // The shortest digits that read back as the same number, laid out the
+    // way JavaScript writes numbers into strings: 0.5, 1e+21, NaN.
+    StringView to_text(char (&buffer)[32]) const;
+
     ErrorOr<StringBuffer> toString() const;
 
 private:
@@ -0,0 +1,68 @@
+#pragma once
+#include <Ty/Base.h>
+#include <Ty/ErrorOr.h>
+#include <Ty/Memory.h>
+#include <Ty/New.h>
+
+namespace JS {
+
+// Instances of classes are carved out of chunks and kept on a free list
+// once freed, one list per size, so classes of the same size share
+// memory. Chunks are never given back.
+template <usize size>
+struct Pool {
+    static void* allocate()
+    {
+        if (!first_free) {
+            refill();
+        }
+        auto* object = first_free;
+        first_free = object->next;
+        return object;
+    }
+
+    static void release(void* object)
+    {
+        auto* free = (Free*)object;
+        free->next = first_free;
+        first_free = free;
+    }
+
+private:
+    struct Free {
+        Free* next;
+    };
+
+    static constexpr usize chunk_objects = 64;
+
+    static void refill()
+    {
+        auto* chunk = (u8*)MUST(Ty::allocate_memory(size * chunk_objects));
+        for (usize i = chunk_objects; i > 0; i--) {
+            release(chunk + (i - 1) * size);
+        }
+    }
+
+    static inline Free* first_free = nullptr;
+};
+
+// Sizes are rounded up to 16 bytes, which keeps every object aligned the
+// way malloc would.
+template <typename T>
+using PoolFor = Pool<(sizeof(T) + 15) / 16 * 16>;
+
+template <typename T>
+T* create_object()
+{
+    return new (PoolFor<T>::allocate()) T();
+}
+
+// Only for instances the compiler proved nothing refers to anymore.
+template <typename T>
+void free_object(T* object)
+{
+    object->~T();
+    PoolFor<T>::release(object);
+}
+
+}
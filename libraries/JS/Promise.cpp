@@ -0,0 +1,81 @@
+#include "./Promise.h"
+
+#include <Ty/Memory.h>
+
+namespace JS {
+
+// Frames up to frame_granularity * frame_classes bytes are kept for reuse,
+// rounded up to the next multiple of frame_granularity.
+static constexpr usize frame_granularity = 64;
+static constexpr usize frame_classes = 64;
+
+struct FreeFrame {
+    FreeFrame* next;
+};
+
+static FreeFrame* free_frames[frame_classes] {};
+
+static Microtask* first_task = nullptr;
+static Microtask* last_task = nullptr;
+static Optional<Error> unhandled_rejection {};
+
+void* allocate_frame(usize size)
+{
+    auto size_class = (size - 1) / frame_granularity;
+    if (size_class >= frame_classes) {
+        return MUST(Ty::allocate_memory(size));
+    }
+    if (auto* frame = free_frames[size_class]) {
+        free_frames[size_class] = frame->next;
+        return frame;
+    }
+    return MUST(Ty::allocate_memory((size_class + 1) * frame_granularity));
+}
+
+void free_frame(void* frame, usize size)
+{
+    auto size_class = (size - 1) / frame_granularity;
+    if (size_class >= frame_classes) {
+        Ty::free_memory(frame);
+        return;
+    }
+    auto* free = (FreeFrame*)frame;
+    free->next = free_frames[size_class];
+    free_frames[size_class] = free;
+}
+
+void enqueue_microtasks(Microtask* first, Microtask* last)
+{
+    last->next = nullptr;
+    if (last_task) {
+        last_task->next = first;
+    } else {
+        first_task = first;
+    }
+    last_task = last;
+}
+
+void reject_unhandled(Error error)
+{
+    if (!unhandled_rejection.has_value()) {
+        unhandled_rejection = error;
+    }
+}
+
+ErrorOr<void> run_microtasks()
+{
+    while (first_task) {
+        auto* task = first_task;
+        first_task = task->next;
+        if (!first_task) {
+            last_task = nullptr;
+        }
+        task->handle.resume();
+    }
+    if (unhandled_rejection.has_value()) {
+        return unhandled_rejection.value();
+    }
+    return {};
+}
+
+}
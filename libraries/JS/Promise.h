@@ -0,0 +1,192 @@
+#pragma once
+#include <Ty/Base.h>
+#include <Ty/ErrorOr.h>
+#include <Ty/Optional.h>
+#include <Ty/Traits.h>
+#include <Ty/Verify.h>
+
+#include <coroutine>
+
+namespace JS {
+
+// Frames of async functions come from free lists kept per size class, so
+// once a program has warmed up, starting one doesn't reach malloc.
+void* allocate_frame(usize size);
+void free_frame(void* frame, usize size);
+
+// A suspended async function waiting to be resumed. Awaiters carry their
+// own, so neither waiting on a promise nor queueing the continuation
+// allocates anything.
+struct Microtask {
+    Microtask* next { nullptr };
+    std::coroutine_handle<> handle {};
+};
+
+// Continuations run in the order they were queued, once the code that
+// queued them is done, which is when JS runs its microtasks. A promise
+// rejected without anyone awaiting it fails the program like an uncaught
+// throw would, once nothing is left to run.
+void enqueue_microtasks(Microtask* first, Microtask* last);
+void reject_unhandled(Error);
+ErrorOr<void> run_microtasks();
+
+// What an async function returns. It starts running right away, like in
+// JS, and its frame lives until it has finished and every promise for it
+// is gone. Awaiting always suspends, even when the promise has settled
+// already, so code after an await never runs before code after the call.
+template <typename T>
+struct Promise {
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    template <typename U>
+    struct Storage {
+        U value {};
+    };
+
+    template <typename U>
+        requires is_same<U, void>
+    struct Storage<U> { };
+
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(Handle handle) const noexcept
+        {
+            auto& promise = handle.promise();
+            promise.is_settled = true;
+            if (promise.first_waiter) {
+                enqueue_microtasks(promise.first_waiter, promise.last_waiter);
+            }
+            if (--promise.refs == 0) {
+                handle.destroy();
+            }
+        }
+
+        void await_resume() const noexcept { }
+    };
+
+    struct promise_type {
+        ~promise_type()
+        {
+            if (error.has_value() && !is_handled) {
+                reject_unhandled(error.value());
+            }
+        }
+
+        Promise get_return_object() { return Promise(Handle::from_promise(*this)); }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() const { UNREACHABLE(); }
+
+        void return_value(ErrorOr<T> result)
+        {
+            if (result.is_error()) {
+                error = result.release_error();
+                return;
+            }
+            if constexpr (!is_same<T, void>) {
+                value.value = result.release_value();
+            }
+        }
+
+        static void* operator new(usize size) { return allocate_frame(size); }
+        static void operator delete(void* frame, usize size) { free_frame(frame, size); }
+
+        Optional<Error> error {};
+        [[no_unique_address]] Storage<T> value {};
+        Microtask* first_waiter { nullptr };
+        Microtask* last_waiter { nullptr };
+        u32 refs { 1 };
+        bool is_settled { false };
+        bool is_handled { false };
+    };
+
+    struct Awaiter {
+        bool await_ready() const { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            task.handle = handle;
+            auto& state = promise.m_handle.promise();
+            state.is_handled = true;
+            if (state.is_settled) {
+                enqueue_microtasks(&task, &task);
+                return;
+            }
+            if (state.last_waiter) {
+                state.last_waiter->next = &task;
+            } else {
+                state.first_waiter = &task;
+            }
+            state.last_waiter = &task;
+        }
+
+        ErrorOr<T> await_resume() const
+        {
+            auto const& state = promise.m_handle.promise();
+            if (state.error.has_value()) {
+                return state.error.value();
+            }
+            if constexpr (is_same<T, void>) {
+                return {};
+            } else {
+                return T(state.value.value);
+            }
+        }
+
+        Promise promise;
+        Microtask task {};
+    };
+
+    Promise() = default;
+
+    Promise(Promise const& other)
+        : m_handle(other.m_handle)
+    {
+        retain();
+    }
+
+    Promise& operator=(Promise const& other)
+    {
+        if (m_handle != other.m_handle) {
+            release();
+            m_handle = other.m_handle;
+            retain();
+        }
+        return *this;
+    }
+
+    ~Promise() { release(); }
+
+    Awaiter operator co_await() const
+    {
+        VERIFY(m_handle);
+        return Awaiter { *this };
+    }
+
+private:
+    explicit Promise(Handle handle)
+        : m_handle(handle)
+    {
+        retain();
+    }
+
+    void retain()
+    {
+        if (m_handle) {
+            m_handle.promise().refs++;
+        }
+    }
+
+    void release()
+    {
+        if (m_handle && --m_handle.promise().refs == 0) {
+            m_handle.destroy();
+        }
+    }
+
+    Handle m_handle {};
+};
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "./Number.h"
+
+#include <Ty/ErrorOr.h>
+#include <Ty/FormatCounter.h>
+#include <Ty/Formatter.h>
+#include <Ty/Hash.h>
+#include <Ty/Memory.h>
+#include <Ty/StringView.h>
+
+namespace JS {
+
+using String = StringView;
+using string = String;
+
+// Switches on strings hash this to find the one case worth comparing.
+constexpr u64 hash(String string)
+{
+    return Ty::Hash().djbd(string.data(), string.size()).hash();
+}
+
+// Writes into storage already sized for everything written to it.
+struct StringFiller {
+    template <typename... Args>
+    ErrorOr<u32> write(Args... args) requires(sizeof...(Args) > 1)
+    {
+        ErrorOr<u32> results[] = {
+            write(args)...,
+        };
+        u32 written = 0;
+        for (auto& result : results)
+            written += TRY(result);
+        return written;
+    }
+
+    template <typename... Args>
+    ErrorOr<u32> writeln(Args... args)
+    {
+        return TRY(write(args..., "\n"sv));
+    }
+
+    ErrorOr<u32> write(StringView string)
+    {
+        auto size = string.unchecked_copy_to(&data[size_written]);
+        size_written += size;
+        return size;
+    }
+
+    template <typename T>
+    ErrorOr<u32> write(T value)
+    {
+        return TRY(Formatter<T>::write(*this, value));
+    }
+
+    char* data;
+    u32 size_written { 0 };
+};
+
+inline String as_string_part(String string) { return string; }
+inline Number as_string_part(Number number) { return number; }
+
+// What `a + b + c` on strings and template literals compile to. The parts
+// are counted first, the way StringBuffer sizes itself, so the string is
+// written straight into one allocation with nothing built in between.
+// Nothing frees strings.
+template <typename... Args>
+String concat(Args... args)
+{
+    auto size = MUST(FormatCounter::count(as_string_part(args)...));
+    if (size == 0) {
+        return ""sv;
+    }
+    auto* data = (char*)MUST(Ty::allocate_memory(size));
+    auto filler = StringFiller { .data = data };
+    MUST(filler.write(as_string_part(args)...));
+    return String(data, size);
+}
+
+}
+
+// Numbers go into strings the way JavaScript writes them, so 36 is "36"
+// rather than "36.0". Whole numbers, by far the most common, skip looking
+// for the shortest digits.
+template <>
+struct Ty::Formatter<JS::Number> {
+    template <typename U>
+    requires Writable<U>
+    static ErrorOr<u32> write(U& to, JS::Number number)
+    {
+        auto value = number.value();
+        auto magnitude = value < 0.0 ? -value : value;
+        if (magnitude < 1e21 && magnitude == (f64)(u128)magnitude) {
+            u32 size = 0;
+            if (value < 0.0) {
+                size += TRY(to.write("-"sv));
+            }
+            size += TRY(Formatter<u128>::write(to, (u128)magnitude));
+            return size;
+        }
+        char buffer[32];
+        return TRY(to.write(number.to_text(buffer)));
+    }
+};
+
+using JS::String;
+using JS::string;
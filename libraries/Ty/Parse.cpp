@@ -73,13 +73,17 @@ Optional<f64> Parse<f64>::from(StringView from)
     bool add_to_fraction = false;
     u128 whole_part = 0;
     u128 fraction_part = 0;
+    u128 fraction_divisor = 1;
     for (u32 i = 0; i < from.size(); i++) {
         if (add_to_fraction) {
-            fraction_part *= 10;
             auto maybe_number = character_to_number(from[i]);
             if (!maybe_number.has_value())
                 return {};
-            fraction_part += maybe_number.value();
+            // Digits past what an f64 can hold don't change the result.
+            if (fraction_divisor > Limits<u64>::max())
+                continue;
+            fraction_part = fraction_part * 10 + maybe_number.value();
+            fraction_divisor *= 10;
             continue;
         }
         if (from[i] == '.') {
@@ -96,26 +100,6 @@ Optional<f64> Parse<f64>::from(StringView from)
             return {};
     }
 
-    auto digits_in = [](u128 value) {
-        u128 digits = 0;
-
-        do {
-            digits++;
-            value /= 10;
-        } while (value != 0);
-
-        return digits;
-    };
-    auto digits_in_fraction = digits_in(fraction_part);
-
-    auto pow = [](u128 a, u128 b) {
-        auto orig_a = a;
-        while (--b != 0)
-            a *= orig_a;
-        return a;
-    };
-    auto fraction_divisor = pow(10, digits_in_fraction);
-
     return f64(
         whole_part + (f64(fraction_part) / f64(fraction_divisor)));
 }
@@ -1,43 +1,93 @@
-#include "./Parse.h"
+#include "./Codegen.h"
 
 #include <Ty/StringBuffer.h>
 
+struct Dispatch {
+    IR::ClassId class_;
+    u32 slot;
+};
+
 struct Codegen {
-    Source source;
-    ParseTree const& parse_tree;
+    IR::Module const& module;
+
+    // Every string literal in the program, once. Literals are used by
+    // referring to their entry, so equal literals are the same pointer.
+    Vector<StringView> strings {};
+
+    // Slots still called through after devirtualization, by the class
+    // that introduces them. Only these become virtual functions.
+    Vector<Dispatch> dispatches {};
+
+    // The order fields are declared in, by shape. Classes only list the
+    // fields they add.
+    Vector<Vector<u32>> layouts {};
+
+    bool counts_field_uses { false };
 };
 
 static ErrorOr<u32> codegen_prelude(StringBuffer&, Codegen const&);
 static ErrorOr<u32> codegen_types(StringBuffer&, Codegen const&);
+static ErrorOr<u32> codegen_classes(StringBuffer&, Codegen const&);
+static ErrorOr<u32> codegen_strings(StringBuffer&, Codegen const&);
 static ErrorOr<u32> codegen_function_forwards(StringBuffer&, Codegen const&);
+static ErrorOr<u32> codegen_methods(StringBuffer&, Codegen const&);
+static ErrorOr<u32> codegen_functions(StringBuffer&, Codegen const&);
 static ErrorOr<u32> codegen_main(StringBuffer&, Codegen const&);
-static ErrorOr<u32> codegen_expr(StringBuffer&, Codegen const&, Expr const&);
 
-static ErrorOr<u32> codegen_block(StringBuffer&, Codegen const&, Block const&);
-static ErrorOr<u32> codegen_var_decl(StringBuffer&, Codegen const&, VarDecl const&);
-static ErrorOr<u32> codegen_func_decl(StringBuffer&, Codegen const&, FuncDecl const&);
-static ErrorOr<u32> codegen_func_call(StringBuffer&, Codegen const&, FuncCall const&);
+static ErrorOr<u32> codegen_type(StringBuffer&, Type, IR::ShapeId);
+static ErrorOr<u32> codegen_field_name(StringBuffer&, StringView);
+static ErrorOr<u32> codegen_columns(StringBuffer&, Codegen const&, IR::ShapeId);
+static ErrorOr<u32> codegen_signature(StringBuffer&, Codegen const&, IR::Function const&);
+static ErrorOr<u32> codegen_function(StringBuffer&, Codegen const&, IR::Function const&);
+static ErrorOr<u32> codegen_tables(StringBuffer&, Codegen const&, IR::Function const&);
+static ErrorOr<u32> codegen_column_tables(StringBuffer&, Codegen const&, IR::Function const&, IR::Value);
+static bool is_columnar(Codegen const&, IR::Inst const&);
+static ErrorOr<u32> codegen_inst(StringBuffer&, Codegen const&, IR::Function const&, IR::BlockId, IR::Value);
+static ErrorOr<u32> codegen_binary(StringBuffer&, Codegen const&, IR::Function const&, IR::Value, StringView op);
+static ErrorOr<u32> codegen_match_string(StringBuffer&, Codegen const&, IR::Function const&, IR::Value);
+static ErrorOr<u32> codegen_call(StringBuffer&, Codegen const&, IR::Function const&, IR::Value);
+static ErrorOr<u32> codegen_call_virtual(StringBuffer&, Codegen const&, IR::Function const&, IR::Value);
+static ErrorOr<u32> codegen_co_try(StringBuffer&, Codegen const&, IR::Function const&, IR::Value);
+static ErrorOr<u32> codegen_tail_call(StringBuffer&, Codegen const&, IR::Function const&, IR::Value);
+static bool is_tail_call(Codegen const&, IR::Function const&, IR::BlockId, u32 index);
+static bool has_same_signature(IR::Function const&, IR::Function const&);
+static ErrorOr<u32> codegen_edge(StringBuffer&, Codegen const&, IR::Function const&, IR::BlockId from, IR::BlockId to);
+static ErrorOr<u32> codegen_args(StringBuffer&, Codegen const&, IR::Function const&, IR::Value);
+static ErrorOr<u32> codegen_value(StringBuffer&, Codegen const&, IR::Function const&, IR::Value);
+static ErrorOr<u32> codegen_constant(StringBuffer&, Codegen const&, IR::Function const&, IR::Value);
+static ErrorOr<u32> codegen_number(StringBuffer&, f64);
+static ErrorOr<u32> codegen_string(StringBuffer&, Codegen const&, StringView);
+static ErrorOr<Vector<StringView>> collect_strings(IR::Module const&);
+static ErrorOr<Vector<Dispatch>> collect_dispatches(IR::Module const&);
+static ErrorOr<Vector<Vector<u32>>> lay_out_fields(IR::Module const&);
+static u32 alignment_of(Type, IR::ShapeId, View<u32 const> shape_alignments);
+static ErrorOr<u32> codegen_counters(StringBuffer&, Codegen const&);
+static u32 counter_of(IR::Module const&, IR::ClassId, u32 index);
+static ErrorOr<u32> codegen_field_access(StringBuffer&, Codegen const&, IR::ShapeId, u32 index);
+static ErrorOr<u32> codegen_count_field_use(StringBuffer&, Codegen const&, IR::ShapeId, u32 index);
+static IR::ClassId declaring_class(IR::Module const&, IR::ClassId, u32 index);
+static bool has_cold_fields(IR::Class const&);
+static ErrorOr<u32> codegen_method_signature(StringBuffer&, Codegen const&, IR::ClassId, u32 slot, bool is_definition);
+static Optional<Dispatch> find_dispatch(Codegen const&, IR::ClassId, u32 slot);
 
-static ErrorOr<u32> codegen_if_stmt(StringBuffer&, Codegen const&, IfStmt const&);
-static ErrorOr<u32> codegen_throw_stmt(StringBuffer&, Codegen const&, ThrowStmt const&);
-static ErrorOr<u32> codegen_return_stmt(StringBuffer&, Codegen const&, ReturnStmt const&);
-
-static ErrorOr<u32> codegen_unary_expr(StringBuffer&, Codegen const&, UnaryExpr const&);
-static ErrorOr<u32> codegen_binary_expr(StringBuffer&, Codegen const&, BinaryExpr const&);
-static ErrorOr<u32> codegen_dot_expr(StringBuffer&, Codegen const&, DotExpr const&);
-
-static ErrorOr<u32> codegen_lvalue_expr(StringBuffer&, Codegen const&, Token);
-static ErrorOr<u32> codegen_rvalue_expr(StringBuffer&, Codegen const&, RValue const&);
-static ErrorOr<u32> codegen_string_literal(StringBuffer&, Codegen const&, Token);
-static ErrorOr<u32> codegen_number_literal(StringBuffer&, Codegen const&, Token);
-
-ErrorOr<StringBuffer> codegen(Source source, ParseTree const& tree)
+ErrorOr<StringBuffer> codegen(IR::Module const& module, bool count_field_uses)
 {
     auto out = TRY(StringBuffer::create());
-    auto codegen = Codegen(source, tree);
+    auto codegen = Codegen {
+        .module = module,
+        .strings = TRY(collect_strings(module)),
+        .dispatches = TRY(collect_dispatches(module)),
+        .layouts = TRY(lay_out_fields(module)),
+        .counts_field_uses = count_field_uses,
+    };
     TRY(codegen_prelude(out, codegen));
     TRY(codegen_types(out, codegen));
+    TRY(codegen_classes(out, codegen));
+    TRY(codegen_counters(out, codegen));
+    TRY(codegen_strings(out, codegen));
     TRY(codegen_function_forwards(out, codegen));
+    TRY(codegen_methods(out, codegen));
+    TRY(codegen_functions(out, codegen));
     TRY(codegen_main(out, codegen));
     return out;
 }
@@ -49,240 +99,1421 @@ static ErrorOr<u32> codegen_prelude(StringBuffer& out, Codegen const&)
 #include <JS/Console.h>
 #include <JS/Number.h>
 #include <JS/Boolean.h>
+#include <JS/String.h>
+#include <JS/Array.h>
+#include <JS/Object.h>
+#include <JS/Promise.h>
 )"sv));
 }
 
-static ErrorOr<u32> codegen_types(StringBuffer& out, Codegen const&)
+static ErrorOr<u32> codegen_types(StringBuffer& out, Codegen const& gen)
 {
-    return TRY(out.writeln("\n// FIXME: implement codegen_types"sv));
+    u32 size = 0;
+
+    // Classes are only referred to by pointer, so objects can hold them
+    // before they're defined.
+    for (auto const& class_ : gen.module.classes) {
+        size += TRY(out.writeln("struct _Shape"sv, class_.shape.raw(), ";"sv));
+    }
+
+    // Objects that were taken apart don't need a type anymore.
+    auto is_used = TRY(Vector<bool>::create(gen.module.shapes.size()));
+    for (u32 i = 0; i < gen.module.shapes.size(); i++) {
+        TRY(is_used.append(false));
+    }
+    for (auto const& class_ : gen.module.classes) {
+        auto const& shape = gen.module[class_.shape];
+        for (u32 i = 0; i < shape.fields.size(); i++) {
+            if (shape.types[i] == Type::object) {
+                is_used[shape.shapes[i].raw()] = true;
+            }
+        }
+    }
+    for (auto const& function : gen.module.functions) {
+        if (function.return_type == Type::object) {
+            is_used[function.return_shape.raw()] = true;
+        }
+        for (auto const& inst : function.insts) {
+            if (inst.kind != IR::Inst::nop && inst.type == Type::object) {
+                is_used[inst.shape.raw()] = true;
+            }
+        }
+    }
+
+    // Shapes only refer to shapes created before them, so this order
+    // never uses an incomplete type.
+    for (u32 i = gen.module.shapes.size(); i > 0; i--) {
+        auto const& shape = gen.module.shapes[i - 1];
+        for (u32 j = 0; j < shape.fields.size(); j++) {
+            if (is_used[i - 1] && shape.types[j] == Type::object) {
+                is_used[shape.shapes[j].raw()] = true;
+            }
+        }
+        for (auto variant : shape.variants.view()) {
+            if (is_used[i - 1]) {
+                is_used[variant.raw()] = true;
+            }
+        }
+    }
+    for (u32 i = 0; i < gen.module.shapes.size(); i++) {
+        auto const& shape = gen.module.shapes[i];
+        if (!is_used[i] || gen.module.find_class(IR::ShapeId(i)).has_value()) {
+            continue;
+        }
+        size += TRY(out.writeln("\nstruct _Shape"sv, i, " {"sv));
+        if (shape.is_union()) {
+            // A small tag next to storage for the largest variant. The
+            // first variant is initialized so the union can be default
+            // constructed.
+            size += TRY(out.writeln(shape.variants.size() <= 256 ? "    u8 _tag;"sv : "    u16 _tag;"sv));
+            size += TRY(out.writeln("    union {"sv));
+            for (u32 j = 0; j < shape.variants.size(); j++) {
+                size += TRY(out.writeln("        _Shape"sv, shape.variants[j].raw(), " _"sv, j, j == 0 ? " {};"sv : ";"sv));
+            }
+            size += TRY(out.writeln("    };"sv));
+        }
+        for (auto j : gen.layouts[i].view()) {
+            size += TRY(out.write("    "sv));
+            size += TRY(codegen_type(out, shape.types[j], shape.shapes[j]));
+            size += TRY(out.write(" "sv));
+            size += TRY(codegen_field_name(out, shape.fields[j]));
+            // Presence flags come last, so they pack together.
+            if (IR::Shape::is_presence(shape.fields[j])) {
+                size += TRY(out.write(" : 1"sv));
+            }
+            size += TRY(out.writeln(";"sv));
+        }
+        size += TRY(out.writeln("};"sv));
+        if (shape.is_columnar) {
+            size += TRY(codegen_columns(out, gen, IR::ShapeId(i)));
+        }
+    }
+    size += TRY(out.writeln(""sv));
+
+    return size;
 }
 
-static ErrorOr<u32> codegen_function_forwards(StringBuffer& out, Codegen const& gen)
+static ErrorOr<u32> codegen_columns(StringBuffer& out, Codegen const& gen, IR::ShapeId id)
 {
+    // Arrays of a columnar shape are an array per field behind the same
+    // interface as any other array. Elements are put back together when
+    // read, which the C++ compiler takes apart again when only some of
+    // their fields are used.
     u32 size = 0;
-    for (auto const& expr : gen.parse_tree.expressions) {
-        if (expr.kind == Expr::func_decl) {
-            auto func = expr.as.func_decl;
-            auto return_type = TRY(func->return_type.to_string());
-            auto name = func->name.view_in(gen.source.file);
-            size += TRY(out.write("static ErrorOr<"sv, return_type.view(), ">"sv));
-            size += TRY(out.write("(*"sv, name, ")("sv));
-            for (usize i = 0; auto const& arg : func->args.view()) {
-                auto arg_type = TRY(arg.type.to_string());
-                size += TRY(out.write(arg_type.view()));
-                if (i + 1 < func->args.size()) {
-                    size += TRY(out.write(", "sv));
-                }
-                i++;
-            }
-            size += TRY(out.writeln(") = nullptr;"sv));
+    auto const& shape = gen.module[id];
+    auto const& layout = gen.layouts[id.raw()];
+    auto column_types = TRY(Vector<StringBuffer>::create(shape.fields.size()));
+    for (u32 i = 0; i < shape.fields.size(); i++) {
+        auto type = TRY(StringBuffer::create());
+        TRY(codegen_type(type, Type::from_array(new Type(shape.types[i])), shape.shapes[i]));
+        TRY(column_types.append(move(type)));
+    }
+    auto each_field = [&](auto write) -> ErrorOr<u32> {
+        u32 size = 0;
+        size += TRY(out.write("    {\n        return { "sv));
+        for (u32 i = 0; i < layout.size(); i++) {
+            size += TRY(write(shape.fields[layout[i]], column_types[layout[i]].view()));
+            size += TRY(out.write(i + 1 < layout.size() ? ", "sv : " };\n    }\n"sv));
         }
+        return size;
+    };
+
+    size += TRY(out.writeln("\ntemplate <>"sv));
+    size += TRY(out.writeln("struct JS::Array<_Shape"sv, id.raw(), "> {"sv));
+    size += TRY(out.writeln("    static Array create(u32 capacity)"sv));
+    size += TRY(each_field([&](StringView, StringView column) {
+        return out.write(column, "::create(capacity)"sv);
+    }));
+
+    size += TRY(out.write("\n    static constexpr Array constant("sv));
+    for (u32 i = 0; i < shape.fields.size(); i++) {
+        size += TRY(codegen_type(out, shape.types[i], shape.shapes[i]));
+        size += TRY(out.write(" const* "sv, shape.fields[i], ", "sv));
     }
+    size += TRY(out.writeln("u32 length)"sv));
+    size += TRY(each_field([&](StringView field, StringView column) {
+        return out.write(column, "::constant("sv, field, ", length)"sv);
+    }));
+
+    size += TRY(out.writeln("\n    Array push(_Shape"sv, id.raw(), " value) const"sv));
+    size += TRY(each_field([&](StringView field, StringView) {
+        return out.write(field, ".push(value."sv, field, ")"sv);
+    }));
+
+    size += TRY(out.writeln("\n    _Shape"sv, id.raw(), " operator[](u32 index) const"sv));
+    size += TRY(out.writeln("    {"sv));
+    size += TRY(out.writeln("        VERIFY(index < length());"sv));
+    size += TRY(out.writeln("        return unchecked_at(index);"sv));
+    size += TRY(out.writeln("    }"sv));
+
+    size += TRY(out.writeln("\n    _Shape"sv, id.raw(), " unchecked_at(u32 index) const"sv));
+    size += TRY(each_field([&](StringView field, StringView) {
+        return out.write(field, ".unchecked_at(index)"sv);
+    }));
+
+    size += TRY(out.writeln("\n    void check_length(u32 length) const { "sv, shape.fields[0], ".check_length(length); }"sv));
+    size += TRY(out.writeln("    u32 length() const { return "sv, shape.fields[0], ".length(); }\n"sv));
+    for (auto i : layout.view()) {
+        size += TRY(out.writeln("    "sv, column_types[i].view(), " "sv, shape.fields[i], " {};"sv));
+    }
+    size += TRY(out.writeln("};"sv));
     return size;
 }
 
-static ErrorOr<u32> codegen_main(StringBuffer& out, Codegen const& gen)
+static ErrorOr<Vector<Vector<u32>>> lay_out_fields(IR::Module const& module)
+{
+    // Fields go from the most to the least strictly aligned, which leaves
+    // no padding between them. Presence flags stay last so they pack into
+    // bits, and unions keep the order they have.
+    auto alignments = TRY(Vector<u32>::create(module.shapes.size()));
+    for (u32 i = 0; i < module.shapes.size(); i++) {
+        auto const& shape = module.shapes[i];
+        u32 alignment = shape.is_union() ? (shape.variants.size() <= 256 ? 1 : 2) : 1;
+        for (u32 j = 0; j < shape.fields.size(); j++) {
+            auto field = alignment_of(shape.types[j], shape.shapes[j], alignments.view());
+            alignment = field > alignment ? field : alignment;
+        }
+        for (auto variant : shape.variants.view()) {
+            alignment = alignments[variant.raw()] > alignment ? alignments[variant.raw()] : alignment;
+        }
+        TRY(alignments.append(alignment));
+    }
+
+    auto layouts = TRY(Vector<Vector<u32>>::create(module.shapes.size()));
+    for (u32 i = 0; i < module.shapes.size(); i++) {
+        auto const& shape = module.shapes[i];
+        auto class_ = module.find_class(IR::ShapeId(i));
+        u32 first = 0;
+        if (class_.has_value() && module[class_.value()].base.is_valid()) {
+            first = module[module[module[class_.value()].base].shape].fields.size();
+        }
+        auto key = [&](u32 field) -> u32 {
+            if (IR::Shape::is_presence(shape.fields[field])) {
+                return 0;
+            }
+            return alignment_of(shape.types[field], shape.shapes[field], alignments.view());
+        };
+        auto layout = TRY(Vector<u32>::create(shape.fields.size() - first));
+        for (u32 j = first; j < shape.fields.size(); j++) {
+            TRY(layout.append(j));
+            for (u32 k = layout.size() - 1; !shape.is_union() && k > 0 && key(layout[k]) > key(layout[k - 1]); k--) {
+                auto field = layout[k];
+                layout[k] = layout[k - 1];
+                layout[k - 1] = field;
+            }
+        }
+        TRY(layouts.append(move(layout)));
+    }
+    return layouts;
+}
+
+static u32 alignment_of(Type type, IR::ShapeId shape, View<u32 const> shape_alignments)
 {
+    // Class instances and everything else not listed are pointers or hold
+    // one.
+    if (type == Type::boolean) {
+        return 1;
+    }
+    if (type == Type::index) {
+        return 4;
+    }
+    if (type == Type::object && shape.raw() < shape_alignments.size()) {
+        return shape_alignments[shape.raw()];
+    }
+    return 8;
+}
+
+static ErrorOr<u32> codegen_field_access(StringBuffer& out, Codegen const& gen, IR::ShapeId shape, u32 index)
+{
+    auto class_ = declaring_class(gen.module, gen.module.find_class(shape).value(), index);
+    auto const& declaring = gen.module[class_];
+    auto name = gen.module[shape].fields[index];
+    if (has_cold_fields(declaring) && declaring.is_cold[index]) {
+        return TRY(out.write("->_cold"sv, declaring.shape.raw(), "->"sv, name));
+    }
+    return TRY(out.write("->"sv, name));
+}
+
+static ErrorOr<u32> codegen_count_field_use(StringBuffer& out, Codegen const& gen, IR::ShapeId shape, u32 index)
+{
+    // Uses of inherited fields count towards the class declaring them.
+    if (!gen.counts_field_uses) {
+        return 0;
+    }
+    auto class_ = declaring_class(gen.module, gen.module.find_class(shape).value(), index);
+    return TRY(out.writeln("    _field_uses["sv, counter_of(gen.module, class_, index), "]++;"sv));
+}
+
+static IR::ClassId declaring_class(IR::Module const& module, IR::ClassId class_, u32 index)
+{
+    // Fields of a base come first, so the class declaring a field is the
+    // furthest base that still has it.
+    while (module[class_].base.is_valid() && index < module[module[module[class_].base].shape].fields.size()) {
+        class_ = module[class_].base;
+    }
+    return class_;
+}
+
+static bool has_cold_fields(IR::Class const& class_)
+{
+    return class_.is_cold.find(true).has_value();
+}
+
+static ErrorOr<u32> codegen_classes(StringBuffer& out, Codegen const& gen)
+{
+    // Each class after its base. A class only holds the fields it adds,
+    // and only slots something still dispatches on are virtual.
     u32 size = 0;
+    auto const& classes = gen.module.classes;
+    auto is_emitted = TRY(Vector<bool>::create(classes.size()));
+    auto is_base = TRY(Vector<bool>::create(classes.size()));
+    for (u32 i = 0; i < classes.size(); i++) {
+        TRY(is_emitted.append(false));
+        TRY(is_base.append(false));
+    }
+    for (auto const& class_ : classes) {
+        if (class_.base.is_valid()) {
+            is_base[class_.base.raw()] = true;
+        }
+    }
+    for (u32 emitted = 0; emitted < classes.size();) {
+        for (u32 i = 0; i < classes.size(); i++) {
+            auto const& class_ = classes[i];
+            if (is_emitted[i] || (class_.base.is_valid() && !is_emitted[class_.base.raw()])) {
+                continue;
+            }
+            is_emitted[i] = true;
+            emitted++;
 
-    size += TRY(out.writeln("ErrorOr<int> Main::main(int, c_string[])"sv));
-    size += TRY(out.writeln("{"sv));
-    size += TRY(out.writeln("TRY([]() -> ErrorOr<void> {"sv));
+            // Cold fields get a struct of their own, which the instance
+            // points to.
+            auto const& shape = gen.module[class_.shape];
+            auto const& layout = gen.layouts[class_.shape.raw()];
+            if (has_cold_fields(class_)) {
+                size += TRY(out.writeln("struct _Cold"sv, class_.shape.raw(), " {"sv));
+                for (auto j : layout.view()) {
+                    if (!class_.is_cold[j]) {
+                        continue;
+                    }
+                    size += TRY(out.write("    "sv));
+                    size += TRY(codegen_type(out, shape.types[j], shape.shapes[j]));
+                    size += TRY(out.writeln(" "sv, shape.fields[j], " {};"sv));
+                }
+                size += TRY(out.writeln("};\n"sv));
+            }
 
-    for (auto const& expr : gen.parse_tree.expressions) {
-        size += TRY(codegen_expr(out, gen, expr));
-        size += TRY(out.writeln(";"sv));
+            size += TRY(out.write("struct _Shape"sv, class_.shape.raw()));
+            if (!is_base[i]) {
+                size += TRY(out.write(" final"sv));
+            }
+            if (class_.base.is_valid()) {
+                size += TRY(out.write(" : _Shape"sv, classes[class_.base].shape.raw()));
+            }
+            size += TRY(out.writeln(" {"sv));
+            for (auto j : layout.view()) {
+                if (has_cold_fields(class_) && class_.is_cold[j]) {
+                    continue;
+                }
+                size += TRY(out.write("    "sv));
+                size += TRY(codegen_type(out, shape.types[j], shape.shapes[j]));
+                size += TRY(out.writeln(" "sv, shape.fields[j], " {};"sv));
+            }
+            if (has_cold_fields(class_)) {
+                size += TRY(out.writeln("    _Cold"sv, class_.shape.raw(), "* _cold"sv, class_.shape.raw(), " {};"sv));
+            }
+            for (u32 slot = 0; slot < class_.methods.size(); slot++) {
+                auto id = IR::ClassId(i);
+                if (!find_dispatch(gen, id, slot).has_value()) {
+                    continue;
+                }
+                bool is_override = gen.module.introducing(id, slot) != id;
+                if (is_override && class_.implementations[slot] == classes[class_.base].implementations[slot]) {
+                    continue;
+                }
+                size += TRY(out.write("    "sv, is_override ? ""sv : "virtual "sv));
+                size += TRY(codegen_method_signature(out, gen, id, slot, false));
+                size += TRY(out.writeln(is_override ? " override;"sv : ";"sv));
+            }
+            size += TRY(out.writeln("};\n"sv));
+        }
     }
+    return size;
+}
 
-    size += TRY(out.writeln("return {};"sv));
-    size += TRY(out.writeln("}());"sv));
-    size += TRY(out.writeln("return 0;"sv));
-    size += TRY(out.writeln("}"sv));
+static ErrorOr<u32> codegen_counters(StringBuffer& out, Codegen const& gen)
+{
+    // One counter for each field of each class, in the order of the
+    // classes and then their shapes.
+    if (!gen.counts_field_uses || gen.module.classes.is_empty()) {
+        return 0;
+    }
+    auto last = IR::ClassId(gen.module.classes.size() - 1);
+    auto count = counter_of(gen.module, last, gen.module[gen.module[last].shape].fields.size());
+    return TRY(out.writeln("static u64 _field_uses["sv, count, "] {};\n"sv));
+}
+
+static u32 counter_of(IR::Module const& module, IR::ClassId class_, u32 index)
+{
+    auto first_field = [&](IR::Class const& class_) -> u32 {
+        return class_.base.is_valid() ? module[module[class_.base].shape].fields.size() : 0;
+    };
+    u32 counter = index - first_field(module[class_]);
+    for (u32 i = 0; i < class_.raw(); i++) {
+        auto const& other = module.classes[i];
+        counter += module[other.shape].fields.size() - first_field(other);
+    }
+    return counter;
+}
 
+static ErrorOr<u32> codegen_strings(StringBuffer& out, Codegen const& gen)
+{
+    if (gen.strings.is_empty()) {
+        return 0;
+    }
+    u32 size = 0;
+    size += TRY(out.writeln("\nstatic constexpr JS::String _strings[] = {"sv));
+    for (auto string : gen.strings.view()) {
+        size += TRY(out.writeln("    \""sv, string, "\"sv,"sv));
+    }
+    size += TRY(out.writeln("};\n"sv));
     return size;
 }
 
-static ErrorOr<u32> codegen_expr(StringBuffer& out, Codegen const& codegen, Expr const& expr)
+static ErrorOr<Vector<StringView>> collect_strings(IR::Module const& module)
 {
-    switch(expr) {
-    case Expr::none:
-        return Error::from_string_literal("trying to codegen none");
-    case Expr::block:
-        return TRY(codegen_block(out, codegen, *expr.as.block));
-    case Expr::var_decl:
-        return TRY(codegen_var_decl(out, codegen, *expr.as.var_decl));
-    case Expr::func_decl:
-        return TRY(codegen_func_decl(out, codegen, *expr.as.func_decl));
-    case Expr::func_call:
-        return TRY(codegen_func_call(out, codegen, *expr.as.func_call));
+    auto strings = Vector<StringView>();
+    auto add = [&](StringView string) -> ErrorOr<void> {
+        if (!strings.find(string).has_value()) {
+            TRY(strings.append(string));
+        }
+        return {};
+    };
+    for (auto const& function : module.functions) {
+        for (u32 i = 0; i < function.insts.size(); i++) {
+            auto const& inst = function.insts[i];
+            if (inst.kind == IR::Inst::constant_string) {
+                TRY(add(inst.as.string));
+            }
+            if (inst.kind == IR::Inst::match_string) {
+                for (auto string : function.strings_of(IR::Value(i))) {
+                    TRY(add(string));
+                }
+            }
+        }
+    }
+    return strings;
+}
 
-    case Expr::if_stmt:
-        return TRY(codegen_if_stmt(out, codegen, *expr.as.if_stmt));
-    case Expr::throw_stmt:
-        return TRY(codegen_throw_stmt(out, codegen, *expr.as.throw_stmt));
-    case Expr::return_stmt:
-        return TRY(codegen_return_stmt(out, codegen, *expr.as.return_stmt));
+static ErrorOr<Vector<Dispatch>> collect_dispatches(IR::Module const& module)
+{
+    auto dispatches = Vector<Dispatch>();
+    for (auto const& function : module.functions) {
+        for (u32 i = 0; i < function.insts.size(); i++) {
+            auto const& inst = function.insts[i];
+            if (inst.kind != IR::Inst::call_virtual) {
+                continue;
+            }
+            auto receiver = function.operands_of(IR::Value(i))[0];
+            auto class_ = module.introducing(module.find_class(function[receiver].shape).value(), inst.as.index);
+            bool is_known = false;
+            for (auto dispatch : dispatches.view()) {
+                is_known |= dispatch.class_ == class_ && dispatch.slot == inst.as.index;
+            }
+            if (!is_known) {
+                TRY(dispatches.append(Dispatch { class_, inst.as.index }));
+            }
+        }
+    }
+    return dispatches;
+}
 
-    case Expr::unary_expr:
-        return TRY(codegen_unary_expr(out, codegen, *expr.as.unary_expr));
-    case Expr::binary_expr:
-        return TRY(codegen_binary_expr(out, codegen, *expr.as.binary_expr));
-    case Expr::dot_expr:
-        return TRY(codegen_dot_expr(out, codegen, *expr.as.dot_expr));
+static Optional<Dispatch> find_dispatch(Codegen const& gen, IR::ClassId class_, u32 slot)
+{
+    auto introducing = gen.module.introducing(class_, slot);
+    for (auto dispatch : gen.dispatches.view()) {
+        if (dispatch.class_ == introducing && dispatch.slot == slot) {
+            return dispatch;
+        }
+    }
+    return {};
+}
 
-    case Expr::lvalue_expr:
-        return TRY(codegen_lvalue_expr(out, codegen, expr.as.lvalue_expr));
-    case Expr::rvalue_expr:
-        return TRY(codegen_rvalue_expr(out, codegen, *expr.as.rvalue_expr));
+static ErrorOr<u32> codegen_method_signature(StringBuffer& out, Codegen const& gen, IR::ClassId class_, u32 slot, bool is_definition)
+{
+    // Overrides share the signature of the method they override, which
+    // throws if any of them can.
+    u32 size = 0;
+    auto introducing = gen.module.introducing(class_, slot);
+    auto const& function = gen.module[gen.module[introducing].implementations[slot]];
+    if (function.is_async) {
+        size += TRY(out.write("JS::Promise<"sv));
+        size += TRY(codegen_type(out, function.return_type, function.return_shape));
+        size += TRY(out.write("> "sv));
+    } else if (gen.module.dispatch_may_throw(introducing, slot)) {
+        size += TRY(out.write("ErrorOr<"sv));
+        size += TRY(codegen_type(out, function.return_type, function.return_shape));
+        size += TRY(out.write("> "sv));
+    } else {
+        size += TRY(codegen_type(out, function.return_type, function.return_shape));
+        size += TRY(out.write(" "sv));
+    }
+    if (is_definition) {
+        size += TRY(out.write("_Shape"sv, gen.module[class_].shape.raw(), "::"sv));
+    }
+    size += TRY(out.write(gen.module[class_].methods[slot], "("sv));
+    auto const& implementation = gen.module[gen.module[class_].implementations[slot]];
+    for (u32 i = 1; i < function.params.size(); i++) {
+        auto param = function.params[i];
+        size += TRY(codegen_type(out, function[param].type, function[param].shape));
+        size += TRY(out.write(" "sv));
+        size += TRY(codegen_value(out, gen, implementation, implementation.params[i]));
+        if (i + 1 < function.params.size()) {
+            size += TRY(out.write(", "sv));
+        }
+    }
+    size += TRY(out.write(")"sv));
+    return size;
+}
 
-    case Expr::string_literal:
-        return TRY(codegen_string_literal(out, codegen, expr.as.string_literal));
-    case Expr::number_literal:
-        return TRY(codegen_number_literal(out, codegen, expr.as.number_literal));
+static ErrorOr<u32> codegen_function_forwards(StringBuffer& out, Codegen const& gen)
+{
+    u32 size = 0;
+    for (auto const& function : gen.module.functions) {
+        size += TRY(codegen_signature(out, gen, function));
+        size += TRY(out.writeln(";"sv));
     }
+    return size;
 }
 
-static ErrorOr<u32> codegen_block(StringBuffer& out, Codegen const& codegen, Block const& block)
+static ErrorOr<u32> codegen_methods(StringBuffer& out, Codegen const& gen)
+{
+    // Virtual methods forward to the function lowered for them.
+    u32 size = 0;
+    for (u32 i = 0; i < gen.module.classes.size(); i++) {
+        auto id = IR::ClassId(i);
+        auto const& class_ = gen.module[id];
+        for (u32 slot = 0; slot < class_.methods.size(); slot++) {
+            if (!find_dispatch(gen, id, slot).has_value()) {
+                continue;
+            }
+            auto introducing = gen.module.introducing(id, slot);
+            if (introducing != id && class_.implementations[slot] == gen.module[class_.base].implementations[slot]) {
+                continue;
+            }
+            auto const& implementation = gen.module[class_.implementations[slot]];
+            bool is_void = implementation.return_type == Type::void_;
+            bool wraps_void = is_void && !implementation.may_throw && gen.module.dispatch_may_throw(introducing, slot);
+            size += TRY(out.write("\n"sv));
+            size += TRY(codegen_method_signature(out, gen, id, slot, true));
+            size += TRY(out.writeln("\n{"sv));
+            size += TRY(out.write(wraps_void ? "    "sv : "    return "sv, implementation.name, "(this"sv));
+            for (u32 j = 1; j < implementation.params.size(); j++) {
+                size += TRY(out.write(", "sv));
+                size += TRY(codegen_value(out, gen, implementation, implementation.params[j]));
+            }
+            size += TRY(out.writeln(");"sv));
+            if (wraps_void) {
+                size += TRY(out.writeln("    return {};"sv));
+            }
+            size += TRY(out.writeln("}"sv));
+        }
+    }
+    return size;
+}
+
+static ErrorOr<u32> codegen_functions(StringBuffer& out, Codegen const& gen)
+{
+    u32 size = 0;
+    for (auto const& function : gen.module.functions) {
+        size += TRY(codegen_function(out, gen, function));
+    }
+    return size;
+}
+
+static ErrorOr<u32> codegen_main(StringBuffer& out, Codegen const& gen)
 {
     u32 size = 0;
 
+    auto const& main = gen.module[gen.module.main];
+    size += TRY(out.writeln("\nErrorOr<int> Main::main(int, c_string[])"sv));
     size += TRY(out.writeln("{"sv));
-    for (auto const& expr : block.exprs.view()) {
-        size += TRY(codegen_expr(out, codegen, expr));
+    if (main.may_throw) {
+        size += TRY(out.writeln("    TRY("sv, main.name, "());"sv));
+    } else {
+        size += TRY(out.writeln("    "sv, main.name, "();"sv));
     }
+    for (auto const& function : gen.module.functions) {
+        if (function.is_async) {
+            size += TRY(out.writeln("    TRY(JS::run_microtasks());"sv));
+            break;
+        }
+    }
+    for (u32 i = 0; gen.counts_field_uses && i < gen.module.classes.size(); i++) {
+        auto const& class_ = gen.module.classes[i];
+        auto const& shape = gen.module[class_.shape];
+        auto first = class_.base.is_valid() ? gen.module[gen.module[class_.base].shape].fields.size() : 0;
+        for (u32 j = first; j < shape.fields.size(); j++) {
+            auto counter = counter_of(gen.module, IR::ClassId(i), j);
+            size += TRY(out.writeln("    TRY(Core::File::stderr().writeln(\""sv, class_.name, "."sv, shape.fields[j], " \"sv, _field_uses["sv, counter, "]));"sv));
+        }
+    }
+    size += TRY(out.writeln("    return 0;"sv));
     size += TRY(out.writeln("}"sv));
 
     return size;
 }
 
-static ErrorOr<u32> codegen_var_decl(StringBuffer&, Codegen const&, VarDecl const&)
+static ErrorOr<u32> codegen_type(StringBuffer& out, Type type, IR::ShapeId shape)
 {
-    return Error::unimplemented();
+    if (type == Type::object) {
+        return TRY(out.write("_Shape"sv, shape.raw()));
+    }
+    if (type == Type::instance) {
+        return TRY(out.write("_Shape"sv, shape.raw(), "*"sv));
+    }
+    if (type == Type::array) {
+        // Arrays carry the shape of their elements.
+        u32 size = 0;
+        size += TRY(out.write("JS::Array<"sv));
+        size += TRY(codegen_type(out, type.element_type(), shape));
+        size += TRY(out.write(">"sv));
+        return size;
+    }
+    if (type == Type::promise) {
+        u32 size = 0;
+        size += TRY(out.write("JS::Promise<"sv));
+        size += TRY(codegen_type(out, type.element_type(), shape));
+        size += TRY(out.write(">"sv));
+        return size;
+    }
+    if (type == Type::index) {
+        return TRY(out.write("u32"sv));
+    }
+    auto name = TRY(type.to_string());
+    return TRY(out.write(name.view()));
 }
 
-static ErrorOr<u32> codegen_func_decl(StringBuffer& out, Codegen const& gen, FuncDecl const& func)
+static ErrorOr<u32> codegen_field_name(StringBuffer& out, StringView field)
+{
+    if (IR::Shape::is_presence(field)) {
+        return TRY(out.write("_has_"sv, field.shrink(1)));
+    }
+    return TRY(out.write(field));
+}
+
+static ErrorOr<u32> codegen_signature(StringBuffer& out, Codegen const& gen, IR::Function const& function)
 {
     u32 size = 0;
-    auto name = func.name.view_in(gen.source.file);
-    size += TRY(out.write(name, " = []("sv));
-    for (usize i = 0; auto const& arg : func.args.view()) {
-        auto arg_type = TRY(arg.type.to_string());
-        auto arg_name = arg.name.view_in(gen.source.file);
-        size += TRY(out.write(arg_type.view(), " "sv, arg_name));
-        if (i + 1 < func.args.size()) {
+
+    if (!function.is_exported) {
+        size += TRY(out.write("static "sv));
+    }
+    if (function.is_async) {
+        // Errors reject the promise rather than being returned.
+        size += TRY(out.write("JS::Promise<"sv));
+        size += TRY(codegen_type(out, function.return_type, function.return_shape));
+        size += TRY(out.write("> "sv));
+    } else if (function.may_throw) {
+        size += TRY(out.write("ErrorOr<"sv));
+        size += TRY(codegen_type(out, function.return_type, function.return_shape));
+        size += TRY(out.write("> "sv));
+    } else {
+        size += TRY(codegen_type(out, function.return_type, function.return_shape));
+        size += TRY(out.write(" "sv));
+    }
+    size += TRY(out.write(function.name, "("sv));
+    for (u32 i = 0; i < function.params.size(); i++) {
+        auto param = function.params[i];
+        size += TRY(codegen_type(out, function[param].type, function[param].shape));
+        size += TRY(out.write(" "sv));
+        size += TRY(codegen_value(out, gen, function, param));
+        if (i + 1 < function.params.size()) {
             size += TRY(out.write(", "sv));
         }
-        i++;
     }
-    size += TRY(out.write(") -> "sv));
-    auto return_type = TRY(func.return_type.to_string());
-    size += TRY(out.write("ErrorOr<"sv, return_type.view(), "> "sv));
-    size += TRY(out.writeln("{"sv));
-    size += TRY(codegen_block(out, gen, func.block));
-    if (func.return_type.kind() == Type::void_) {
-        size += TRY(out.write("return {};"sv));
+    size += TRY(out.write(")"sv));
+
+    return size;
+}
+
+static ErrorOr<u32> codegen_function(StringBuffer& out, Codegen const& gen, IR::Function const& function)
+{
+    u32 size = 0;
+
+    size += TRY(out.writeln(""sv));
+    size += TRY(codegen_signature(out, gen, function));
+    size += TRY(out.writeln("\n{"sv));
+    size += TRY(codegen_tables(out, gen, function));
+
+    // Values live in plain locals declared up front, so jumps between
+    // blocks never cross an initialization.
+    for (u32 i = 0; i < function.insts.size(); i++) {
+        auto const& inst = function.insts[i];
+        switch (inst.kind) {
+        case IR::Inst::nop:
+        case IR::Inst::undef:
+        case IR::Inst::param:
+        case IR::Inst::constant_number:
+        case IR::Inst::constant_string:
+        case IR::Inst::constant_boolean:
+        case IR::Inst::constant_array:
+            continue;
+        default:
+            break;
+        }
+        if (inst.type == Type::none || inst.type == Type::void_) {
+            continue;
+        }
+        size += TRY(out.write("    "sv));
+        if (inst.kind == IR::Inst::match_string) {
+            // Only ever switched on, so there's no point in a JS number.
+            size += TRY(out.write("u32"sv));
+        } else {
+            size += TRY(codegen_type(out, inst.type, inst.shape));
+        }
+        size += TRY(out.write(" "sv));
+        size += TRY(codegen_value(out, gen, function, IR::Value(i)));
+        size += TRY(out.writeln(" {};"sv));
     }
-    size += TRY(out.writeln("};"sv));
+
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        auto block = IR::BlockId(i);
+        if (function[block].is_removed()) {
+            continue;
+        }
+        if (block != IR::Function::entry) {
+            size += TRY(out.writeln("_b"sv, i, ":;"sv));
+        }
+        auto const& insts = function[block].insts;
+        for (u32 j = 0; j < insts.size(); j++) {
+            if (is_tail_call(gen, function, block, j)) {
+                size += TRY(codegen_tail_call(out, gen, function, insts[j]));
+                break;
+            }
+            size += TRY(codegen_inst(out, gen, function, block, insts[j]));
+        }
+    }
+
+    size += TRY(out.writeln("}"sv));
 
     return size;
 }
 
-static ErrorOr<u32> codegen_func_call(StringBuffer& out, Codegen const& gen, FuncCall const& func_call)
+static ErrorOr<u32> codegen_tables(StringBuffer& out, Codegen const& gen, IR::Function const& function)
 {
+    // Arrays worked out at compile time are static data. Tables only hold
+    // tables made before them, so each is declared before it's used.
     u32 size = 0;
+    for (u32 i = 0; i < function.insts.size(); i++) {
+        auto const& inst = function.insts[i];
+        if (inst.kind != IR::Inst::constant_array || inst.operands.count == 0) {
+            continue;
+        }
+        if (is_columnar(gen, inst)) {
+            size += TRY(codegen_column_tables(out, gen, function, IR::Value(i)));
+            continue;
+        }
+        size += TRY(out.write("    alignas(16) static constexpr "sv));
+        size += TRY(codegen_type(out, inst.type.element_type(), inst.shape));
+        size += TRY(out.write(" _table"sv, i, "[] = { "sv));
+        auto operands = function.operands_of(IR::Value(i));
+        for (u32 j = 0; j < operands.size(); j++) {
+            size += TRY(codegen_constant(out, gen, function, operands[j]));
+            if (j + 1 < operands.size()) {
+                size += TRY(out.write(", "sv));
+            }
+        }
+        size += TRY(out.writeln(" };"sv));
+    }
+    return size;
+}
 
-    auto name = func_call.name.view_in(gen.source.file);
-    size += TRY(out.write(name, "("sv));
-    for (u32 i = 0; auto const& arg : func_call.args.view()) {
-        if (!arg.default_value) {
-            return Error::from_string_literal("expected some value for function parameter");
+static ErrorOr<u32> codegen_column_tables(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::Value value)
+{
+    // One table per field, each holding that field of every element.
+    u32 size = 0;
+    auto const& inst = function[value];
+    auto const& shape = gen.module[inst.shape];
+    auto elements = function.operands_of(value);
+    for (u32 i = 0; i < shape.fields.size(); i++) {
+        size += TRY(out.write("    alignas(16) static constexpr "sv));
+        size += TRY(codegen_type(out, shape.types[i], shape.shapes[i]));
+        size += TRY(out.write(" _table"sv, value.raw(), "_"sv, i, "[] = { "sv));
+        for (u32 j = 0; j < elements.size(); j++) {
+            if (function[elements[j]].kind != IR::Inst::object) {
+                return Error::from_string_literal("element of a columnar table is not an object");
+            }
+            size += TRY(codegen_constant(out, gen, function, function.operands_of(elements[j])[i]));
+            if (j + 1 < elements.size()) {
+                size += TRY(out.write(", "sv));
+            }
         }
-        size += TRY(codegen_rvalue_expr(out, gen, *arg.default_value));
-        if (i + 1 < func_call.args.size()) {
-            size += TRY(out.write(", "sv));
+        size += TRY(out.writeln(" };"sv));
+    }
+    return size;
+}
+
+static bool is_columnar(Codegen const& gen, IR::Inst const& inst)
+{
+    return inst.type == Type::array && inst.type.element_type() == Type::object && gen.module[inst.shape].is_columnar;
+}
+
+static ErrorOr<u32> codegen_inst(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::BlockId block, IR::Value value)
+{
+    u32 size = 0;
+    auto const& inst = function[value];
+    auto operands = function.operands_of(value);
+
+    switch (inst.kind) {
+    case IR::Inst::nop:
+    case IR::Inst::undef:
+    case IR::Inst::param:
+    case IR::Inst::phi:
+
+    case IR::Inst::constant_number:
+    case IR::Inst::constant_string:
+    case IR::Inst::constant_boolean:
+    case IR::Inst::constant_array:
+        return 0;
+
+    case IR::Inst::object:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_type(out, inst.type, inst.shape));
+        size += TRY(out.write(" { "sv));
+        for (u32 i = 0; i < operands.size(); i++) {
+            size += TRY(codegen_value(out, gen, function, operands[gen.layouts[inst.shape.raw()][i]]));
+            if (i + 1 < operands.size()) {
+                size += TRY(out.write(", "sv));
+            }
         }
+        size += TRY(out.writeln(" };"sv));
+        return size;
+
+    case IR::Inst::get_field: {
+        auto const& shape = gen.module[function[operands[0]].shape];
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.write("."sv));
+        size += TRY(codegen_field_name(out, shape.fields[inst.as.index]));
+        size += TRY(out.writeln(";"sv));
+        return size;
+    }
+
+    case IR::Inst::wrap:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_type(out, inst.type, inst.shape));
+        size += TRY(out.write(" { ._tag = "sv, inst.as.index, ", ._"sv, inst.as.index, " = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(" };"sv));
+        return size;
+
+    case IR::Inst::unwrap:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln("._"sv, inst.as.index, ";"sv));
+        return size;
+
+    case IR::Inst::get_tag:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln("._tag;"sv));
+        return size;
+
+    case IR::Inst::new_object:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.writeln(" = JS::create_object<_Shape"sv, inst.shape.raw(), ">();"sv));
+        for (auto id = gen.module.find_class(inst.shape).value(); id.is_valid(); id = gen.module[id].base) {
+            auto shape = gen.module[id].shape.raw();
+            if (has_cold_fields(gen.module[id])) {
+                size += TRY(out.write("    "sv));
+                size += TRY(codegen_value(out, gen, function, value));
+                size += TRY(out.writeln("->_cold"sv, shape, " = JS::create_object<_Cold"sv, shape, ">();"sv));
+            }
+        }
+        return size;
+
+    case IR::Inst::load_field:
+        size += TRY(codegen_count_field_use(out, gen, function[operands[0]].shape, inst.as.index));
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(codegen_field_access(out, gen, function[operands[0]].shape, inst.as.index));
+        size += TRY(out.writeln(";"sv));
+        return size;
+
+    case IR::Inst::store_field:
+        size += TRY(codegen_count_field_use(out, gen, function[operands[0]].shape, inst.as.index));
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(codegen_field_access(out, gen, function[operands[0]].shape, inst.as.index));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[1]));
+        size += TRY(out.writeln(";"sv));
+        return size;
+
+    case IR::Inst::upcast:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(";"sv));
+        return size;
+
+    case IR::Inst::free_object:
+        for (auto id = gen.module.find_class(function[operands[0]].shape).value(); id.is_valid(); id = gen.module[id].base) {
+            if (has_cold_fields(gen.module[id])) {
+                size += TRY(out.write("    JS::free_object("sv));
+                size += TRY(codegen_value(out, gen, function, operands[0]));
+                size += TRY(out.writeln("->_cold"sv, gen.module[id].shape.raw(), ");"sv));
+            }
+        }
+        size += TRY(out.write("    JS::free_object("sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(");"sv));
+        return size;
+
+    case IR::Inst::create_array:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_type(out, inst.type, inst.shape));
+        size += TRY(out.write("::create("sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(");"sv));
+        return size;
+
+    case IR::Inst::push:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.write(".push("sv));
+        size += TRY(codegen_value(out, gen, function, operands[1]));
+        size += TRY(out.writeln(");"sv));
+        return size;
+
+    case IR::Inst::length:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(".length();"sv));
+        return size;
+
+    case IR::Inst::get_element:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        if (inst.as.boolean) {
+            size += TRY(out.write(".unchecked_at("sv));
+            size += TRY(codegen_value(out, gen, function, operands[1]));
+            size += TRY(out.writeln(");"sv));
+            return size;
+        }
+        size += TRY(out.write("["sv));
+        size += TRY(codegen_value(out, gen, function, operands[1]));
+        size += TRY(out.writeln("];"sv));
+        return size;
+
+    case IR::Inst::check_length:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.write(".check_length("sv));
+        size += TRY(codegen_value(out, gen, function, operands[1]));
+        size += TRY(out.writeln(");"sv));
+        return size;
+
+    case IR::Inst::to_number:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = number("sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(");"sv));
+        return size;
+
+    case IR::Inst::to_index:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(".as_index();"sv));
+        return size;
+
+    case IR::Inst::not_:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = !"sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(";"sv));
+        return size;
+
+    case IR::Inst::add:
+        if (inst.type != Type::number && inst.type != Type::index) {
+            return Error::from_string_literal("can only add numbers");
+        }
+        return TRY(codegen_binary(out, gen, function, value, "+"sv));
+    case IR::Inst::sub:
+        return TRY(codegen_binary(out, gen, function, value, "-"sv));
+    case IR::Inst::concat:
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = JS::concat("sv));
+        size += TRY(codegen_args(out, gen, function, value));
+        size += TRY(out.writeln(");"sv));
+        return size;
+    case IR::Inst::lt:
+        return TRY(codegen_binary(out, gen, function, value, "<"sv));
+    case IR::Inst::lt_eq:
+        return TRY(codegen_binary(out, gen, function, value, "<="sv));
+    case IR::Inst::strict_eq:
+        return TRY(codegen_binary(out, gen, function, value, "=="sv));
+    case IR::Inst::match_string:
+        return TRY(codegen_match_string(out, gen, function, value));
+
+    case IR::Inst::call:
+        return TRY(codegen_call(out, gen, function, value));
+
+    case IR::Inst::call_virtual:
+        return TRY(codegen_call_virtual(out, gen, function, value));
+
+    case IR::Inst::call_method: {
+        // Member calls go straight to the runtime library, which never throws.
+        auto file = gen.module.source.file;
+        size += TRY(out.write("    "sv, inst.as.method.object.view_in(file), "->"sv, inst.as.method.member.view_in(file), "("sv));
+        size += TRY(codegen_args(out, gen, function, value));
+        size += TRY(out.writeln(");"sv));
+        return size;
     }
-    size += TRY(out.write(")"sv));
 
+    case IR::Inst::await_:
+        size += TRY(out.writeln("    {"sv));
+        size += TRY(out.write("    auto _r = co_await "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(";"sv));
+        size += TRY(codegen_co_try(out, gen, function, value));
+        return size;
+
+    case IR::Inst::jump:
+        size += TRY(codegen_edge(out, gen, function, block, inst.as.target));
+        size += TRY(out.writeln("    goto _b"sv, inst.as.target.raw(), ";"sv));
+        return size;
+
+    case IR::Inst::branch:
+        size += TRY(out.write("    if ("sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(") {"sv));
+        size += TRY(codegen_edge(out, gen, function, block, inst.as.branch.then_));
+        size += TRY(out.writeln("    goto _b"sv, inst.as.branch.then_.raw(), ";"sv));
+        size += TRY(out.writeln("    }"sv));
+        size += TRY(codegen_edge(out, gen, function, block, inst.as.branch.else_));
+        size += TRY(out.writeln("    goto _b"sv, inst.as.branch.else_.raw(), ";"sv));
+        return size;
+
+    case IR::Inst::switch_: {
+        // Dense cases from zero, which C++ compilers turn into a jump
+        // table. Tags are read straight from the union rather than going
+        // through a number.
+        auto targets = function.targets_of(value);
+        size += TRY(out.write("    switch ("sv));
+        if (function[operands[0]].kind == IR::Inst::get_tag) {
+            size += TRY(codegen_value(out, gen, function, function.operands_of(operands[0])[0]));
+            size += TRY(out.writeln("._tag) {"sv));
+        } else {
+            size += TRY(codegen_value(out, gen, function, operands[0]));
+            size += TRY(out.writeln(") {"sv));
+        }
+        for (u32 i = 1; i < targets.size(); i++) {
+            size += TRY(out.writeln("    case "sv, i - 1, ":"sv));
+            size += TRY(codegen_edge(out, gen, function, block, targets[i]));
+            size += TRY(out.writeln("    goto _b"sv, targets[i].raw(), ";"sv));
+        }
+        size += TRY(out.writeln("    default:"sv));
+        size += TRY(codegen_edge(out, gen, function, block, targets[0]));
+        size += TRY(out.writeln("    goto _b"sv, targets[0].raw(), ";"sv));
+        size += TRY(out.writeln("    }"sv));
+        return size;
+    }
+
+    case IR::Inst::ret:
+        if (function.is_async && operands.size() == 0) {
+            return TRY(out.writeln("    co_return {};"sv));
+        }
+        if (operands.size() == 0) {
+            return TRY(out.writeln(function.may_throw ? "    return {};"sv : "    return;"sv));
+        }
+        size += TRY(out.write(function.is_async ? "    co_return "sv : "    return "sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(";"sv));
+        return size;
+
+    case IR::Inst::throw_:
+        size += TRY(out.write(function.is_async ? "    co_return Error::from_string_literal("sv : "    return Error::from_string_literal("sv));
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.writeln(".data());"sv));
+        return size;
+    }
+}
+
+static ErrorOr<u32> codegen_binary(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::Value value, StringView op)
+{
+    u32 size = 0;
+    auto operands = function.operands_of(value);
+    size += TRY(out.write("    "sv));
+    size += TRY(codegen_value(out, gen, function, value));
+    size += TRY(out.write(" = "sv));
+    size += TRY(codegen_value(out, gen, function, operands[0]));
+    size += TRY(out.write(" "sv, op, " "sv));
+    size += TRY(codegen_value(out, gen, function, operands[1]));
+    size += TRY(out.writeln(";"sv));
     return size;
 }
 
-static ErrorOr<u32> codegen_if_stmt(StringBuffer& out, Codegen const& gen, IfStmt const& stmt)
+static ErrorOr<u32> codegen_match_string(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::Value value)
 {
+    // Every slot of the hash table holds the only string that could land
+    // there and which one it is, so one compare tells whether it's a hit.
     u32 size = 0;
+    auto operand = function.operands_of(value)[0];
+    auto strings = function.strings_of(value);
+    auto hash = function[value].as.strings;
+    auto slots = TRY(Vector<u32>::create(1U << hash.bits));
+    for (u32 i = 0; i < (1U << hash.bits); i++) {
+        TRY(slots.append(strings.size()));
+    }
+    for (u32 i = 0; i < strings.size(); i++) {
+        slots[IR::hash_slot(strings[i], hash.seed, hash.bits)] = i;
+    }
 
-    size += TRY(out.write("if ("sv));
-    size += TRY(codegen_expr(out, gen, stmt.cond.value));
-    size += TRY(out.writeln(")"sv));
-    size += TRY(codegen_expr(out, gen, stmt.then));
+    size += TRY(out.writeln("    {"sv));
+    size += TRY(out.write("        static constexpr StringView strings[] = {"sv));
+    for (auto slot : slots.view()) {
+        size += TRY(out.write(" "sv));
+        if (slot < strings.size()) {
+            size += TRY(codegen_string(out, gen, strings[slot]));
+        } else {
+            size += TRY(out.write("{}"sv));
+        }
+        size += TRY(out.write(","sv));
+    }
+    size += TRY(out.writeln(" };"sv));
+    size += TRY(out.write("        static constexpr "sv, strings.size() < 256 ? "u8"sv : "u32"sv, " cases[] = {"sv));
+    for (auto slot : slots.view()) {
+        size += TRY(out.write(" "sv, slot, ","sv));
+    }
+    size += TRY(out.writeln(" };"sv));
+    size += TRY(out.write("        auto slot = (JS::hash("sv));
+    size += TRY(codegen_value(out, gen, function, operand));
+    size += TRY(out.writeln(") * "sv, IR::hash_multiplier(hash.seed), "ULL) >> "sv, 64 - hash.bits, ";"sv));
+    size += TRY(out.write("        "sv));
+    size += TRY(codegen_value(out, gen, function, value));
+    size += TRY(out.write(" = "sv));
+    size += TRY(codegen_value(out, gen, function, operand));
+    size += TRY(out.writeln(" == strings[slot] ? cases[slot] : "sv, strings.size(), ";"sv));
+    size += TRY(out.writeln("    }"sv));
+    return size;
+}
+
+static ErrorOr<u32> codegen_call(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::Value value)
+{
+    u32 size = 0;
+    auto const& inst = function[value];
+    auto const& callee = gen.module[inst.as.callee];
+    bool may_throw = callee.may_throw && !callee.is_async;
+
+    // TRY returns, which coroutines can't do.
+    if (may_throw && function.is_async) {
+        size += TRY(out.writeln("    {"sv));
+        size += TRY(out.write("    auto _r = "sv, callee.name, "("sv));
+        size += TRY(codegen_args(out, gen, function, value));
+        size += TRY(out.writeln(");"sv));
+        size += TRY(codegen_co_try(out, gen, function, value));
+        return size;
+    }
+
+    size += TRY(out.write("    "sv));
+    if (inst.type != Type::void_) {
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+    }
+    if (may_throw) {
+        size += TRY(out.write("TRY("sv));
+    }
+    size += TRY(out.write(callee.name, "("sv));
+    size += TRY(codegen_args(out, gen, function, value));
+    size += TRY(out.write(")"sv));
+    if (may_throw) {
+        size += TRY(out.write(")"sv));
+    }
+    size += TRY(out.writeln(";"sv));
 
     return size;
 }
 
-static ErrorOr<u32> codegen_throw_stmt(StringBuffer& out, Codegen const& gen, ThrowStmt const& stmt)
+static ErrorOr<u32> codegen_call_virtual(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::Value value)
 {
     u32 size = 0;
+    auto const& inst = function[value];
+    auto operands = function.operands_of(value);
+    auto class_ = gen.module.find_class(function[operands[0]].shape).value();
+    auto introducing = gen.module.introducing(class_, inst.as.index);
+    auto const& callee = gen.module[gen.module[introducing].implementations[inst.as.index]];
+    bool may_throw = !callee.is_async && gen.module.dispatch_may_throw(introducing, inst.as.index);
 
-    auto const& expr = stmt.value.value;
-    size += TRY(out.write("return Error::from_string_literal("sv));
-    size += TRY(codegen_expr(out, gen, expr));
-    size += TRY(out.write(".data()"sv));
-    size += TRY(out.writeln(");"sv));
+    auto call = [&]() -> ErrorOr<u32> {
+        u32 size = 0;
+        size += TRY(codegen_value(out, gen, function, operands[0]));
+        size += TRY(out.write("->"sv, gen.module[class_].methods[inst.as.index], "("sv));
+        for (u32 i = 1; i < operands.size(); i++) {
+            size += TRY(codegen_value(out, gen, function, operands[i]));
+            if (i + 1 < operands.size()) {
+                size += TRY(out.write(", "sv));
+            }
+        }
+        size += TRY(out.write(")"sv));
+        return size;
+    };
+
+    if (may_throw && function.is_async) {
+        size += TRY(out.writeln("    {"sv));
+        size += TRY(out.write("    auto _r = "sv));
+        size += TRY(call());
+        size += TRY(out.writeln(";"sv));
+        size += TRY(codegen_co_try(out, gen, function, value));
+        return size;
+    }
 
+    size += TRY(out.write("    "sv));
+    if (inst.type != Type::void_) {
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.write(" = "sv));
+    }
+    size += TRY(out.write(may_throw ? "TRY("sv : ""sv));
+    size += TRY(call());
+    size += TRY(out.writeln(may_throw ? ");"sv : ";"sv));
     return size;
 }
 
-static ErrorOr<u32> codegen_return_stmt(StringBuffer&, Codegen const&, ReturnStmt const&)
+static ErrorOr<u32> codegen_co_try(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::Value value)
 {
-    return Error::unimplemented();
+    // Finishes the block opened for the result _r of a call or an await,
+    // rejecting the current promise with its error if it has one.
+    u32 size = 0;
+    size += TRY(out.writeln("    if (_r.is_error())"sv));
+    size += TRY(out.writeln("        co_return _r.release_error();"sv));
+    if (function[value].type != Type::void_) {
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, value));
+        size += TRY(out.writeln(" = _r.release_value();"sv));
+    }
+    size += TRY(out.writeln("    }"sv));
+    return size;
 }
 
-static ErrorOr<u32> codegen_unary_expr(StringBuffer& out, Codegen const& gen, UnaryExpr const& expr)
+static ErrorOr<u32> codegen_tail_call(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::Value value)
 {
     u32 size = 0;
-    auto op = expr.op.view_in(gen.source.file);
-    size += TRY(out.write(op));
-    size += TRY(codegen_expr(out, gen, expr.value.value));
+    size += TRY(out.write("    [[clang::musttail]] return "sv, gen.module[function[value].as.callee].name, "("sv));
+    size += TRY(codegen_args(out, gen, function, value));
+    size += TRY(out.writeln(");"sv));
     return size;
 }
 
-static ErrorOr<u32> codegen_binary_expr(StringBuffer&, Codegen const&, BinaryExpr const&)
+static bool is_tail_call(Codegen const& gen, IR::Function const& function, IR::BlockId block, u32 index)
 {
-    return Error::unimplemented();
+    // Returning what a call returns can reuse the caller's frame, but only
+    // when both sides agree on how arguments and results are passed.
+    auto const& insts = function[block].insts;
+    if (index + 2 != insts.size()) {
+        return false;
+    }
+    auto const& call = function[insts[index]];
+    auto ret = insts[index + 1];
+    if (call.kind != IR::Inst::call || function[ret].kind != IR::Inst::ret) {
+        return false;
+    }
+    if (function.is_async || gen.module[call.as.callee].is_async) {
+        return false;
+    }
+    auto returned = function.operands_of(ret);
+    if (returned.size() != 0 && returned[0] != insts[index]) {
+        return false;
+    }
+    return has_same_signature(function, gen.module[call.as.callee]);
+}
+
+static bool has_same_signature(IR::Function const& a, IR::Function const& b)
+{
+    if (a.may_throw != b.may_throw || !a.return_type.is_same(b.return_type) || a.return_shape != b.return_shape) {
+        return false;
+    }
+    if (a.params.size() != b.params.size()) {
+        return false;
+    }
+    for (u32 i = 0; i < a.params.size(); i++) {
+        auto const& x = a[a.params[i]];
+        auto const& y = b[b.params[i]];
+        if (!x.type.is_same(y.type) || x.shape != y.shape) {
+            return false;
+        }
+    }
+    return true;
 }
 
-static ErrorOr<u32> codegen_dot_expr(StringBuffer& out, Codegen const& gen, DotExpr const& expr)
+static ErrorOr<u32> codegen_edge(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::BlockId from, IR::BlockId to)
 {
     u32 size = 0;
+    auto const& target = function[to];
+    if (target.phis.is_empty()) {
+        return 0;
+    }
 
-    size += TRY(out.write("("sv));
-    size += TRY(out.write(expr.lhs.view_in(gen.source.file)));
-    size += TRY(out.write("->"sv));
-    size += TRY(codegen_rvalue_expr(out, gen, expr.rhs));
-    size += TRY(out.write(")"sv));
+    auto pred = TRY(target.preds.find(from).or_throw([] {
+        return Error::from_string_literal("jump to block that does not list its predecessor");
+    }));
 
+    // Phis read their operands all at once, so copy through temporaries
+    // when one phi may feed another.
+    if (target.phis.size() == 1) {
+        auto phi = target.phis[0];
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, phi));
+        size += TRY(out.write(" = "sv));
+        size += TRY(codegen_value(out, gen, function, function.operands_of(phi)[pred.raw()]));
+        size += TRY(out.writeln(";"sv));
+        return size;
+    }
+
+    size += TRY(out.writeln("    {"sv));
+    for (auto phi : target.phis.view()) {
+        size += TRY(out.write("    auto _t"sv, phi.raw(), " = "sv));
+        size += TRY(codegen_value(out, gen, function, function.operands_of(phi)[pred.raw()]));
+        size += TRY(out.writeln(";"sv));
+    }
+    for (auto phi : target.phis.view()) {
+        size += TRY(out.write("    "sv));
+        size += TRY(codegen_value(out, gen, function, phi));
+        size += TRY(out.writeln(" = _t"sv, phi.raw(), ";"sv));
+    }
+    size += TRY(out.writeln("    }"sv));
     return size;
 }
 
-static ErrorOr<u32> codegen_lvalue_expr(StringBuffer& out, Codegen const& gen, Token token)
+static ErrorOr<u32> codegen_args(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::Value value)
 {
-    return TRY(out.write(token.view_in(gen.source.file)));
+    u32 size = 0;
+    auto operands = function.operands_of(value);
+    for (u32 i = 0; i < operands.size(); i++) {
+        size += TRY(codegen_value(out, gen, function, operands[i]));
+        if (i + 1 < operands.size()) {
+            size += TRY(out.write(", "sv));
+        }
+    }
+    return size;
 }
 
-static ErrorOr<u32> codegen_rvalue_expr(StringBuffer& out, Codegen const& gen, RValue const& rvalue)
+static ErrorOr<u32> codegen_value(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::Value value)
 {
+    // Constants are written out where they're used so the C++ compiler
+    // sees them directly.
+    auto const& inst = function[value];
+    switch (inst.kind) {
+    case IR::Inst::constant_number: {
+        if (inst.type == Type::index) {
+            return TRY(codegen_number(out, inst.as.number));
+        }
+        u32 size = 0;
+        size += TRY(out.write("number("sv));
+        size += TRY(codegen_number(out, inst.as.number));
+        size += TRY(out.write(")"sv));
+        return size;
+    }
+    case IR::Inst::constant_string:
+        return TRY(codegen_string(out, gen, inst.as.string));
+    case IR::Inst::constant_boolean:
+        return TRY(out.write(inst.as.boolean ? "true"sv : "false"sv));
+    case IR::Inst::constant_array: {
+        u32 size = 0;
+        size += TRY(codegen_type(out, inst.type, inst.shape));
+        if (inst.operands.count == 0) {
+            size += TRY(out.write("()"sv));
+            return size;
+        }
+        if (is_columnar(gen, inst)) {
+            size += TRY(out.write("::constant("sv));
+            for (u32 i = 0; i < gen.module[inst.shape].fields.size(); i++) {
+                size += TRY(out.write("_table"sv, value.raw(), "_"sv, i, ", "sv));
+            }
+            size += TRY(out.write(inst.operands.count, ")"sv));
+            return size;
+        }
+        size += TRY(out.write("::constant(_table"sv, value.raw(), ", "sv, inst.operands.count, ")"sv));
+        return size;
+    }
+    case IR::Inst::undef: {
+        if (inst.type == Type::instance) {
+            return TRY(out.write("nullptr"sv));
+        }
+        u32 size = 0;
+        size += TRY(codegen_type(out, inst.type, inst.shape));
+        size += TRY(out.write(" {}"sv));
+        return size;
+    }
+    default:
+        return TRY(out.write("_"sv, value.raw()));
+    }
+}
+
+static ErrorOr<u32> codegen_constant(StringBuffer& out, Codegen const& gen, IR::Function const& function, IR::Value value)
+{
+    // Objects in tables are written out whole, since tables can't refer to
+    // locals.
+    auto const& inst = function[value];
+    if (inst.kind != IR::Inst::object) {
+        return TRY(codegen_value(out, gen, function, value));
+    }
     u32 size = 0;
-    size += TRY(codegen_expr(out, gen, rvalue.value));
+    size += TRY(codegen_type(out, inst.type, inst.shape));
+    size += TRY(out.write(" { "sv));
+    auto operands = function.operands_of(value);
+    for (u32 i = 0; i < operands.size(); i++) {
+        size += TRY(codegen_constant(out, gen, function, operands[gen.layouts[inst.shape.raw()][i]]));
+        if (i + 1 < operands.size()) {
+            size += TRY(out.write(", "sv));
+        }
+    }
+    size += TRY(out.write(" }"sv));
     return size;
 }
 
-static ErrorOr<u32> codegen_string_literal(StringBuffer& out, Codegen const& gen, Token token)
+static ErrorOr<u32> codegen_string(StringBuffer& out, Codegen const& gen, StringView string)
 {
-    // FIXME: Off by one
-    return TRY(out.write(token.view_in(gen.source.file), "\"sv"sv));
+    auto index = TRY(gen.strings.find(string).or_throw([] {
+        return Error::unreachable();
+    }));
+    return TRY(out.write("_strings["sv, index.raw(), "]"sv));
 }
 
-static ErrorOr<u32> codegen_number_literal(StringBuffer&, Codegen const&, Token)
+static ErrorOr<u32> codegen_number(StringBuffer& out, f64 number)
 {
-    return Error::unimplemented();
+    // Whole numbers are written out exactly, everything else with enough
+    // digits to round-trip.
+    if (number >= -9007199254740992.0 && number <= 9007199254740992.0 && number == (f64)(i64)number) {
+        return TRY(out.write((i64)number));
+    }
+    char buffer[32];
+    auto length = __builtin_snprintf(buffer, sizeof(buffer), "%.17g", number);
+    return TRY(out.write(StringView(buffer, length)));
 }
@@ -1,4 +1,6 @@
 #pragma once
-#include "./Parse.h"
+#include "./IR.h"
 
-ErrorOr<StringBuffer> codegen(Source, ParseTree const&);
+// Programs that count field uses print how often each field of each class
+// was read or written when they exit, which --field-profile reads back.
+ErrorOr<StringBuffer> codegen(IR::Module const&, bool count_field_uses = false);
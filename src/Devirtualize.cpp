@@ -0,0 +1,89 @@
+#include "./Passes.h"
+
+using IR::FunctionId;
+using IR::Inst;
+using IR::Value;
+
+static ErrorOr<bool> devirtualize_calls(IR::Module const&, IR::Function&);
+static ErrorOr<FunctionId> find_target(IR::Module const&, IR::Function const&, Value call);
+static Value strip_upcasts(IR::Function const&, Value);
+
+ErrorOr<bool> devirtualize_calls(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(devirtualize_calls(module, function));
+    }
+    return changed;
+}
+
+static ErrorOr<bool> devirtualize_calls(IR::Module const& module, IR::Function& function)
+{
+    // Virtual calls that can only reach one function become plain calls,
+    // which can then be inlined like any other.
+    bool changed = false;
+    for (auto& block : function.blocks) {
+        auto insts = Vector<Value>();
+        for (auto value : block.insts.view()) {
+            if (function[value].kind != Inst::call_virtual) {
+                TRY(insts.append(value));
+                continue;
+            }
+            auto target = TRY(find_target(module, function, value));
+            if (!target.is_valid()) {
+                TRY(insts.append(value));
+                continue;
+            }
+
+            // The method may be inherited, taking the base class it was
+            // declared in.
+            auto receiver = function.operands_of(value)[0];
+            auto const& param = module[target][module[target].params[0]];
+            if (function[receiver].shape != param.shape) {
+                auto root = strip_upcasts(function, receiver);
+                receiver = function[root].shape == param.shape ? root : TRY(function.create_value(Inst {
+                    .kind = Inst::upcast,
+                    .type = Type::instance,
+                    .shape = param.shape,
+                    .operands = TRY(function.create_operands(View(&root, 1))),
+                }));
+                if (receiver != root) {
+                    TRY(insts.append(receiver));
+                }
+            }
+            function.operands_of(value)[0] = receiver;
+            function[value].kind = Inst::call;
+            function[value].as.callee = target;
+            TRY(insts.append(value));
+            changed = true;
+        }
+        block.insts = move(insts);
+    }
+    return changed;
+}
+
+static ErrorOr<FunctionId> find_target(IR::Module const& module, IR::Function const& function, Value call)
+{
+    // Either nothing below the receiver's class overrides the method, or
+    // the receiver was just created and its exact class is known.
+    auto slot = function[call].as.index;
+    auto receiver = function.operands_of(call)[0];
+    auto class_ = module.find_class(function[receiver].shape).value();
+    auto implementations = TRY(module.implementations(class_, slot));
+    if (implementations.size() == 1) {
+        return implementations[0];
+    }
+    auto root = strip_upcasts(function, receiver);
+    if (function[root].kind != Inst::new_object) {
+        return FunctionId();
+    }
+    return module[module.find_class(function[root].shape).value()].implementations[slot];
+}
+
+static Value strip_upcasts(IR::Function const& function, Value value)
+{
+    while (function[value].kind == Inst::upcast) {
+        value = function.operands_of(value)[0];
+    }
+    return value;
+}
@@ -0,0 +1,224 @@
+#include "./Passes.h"
+
+using IR::BlockId;
+using IR::Inst;
+using IR::Value;
+
+// Fewer compares than this are cheaper than hashing.
+static constexpr u32 min_cases = 3;
+
+// Limits on the search for a perfect hash, tables get at most this many
+// times more slots than there are strings.
+static constexpr u32 max_load_factor = 32;
+static constexpr u32 max_seeds = 256;
+
+struct StringTest {
+    Value subject;
+    StringView string;
+    BlockId then_;
+    BlockId else_;
+};
+
+struct PerfectHash {
+    u32 seed;
+    u32 bits;
+};
+
+static ErrorOr<bool> form_string_switches(IR::Function&);
+static ErrorOr<bool> form_string_switch(IR::Function&, View<u32 const> uses, BlockId head);
+static Optional<StringTest> match_string_test(IR::Function const&, View<u32 const> uses, BlockId);
+static bool is_only_test(IR::Function const&, View<u32 const> uses, BlockId);
+static ErrorOr<Optional<PerfectHash>> find_perfect_hash(View<StringView const>);
+
+ErrorOr<bool> form_string_switches(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(form_string_switches(function));
+    }
+    return changed;
+}
+
+static ErrorOr<bool> form_string_switches(IR::Function& function)
+{
+    // Both `switch` on a string and `if (s === "a") ... if (s === "b")`
+    // come out of lowering as a chain of blocks each comparing the same
+    // string against one more literal. Such chains become a single
+    // switch on which of the literals the string is.
+    bool changed = false;
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        auto uses = TRY(function.count_uses());
+        changed |= TRY(form_string_switch(function, uses.view(), BlockId(i)));
+    }
+    return changed;
+}
+
+static ErrorOr<bool> form_string_switch(IR::Function& function, View<u32 const> uses, BlockId head)
+{
+    auto first = match_string_test(function, uses, head);
+    if (!first.has_value()) {
+        return false;
+    }
+    auto subject = first->subject;
+
+    // chain[i] is the block running tests[i].
+    auto tests = Vector<StringTest>();
+    auto chain = Vector<BlockId>();
+    auto strings = Vector<StringView>();
+    TRY(tests.append(first.value()));
+    TRY(chain.append(head));
+    TRY(strings.append(first->string));
+    for (;;) {
+        auto next = tests.last().else_;
+        auto const& block = function[next];
+        if (chain.find(next).has_value() || block.preds.size() != 1 || block.preds[0] != chain.last()) {
+            break;
+        }
+        auto test = match_string_test(function, uses, next);
+        if (!test.has_value() || test->subject != subject || !is_only_test(function, uses, next)) {
+            break;
+        }
+        if (strings.find(test->string).has_value()) {
+            break;
+        }
+        TRY(tests.append(test.value()));
+        TRY(chain.append(next));
+        TRY(strings.append(test->string));
+    }
+    for (auto const& test : tests.view()) {
+        if (chain.find(test.then_).has_value()) {
+            return false;
+        }
+    }
+    if (tests.size() < min_cases) {
+        return false;
+    }
+    auto hash = TRY(find_perfect_hash(strings.view()));
+    if (!hash.has_value()) {
+        return false;
+    }
+
+    // Every edge leaving the chain now leaves from the head, and the
+    // tests after the first are left without predecessors.
+    auto targets = Vector<BlockId>();
+    auto sources = Vector<BlockId>();
+    TRY(targets.append(tests.last().else_));
+    TRY(sources.append(chain.last()));
+    for (u32 i = 0; i < tests.size(); i++) {
+        TRY(targets.append(tests[i].then_));
+        TRY(sources.append(chain[i]));
+    }
+    for (u32 i = 0; i < targets.size(); i++) {
+        for (auto& pred : function[targets[i]].preds) {
+            if (pred == sources[i]) {
+                pred = head;
+                break;
+            }
+        }
+    }
+    for (u32 i = 1; i < chain.size(); i++) {
+        function[chain[i]].preds.clear();
+    }
+
+    auto terminator = function[head].terminator();
+    auto compare = function.operands_of(terminator)[0];
+    function[compare] = Inst {
+        .kind = Inst::match_string,
+        .type = Type::number,
+        .operands = TRY(function.create_operands(View(&subject, 1))),
+        .as = { .strings = TRY(function.create_strings(strings.view(), hash->seed, hash->bits)) },
+    };
+    function[terminator] = Inst {
+        .kind = Inst::switch_,
+        .type = Type::void_,
+        .operands = function[terminator].operands,
+        .as = { .switch_ = TRY(function.create_targets(targets.view())) },
+    };
+    return true;
+}
+
+static Optional<StringTest> match_string_test(IR::Function const& function, View<u32 const> uses, BlockId block)
+{
+    // A block ending in `if (subject === "literal")`.
+    auto const& insts = function[block].insts;
+    if (insts.is_empty()) {
+        return {};
+    }
+    auto const& terminator = function[insts.last()];
+    if (terminator.kind != Inst::branch) {
+        return {};
+    }
+    auto compare = function.operands_of(insts.last())[0];
+    if (function[compare].kind != Inst::strict_eq || uses[compare.raw()] != 1) {
+        return {};
+    }
+    auto operands = function.operands_of(compare);
+    auto subject = operands[0];
+    auto literal = operands[1];
+    if (function[subject].kind == Inst::constant_string) {
+        subject = operands[1];
+        literal = operands[0];
+    }
+    if (function[literal].kind != Inst::constant_string || function[subject].type != Type::string) {
+        return {};
+    }
+    return StringTest {
+        .subject = subject,
+        .string = function[literal].as.string,
+        .then_ = terminator.as.branch.then_,
+        .else_ = terminator.as.branch.else_,
+    };
+}
+
+static bool is_only_test(IR::Function const& function, View<u32 const> uses, BlockId block)
+{
+    // Tests after the first are skipped by the switch, so they can't do
+    // anything anyone else could see.
+    auto const& insts = function[block].insts;
+    if (!function[block].phis.is_empty()) {
+        return false;
+    }
+    auto compare = function.operands_of(insts.last())[0];
+    for (auto value : insts.view()) {
+        if (value == compare || value == insts.last()) {
+            continue;
+        }
+        if (function[value].kind != Inst::constant_string || uses[value.raw()] != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static ErrorOr<Optional<PerfectHash>> find_perfect_hash(View<StringView const> strings)
+{
+    u32 bits = 1;
+    while ((1U << bits) < strings.size()) {
+        bits++;
+    }
+    auto is_taken = Vector<bool>();
+    for (; (1U << bits) <= strings.size() * max_load_factor; bits++) {
+        for (u32 seed = 0; seed < max_seeds; seed++) {
+            is_taken.clear();
+            for (u32 i = 0; i < (1U << bits); i++) {
+                TRY(is_taken.append(false));
+            }
+            bool is_perfect = true;
+            for (auto string : strings) {
+                auto slot = IR::hash_slot(string, seed, bits);
+                if (is_taken[slot]) {
+                    is_perfect = false;
+                    break;
+                }
+                is_taken[slot] = true;
+            }
+            if (is_perfect) {
+                return Optional<PerfectHash>(PerfectHash {
+                    .seed = seed,
+                    .bits = bits,
+                });
+            }
+        }
+    }
+    return Optional<PerfectHash>();
+}
@@ -0,0 +1,187 @@
+#include "./Passes.h"
+
+using IR::Inst;
+using IR::Value;
+
+struct FieldPhi {
+    Value phi;
+    u32 field;
+    Value value;
+};
+
+static ErrorOr<bool> scalar_replace_objects(IR::Module const&, IR::Function&);
+static ErrorOr<Vector<bool>> find_escaping(IR::Function const&);
+static ErrorOr<Vector<bool>> find_read_phis(IR::Function const&);
+static Value field_value(IR::Function const&, View<FieldPhi const>, Value object, u32 field);
+
+ErrorOr<bool> scalar_replace_objects(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(scalar_replace_objects(module, function));
+    }
+    return changed;
+}
+
+static ErrorOr<bool> scalar_replace_objects(IR::Module const& module, IR::Function& function)
+{
+    auto escapes = TRY(find_escaping(function));
+    auto is_read = TRY(find_read_phis(function));
+
+    // Objects merged by a phi are split into one phi per field, so each
+    // field can be followed on its own.
+    auto field_phis = Vector<FieldPhi>();
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        auto block = IR::BlockId(i);
+        auto phi_count = function[block].phis.size();
+        for (u32 j = 0; j < phi_count; j++) {
+            auto phi = function[block].phis[j];
+            if (function[phi].type != Type::object || escapes[phi.raw()] || !is_read[phi.raw()]) {
+                continue;
+            }
+            auto const& shape = module[function[phi].shape];
+            for (u32 field = 0; field < shape.fields.size(); field++) {
+                auto value = TRY(function.create_value(Inst {
+                    .kind = Inst::phi,
+                    .type = shape.types[field],
+                    .shape = shape.shapes[field],
+                }));
+                TRY(function[block].phis.append(value));
+                TRY(field_phis.append(FieldPhi {
+                    .phi = phi,
+                    .field = field,
+                    .value = value,
+                }));
+            }
+        }
+    }
+    for (auto const& field_phi : field_phis.view()) {
+        auto operands = Vector<Value>();
+        for (auto operand : function.operands_of(field_phi.phi)) {
+            TRY(operands.append(field_value(function, field_phis.view(), operand, field_phi.field)));
+        }
+        function[field_phi.value].operands = TRY(function.create_operands(operands.view()));
+    }
+
+    // Reading a field of an object that never escapes is just reading the
+    // value it was created with. The object itself is then left unused
+    // and dead value elimination takes care of it.
+    bool changed = !field_phis.is_empty();
+    for (auto const& block : function.blocks) {
+        for (auto value : block.insts.view()) {
+            if (function[value].kind != Inst::get_field) {
+                continue;
+            }
+            auto object = function.operands_of(value)[0];
+            if (escapes[object.raw()]) {
+                continue;
+            }
+            auto field = field_value(function, field_phis.view(), object, function[value].as.index);
+            function.replace_all_uses(value, field);
+            function[value] = Inst {};
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static ErrorOr<Vector<bool>> find_escaping(IR::Function const& function)
+{
+    // An object escapes when it is used for anything but reading its
+    // fields or being merged by a phi that doesn't escape either. Only
+    // object literals and phis of them can be taken apart.
+    auto escapes = TRY(Vector<bool>::create(function.insts.size()));
+    for (auto const& inst : function.insts) {
+        TRY(escapes.append(inst.kind != Inst::object && inst.kind != Inst::phi));
+    }
+
+    auto mark_operands = [&](Value user) {
+        auto const& inst = function[user];
+        auto operands = function.operands_of(user);
+        for (u32 i = 0; i < operands.size(); i++) {
+            if (inst.kind == Inst::get_field && i == 0) {
+                continue;
+            }
+            if (inst.kind == Inst::phi && !escapes[user.raw()]) {
+                continue;
+            }
+            escapes[operands[i].raw()] = true;
+        }
+    };
+
+    for (bool changed = true; changed;) {
+        auto before = 0;
+        for (auto escaping : escapes.view()) {
+            before += escaping;
+        }
+        for (auto const& block : function.blocks) {
+            for (auto phi : block.phis.view()) {
+                if (function[phi].type != Type::object) {
+                    escapes[phi.raw()] = true;
+                }
+                for (auto operand : function.operands_of(phi)) {
+                    if (escapes[operand.raw()] && function[phi].type == Type::object) {
+                        escapes[phi.raw()] = true;
+                    }
+                }
+                mark_operands(phi);
+            }
+            for (auto value : block.insts.view()) {
+                mark_operands(value);
+            }
+        }
+        auto after = 0;
+        for (auto escaping : escapes.view()) {
+            after += escaping;
+        }
+        changed = before != after;
+    }
+    return escapes;
+}
+
+static ErrorOr<Vector<bool>> find_read_phis(IR::Function const& function)
+{
+    // Only phis whose fields are actually read, directly or through other
+    // phis, are worth splitting.
+    auto is_read = TRY(Vector<bool>::create(function.insts.size()));
+    for (u32 i = 0; i < function.insts.size(); i++) {
+        TRY(is_read.append(false));
+    }
+    for (auto const& block : function.blocks) {
+        for (auto value : block.insts.view()) {
+            if (function[value].kind == Inst::get_field) {
+                is_read[function.operands_of(value)[0].raw()] = true;
+            }
+        }
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto const& block : function.blocks) {
+            for (auto phi : block.phis.view()) {
+                if (!is_read[phi.raw()]) {
+                    continue;
+                }
+                for (auto operand : function.operands_of(phi)) {
+                    if (!is_read[operand.raw()]) {
+                        is_read[operand.raw()] = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+    return is_read;
+}
+
+static Value field_value(IR::Function const& function, View<FieldPhi const> field_phis, Value object, u32 field)
+{
+    if (function[object].kind == Inst::object) {
+        return function.operands_of(object)[field];
+    }
+    for (auto const& field_phi : field_phis) {
+        if (field_phi.phi == object && field_phi.field == field) {
+            return field_phi.value;
+        }
+    }
+    UNREACHABLE();
+}
@@ -0,0 +1,738 @@
+#include "./Passes.h"
+
+#include <JS/Number.h>
+
+using IR::BlockId;
+using IR::Inst;
+using IR::Value;
+
+// Past these an initializer is left to run when the program starts.
+static constexpr u32 max_steps = 1 << 22;
+static constexpr u32 max_depth = 256;
+static constexpr u32 max_slots = 1 << 20;
+static constexpr u32 max_table_size = 1 << 16;
+static constexpr u32 max_trivial_phis = 64;
+
+// A value worked out at compile time. Elements of arrays and fields of
+// objects live in the evaluator's slots. An array gets as many slots as
+// create_array asked room for, and push fills them in place, sharing
+// storage the way it does at runtime.
+struct Known {
+    Type::Kind kind { Type::none };
+    bool boolean { false };
+    f64 number { 0.0 };
+    StringView string {};
+    u32 start { 0 };
+    u32 length { 0 };
+    u32 capacity { 0 };
+};
+
+struct Evaluator {
+    IR::Module const& module;
+    Vector<Known> slots {};
+    u32 steps { 0 };
+    u32 depth { 0 };
+};
+
+struct Frame {
+    IR::Function const& function;
+    Vector<Known> values {};
+};
+
+struct Table {
+    Known known;
+    Value value;
+};
+
+static ErrorOr<bool> evaluate_initializer(IR::Module&, Vector<IR::Initializer>&, u32 index);
+static ErrorOr<Frame> create_frame(IR::Function const&);
+static ErrorOr<bool> run(Evaluator&, Frame&, BlockId, u32 index, IR::Initializer const*, Known& result);
+static ErrorOr<bool> enter(Evaluator&, Frame&, BlockId, BlockId from);
+static ErrorOr<bool> evaluate_inst(Evaluator&, Frame&, Value);
+static ErrorOr<bool> evaluate_call(Evaluator&, Frame&, Value);
+static ErrorOr<Known> get(Evaluator&, Frame&, Value);
+static ErrorOr<Value> passed_along(IR::Function const&, View<bool const> in_region, Value);
+static ErrorOr<Known> allocate(Evaluator&, Type::Kind, u32 capacity);
+static ErrorOr<Value> materialize(IR::Module const&, IR::Function&, Evaluator const&, Known, Type, IR::ShapeId, Vector<Value>& insts, Vector<Table>&);
+static ErrorOr<void> replace_region(IR::Function&, Vector<IR::Initializer>&, u32 index, View<Value const> insts);
+static bool is_in_region(IR::Initializer const&, BlockId, u32 index);
+
+ErrorOr<bool> evaluate_initializers(IR::Module& module)
+{
+    // The recorded positions only hold for the code as it was lowered, so
+    // this is done once, before any other pass.
+    auto initializers = move(module.initializers);
+    module.initializers = Vector<IR::Initializer>();
+    bool changed = false;
+    for (u32 i = 0; i < initializers.size(); i++) {
+        changed |= TRY(evaluate_initializer(module, initializers, i));
+    }
+    return changed;
+}
+
+static ErrorOr<bool> evaluate_initializer(IR::Module& module, Vector<IR::Initializer>& initializers, u32 index)
+{
+    // Top-level constants that don't depend on anything happening at
+    // runtime are computed here, and the code computing them is replaced
+    // by what it computed. Anything with a side effect or that fails
+    // leaves the initializer as it was.
+    auto initializer = initializers[index];
+    auto& main = module[module.main];
+    auto evaluator = Evaluator { module };
+    auto frame = TRY(create_frame(main));
+    auto result = Known();
+    if (!TRY(run(evaluator, frame, initializer.start, initializer.start_index, &initializer, result))) {
+        return false;
+    }
+
+    auto in_region = TRY(Vector<bool>::create(main.insts.size()));
+    for (u32 i = 0; i < main.insts.size(); i++) {
+        TRY(in_region.append(false));
+    }
+    for (u32 i = 0; i < main.blocks.size(); i++) {
+        auto block = BlockId(i);
+        auto const& insts = main[block].insts;
+        for (u32 j = 0; j < insts.size(); j++) {
+            in_region[insts[j].raw()] = is_in_region(initializer, block, j);
+        }
+        for (auto phi : main[block].phis.view()) {
+            in_region[phi.raw()] = i >= initializer.first_block && i < initializer.last_block;
+        }
+    }
+
+    // Only what the rest of main still sees of the initializer has to be
+    // kept, as constants.
+    auto live = Vector<Value>();
+    auto mark_live = [&](Value user) -> ErrorOr<void> {
+        for (auto operand : main.operands_of(user)) {
+            if (in_region[operand.raw()] && !live.find(operand).has_value()) {
+                TRY(live.append(operand));
+            }
+        }
+        return {};
+    };
+    for (u32 i = 0; i < main.blocks.size(); i++) {
+        auto block = BlockId(i);
+        auto const& insts = main[block].insts;
+        for (u32 j = 0; j < insts.size(); j++) {
+            if (!in_region[insts[j].raw()]) {
+                TRY(mark_live(insts[j]));
+            }
+        }
+        for (auto phi : main[block].phis.view()) {
+            if (!in_region[phi.raw()]) {
+                TRY(mark_live(phi));
+            }
+        }
+    }
+
+    auto insts = Vector<Value>();
+    auto tables = Vector<Table>();
+    auto constants = Vector<Value>();
+    for (auto value : live.view()) {
+        // Variables the initializer only passed along keep their value
+        // from before it.
+        auto same = TRY(passed_along(main, in_region.view(), value));
+        if (!in_region[same.raw()]) {
+            TRY(constants.append(same));
+            continue;
+        }
+        auto constant = TRY(materialize(module, main, evaluator, frame.values[value.raw()], main[value].type, main[value].shape, insts, tables));
+        if (!constant.is_valid()) {
+            for (auto unused : insts.view()) {
+                main[unused] = Inst {};
+            }
+            return false;
+        }
+        TRY(constants.append(constant));
+    }
+    for (u32 i = 0; i < live.size(); i++) {
+        main.replace_all_uses(live[i], constants[i]);
+    }
+    TRY(replace_region(main, initializers, index, insts.view()));
+    return true;
+}
+
+static ErrorOr<Frame> create_frame(IR::Function const& function)
+{
+    auto frame = Frame { function };
+    frame.values = TRY(Vector<Known>::create(function.insts.size()));
+    for (u32 i = 0; i < function.insts.size(); i++) {
+        TRY(frame.values.append(Known()));
+    }
+    return frame;
+}
+
+static ErrorOr<bool> run(Evaluator& evaluator, Frame& frame, BlockId block, u32 index, IR::Initializer const* region, Known& result)
+{
+    // Runs until the end of the region when given one, or else until the
+    // function returns.
+    auto const& function = frame.function;
+    for (;;) {
+        if (region && block == region->end && index == region->end_index) {
+            return true;
+        }
+        auto const& insts = function[block].insts;
+        if (index >= insts.size() || ++evaluator.steps > max_steps) {
+            return false;
+        }
+        auto value = insts[index];
+        auto const& inst = function[value];
+        if (!inst.is_terminator()) {
+            if (!TRY(evaluate_inst(evaluator, frame, value))) {
+                return false;
+            }
+            index++;
+            continue;
+        }
+
+        auto operands = function.operands_of(value);
+        auto next = BlockId();
+        switch (inst.kind) {
+        case Inst::jump:
+            next = inst.as.target;
+            break;
+        case Inst::branch: {
+            auto cond = TRY(get(evaluator, frame, operands[0]));
+            if (cond.kind != Type::boolean) {
+                return false;
+            }
+            next = cond.boolean ? inst.as.branch.then_ : inst.as.branch.else_;
+        } break;
+        case Inst::switch_: {
+            auto operand = TRY(get(evaluator, frame, operands[0]));
+            if (operand.kind != Type::number) {
+                return false;
+            }
+            auto targets = function.targets_of(value);
+            next = targets[0];
+            for (u32 i = 1; i < targets.size(); i++) {
+                if (operand.number == i - 1) {
+                    next = targets[i];
+                }
+            }
+        } break;
+        case Inst::ret:
+            if (region) {
+                return false;
+            }
+            if (operands.size() != 0) {
+                result = TRY(get(evaluator, frame, operands[0]));
+                return result.kind != Type::none;
+            }
+            return true;
+        default:
+            return false;
+        }
+        if (!TRY(enter(evaluator, frame, next, block))) {
+            return false;
+        }
+        block = next;
+        index = 0;
+    }
+}
+
+static ErrorOr<bool> enter(Evaluator& evaluator, Frame& frame, BlockId block, BlockId from)
+{
+    // Phis all take their values at once, as if on the edge. Lowering
+    // leaves phis for variables the block never reads, so one that isn't
+    // known only matters once it's used.
+    auto const& function = frame.function;
+    auto pred = function[block].preds.find(from);
+    if (!pred.has_value()) {
+        return false;
+    }
+    auto incoming = Vector<Known>();
+    for (auto phi : function[block].phis.view()) {
+        TRY(incoming.append(TRY(get(evaluator, frame, function.operands_of(phi)[pred->raw()]))));
+    }
+    for (u32 i = 0; i < incoming.size(); i++) {
+        frame.values[function[block].phis[i].raw()] = incoming[i];
+    }
+    return true;
+}
+
+static ErrorOr<bool> evaluate_inst(Evaluator& evaluator, Frame& frame, Value value)
+{
+    auto const& function = frame.function;
+    auto const& inst = function[value];
+    auto operands = function.operands_of(value);
+    if (inst.kind == Inst::call) {
+        return TRY(evaluate_call(evaluator, frame, value));
+    }
+
+    auto args = Vector<Known>();
+    for (auto operand : operands) {
+        auto known = TRY(get(evaluator, frame, operand));
+        if (known.kind == Type::none) {
+            return false;
+        }
+        TRY(args.append(known));
+    }
+    auto is_numbers = [&] {
+        for (auto const& arg : args.view()) {
+            if (arg.kind != Type::number) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    auto result = Known();
+    switch (inst.kind) {
+    case Inst::nop:
+        return true;
+
+    case Inst::param:
+        return frame.values[value.raw()].kind != Type::none;
+
+    case Inst::constant_number:
+    case Inst::constant_string:
+    case Inst::constant_boolean:
+    case Inst::constant_array:
+        result = TRY(get(evaluator, frame, value));
+        break;
+
+    case Inst::object:
+        result = TRY(allocate(evaluator, Type::object, args.size()));
+        if (result.kind == Type::none) {
+            return false;
+        }
+        for (u32 i = 0; i < args.size(); i++) {
+            evaluator.slots[result.start + i] = args[i];
+        }
+        result.length = args.size();
+        break;
+
+    case Inst::get_field:
+        if (args[0].kind != Type::object) {
+            return false;
+        }
+        result = evaluator.slots[args[0].start + inst.as.index];
+        break;
+
+    case Inst::create_array:
+        if (!is_numbers() || args[0].number > max_slots) {
+            return false;
+        }
+        result = TRY(allocate(evaluator, Type::array, (u32)args[0].number));
+        break;
+
+    case Inst::push:
+        if (args[0].kind != Type::array || args[0].length >= args[0].capacity) {
+            return false;
+        }
+        evaluator.slots[args[0].start + args[0].length] = args[1];
+        result = args[0];
+        result.length++;
+        break;
+
+    case Inst::length:
+        if (args[0].kind != Type::array) {
+            return false;
+        }
+        result = Known { .kind = Type::number, .number = (f64)args[0].length };
+        break;
+
+    case Inst::get_element:
+        if (args[0].kind != Type::array || args[1].kind != Type::number || !(args[1].number < args[0].length)) {
+            return false;
+        }
+        result = evaluator.slots[args[0].start + (u32)args[1].number];
+        break;
+
+    case Inst::check_length:
+        if (args[0].kind != Type::array || args[1].kind != Type::number || args[0].length < args[1].number) {
+            return false;
+        }
+        return true;
+
+    case Inst::not_:
+        if (args[0].kind != Type::boolean) {
+            return false;
+        }
+        result = Known { .kind = Type::boolean, .boolean = !args[0].boolean };
+        break;
+
+    case Inst::add:
+    case Inst::sub:
+        if (!is_numbers()) {
+            return false;
+        }
+        result = Known {
+            .kind = Type::number,
+            .number = inst.kind == Inst::add ? args[0].number + args[1].number : args[0].number - args[1].number,
+        };
+        break;
+
+    case Inst::lt:
+    case Inst::lt_eq:
+        if (!is_numbers()) {
+            return false;
+        }
+        result = Known {
+            .kind = Type::boolean,
+            .boolean = inst.kind == Inst::lt ? args[0].number < args[1].number : args[0].number <= args[1].number,
+        };
+        break;
+
+    case Inst::strict_eq: {
+        auto const& lhs = args[0];
+        auto const& rhs = args[1];
+        bool is_same = false;
+        if (lhs.kind == Type::array || lhs.kind == Type::object || rhs.kind == Type::array || rhs.kind == Type::object) {
+            return false;
+        }
+        if (lhs.kind == rhs.kind) {
+            is_same = (lhs.kind == Type::number && lhs.number == rhs.number)
+                || (lhs.kind == Type::string && lhs.string == rhs.string)
+                || (lhs.kind == Type::boolean && lhs.boolean == rhs.boolean);
+        }
+        result = Known { .kind = Type::boolean, .boolean = is_same };
+    } break;
+
+    case Inst::match_string: {
+        if (args[0].kind != Type::string) {
+            return false;
+        }
+        auto strings = function.strings_of(value);
+        u32 index = strings.size();
+        for (u32 i = strings.size(); i > 0; i--) {
+            if (strings[i - 1] == args[0].string) {
+                index = i - 1;
+            }
+        }
+        result = Known { .kind = Type::number, .number = (f64)index };
+    } break;
+
+    case Inst::to_number:
+        if (!is_numbers()) {
+            return false;
+        }
+        result = args[0];
+        break;
+
+    case Inst::to_index: {
+        // Same as JS::Number::as_index.
+        if (!is_numbers()) {
+            return false;
+        }
+        auto number = args[0].number;
+        bool is_index = number >= 0.0 && number < 4294967295.0 && number == (f64)(u32)number;
+        result = Known { .kind = Type::number, .number = is_index ? number : 4294967295.0 };
+    } break;
+
+    case Inst::concat: {
+        // Strings made here outlive the pass the same way folded ones do.
+        auto* text = new StringBuffer(TRY(StringBuffer::create()));
+        for (auto const& arg : args.view()) {
+            if (arg.kind == Type::string) {
+                TRY(text->write(arg.string));
+            } else if (arg.kind == Type::number) {
+                char buffer[32];
+                TRY(text->write(JS::Number(arg.number).to_text(buffer)));
+            } else {
+                return false;
+            }
+        }
+        result = Known { .kind = Type::string, .string = text->view() };
+    } break;
+
+    default:
+        return false;
+    }
+    if (result.kind == Type::none) {
+        return false;
+    }
+    frame.values[value.raw()] = result;
+    return true;
+}
+
+static ErrorOr<bool> evaluate_call(Evaluator& evaluator, Frame& frame, Value value)
+{
+    auto const& callee = evaluator.module[frame.function[value].as.callee];
+    if (callee.is_async || evaluator.depth >= max_depth) {
+        return false;
+    }
+    auto callee_frame = TRY(create_frame(callee));
+    auto args = frame.function.operands_of(value);
+    for (u32 i = 0; i < callee.params.size(); i++) {
+        auto arg = TRY(get(evaluator, frame, args[i]));
+        if (arg.kind == Type::none) {
+            return false;
+        }
+        callee_frame.values[callee.params[i].raw()] = arg;
+    }
+
+    auto result = Known();
+    evaluator.depth++;
+    bool is_done = TRY(run(evaluator, callee_frame, IR::Function::entry, 0, nullptr, result));
+    evaluator.depth--;
+    if (!is_done) {
+        return false;
+    }
+    frame.values[value.raw()] = result;
+    return true;
+}
+
+static ErrorOr<Known> get(Evaluator& evaluator, Frame& frame, Value value)
+{
+    // Constants and tables from initializers before this one are known
+    // without having run the code defining them.
+    auto known = frame.values[value.raw()];
+    if (known.kind != Type::none) {
+        return known;
+    }
+    auto const& inst = frame.function[value];
+    switch (inst.kind) {
+    case Inst::constant_number:
+        known = Known { .kind = Type::number, .number = inst.as.number };
+        break;
+    case Inst::constant_string:
+        known = Known { .kind = Type::string, .string = inst.as.string };
+        break;
+    case Inst::constant_boolean:
+        known = Known { .kind = Type::boolean, .boolean = inst.as.boolean };
+        break;
+    case Inst::constant_array:
+    case Inst::object: {
+        auto operands = frame.function.operands_of(value);
+        known = TRY(allocate(evaluator, inst.kind == Inst::object ? Type::object : Type::array, operands.size()));
+        if (known.kind == Type::none) {
+            return known;
+        }
+        for (u32 i = 0; i < operands.size(); i++) {
+            auto element = TRY(get(evaluator, frame, operands[i]));
+            if (element.kind == Type::none) {
+                return element;
+            }
+            evaluator.slots[known.start + i] = element;
+        }
+        known.length = operands.size();
+    } break;
+    default:
+        return known;
+    }
+    frame.values[value.raw()] = known;
+    return known;
+}
+
+static ErrorOr<Value> passed_along(IR::Function const& function, View<bool const> in_region, Value value)
+{
+    // Lowering leaves phis behind for variables that are only passed
+    // along, until they're cleaned up. Phis of the region that only refer
+    // to each other and to one single other value all stand for that value.
+    auto same = Value();
+    auto seen = Vector<Value>();
+    auto worklist = Vector<Value>();
+    TRY(worklist.append(value));
+    while (!worklist.is_empty()) {
+        auto phi = *worklist.pop();
+        if (seen.find(phi).has_value()) {
+            continue;
+        }
+        if (function[phi].kind != Inst::phi || seen.size() == max_trivial_phis) {
+            return value;
+        }
+        TRY(seen.append(phi));
+        for (auto operand : function.operands_of(phi)) {
+            if (function[operand].kind == Inst::phi && in_region[operand.raw()]) {
+                TRY(worklist.append(operand));
+            } else if (operand != same) {
+                if (same.is_valid()) {
+                    return value;
+                }
+                same = operand;
+            }
+        }
+    }
+    return same.is_valid() ? same : value;
+}
+
+static ErrorOr<Known> allocate(Evaluator& evaluator, Type::Kind kind, u32 capacity)
+{
+    if (capacity > max_slots - evaluator.slots.size()) {
+        return Known();
+    }
+    auto known = Known {
+        .kind = kind,
+        .start = evaluator.slots.size(),
+        .capacity = capacity,
+    };
+    for (u32 i = 0; i < capacity; i++) {
+        TRY(evaluator.slots.append(Known()));
+    }
+    return known;
+}
+
+static ErrorOr<Value> materialize(IR::Module const& module, IR::Function& function, Evaluator const& evaluator, Known known, Type type, IR::ShapeId shape, Vector<Value>& insts, Vector<Table>& tables)
+{
+    auto append = [&](Inst inst) -> ErrorOr<Value> {
+        auto value = TRY(function.create_value(inst));
+        TRY(insts.append(value));
+        return value;
+    };
+
+    switch (known.kind) {
+    case Type::number:
+        if (type != Type::number && type != Type::index) {
+            return Value();
+        }
+        return TRY(append(Inst { .kind = Inst::constant_number, .type = type, .as = { .number = known.number } }));
+
+    case Type::string:
+        if (type != Type::string) {
+            return Value();
+        }
+        return TRY(append(Inst { .kind = Inst::constant_string, .type = type, .as = { .string = known.string } }));
+
+    case Type::boolean:
+        if (type != Type::boolean) {
+            return Value();
+        }
+        return TRY(append(Inst { .kind = Inst::constant_boolean, .type = type, .as = { .boolean = known.boolean } }));
+
+    case Type::array:
+    case Type::object: {
+        bool is_array = known.kind == Type::array;
+        if (is_array ? type != Type::array : (type != Type::object || module[shape].is_union())) {
+            return Value();
+        }
+        // The same array or object seen through several values becomes a
+        // single table.
+        for (auto const& table : tables.view()) {
+            if (table.known.kind == known.kind && table.known.start == known.start && table.known.length == known.length) {
+                return table.value;
+            }
+        }
+        if (is_array && insts.size() + known.length > max_table_size) {
+            return Value();
+        }
+        auto elements = Vector<Value>();
+        for (u32 i = 0; i < known.length; i++) {
+            auto element_type = is_array ? type.element_type() : module[shape].types[i];
+            auto element_shape = is_array ? shape : module[shape].shapes[i];
+            auto element = TRY(materialize(module, function, evaluator, evaluator.slots[known.start + i], element_type, element_shape, insts, tables));
+            if (!element.is_valid()) {
+                return Value();
+            }
+            TRY(elements.append(element));
+        }
+        auto value = TRY(append(Inst {
+            .kind = is_array ? Inst::constant_array : Inst::object,
+            .type = type,
+            .shape = shape,
+            .operands = TRY(function.create_operands(elements.view())),
+        }));
+        TRY(tables.append(Table { known, value }));
+        return value;
+    }
+
+    default:
+        return Value();
+    }
+}
+
+static ErrorOr<void> replace_region(IR::Function& function, Vector<IR::Initializer>& initializers, u32 index, View<Value const> insts)
+{
+    // The start of the region gets the constants in its place. The code
+    // that computed them is cut off from the entry, and left for unreachable
+    // block removal.
+    auto initializer = initializers[index];
+    auto start = initializer.start;
+    auto end = initializer.end;
+    auto rename = [&](BlockId block, BlockId from, BlockId to) -> ErrorOr<void> {
+        for (auto successor : TRY(function.successors(block))) {
+            for (auto& pred : function[successor].preds) {
+                if (pred == from) {
+                    pred = to;
+                }
+            }
+        }
+        return {};
+    };
+    auto split = [&](BlockId block, u32 at) -> ErrorOr<Vector<Value>> {
+        auto head = Vector<Value>();
+        auto tail = Vector<Value>();
+        auto const& old = function[block].insts;
+        for (u32 i = 0; i < old.size(); i++) {
+            TRY((i < at ? head : tail).append(old[i]));
+        }
+        function[block].insts = move(head);
+        return tail;
+    };
+
+    if (start == end) {
+        auto tail = TRY(split(start, initializer.end_index));
+        for (auto value : TRY(split(start, initializer.start_index))) {
+            function[value] = Inst {};
+        }
+        for (auto value : insts) {
+            TRY(function[start].insts.append(value));
+        }
+        auto shift = function[start].insts.size();
+        for (auto value : tail.view()) {
+            TRY(function[start].insts.append(value));
+        }
+        for (u32 i = index + 1; i < initializers.size(); i++) {
+            auto& later = initializers[i];
+            if (later.start == start && later.start_index >= initializer.end_index) {
+                later.start_index = later.start_index - initializer.end_index + shift;
+            }
+            if (later.end == start && later.end_index >= initializer.end_index) {
+                later.end_index = later.end_index - initializer.end_index + shift;
+            }
+        }
+        return {};
+    }
+
+    auto rest = TRY(function.create_block());
+    function[rest].insts = TRY(split(end, initializer.end_index));
+    TRY(rename(rest, end, rest));
+    TRY(function.append(end, Inst {
+        .kind = Inst::jump,
+        .type = Type::void_,
+        .as = { .target = rest },
+    }));
+    TRY(function[rest].preds.append(end));
+
+    auto cut = TRY(function.create_block());
+    function[cut].insts = TRY(split(start, initializer.start_index));
+    TRY(rename(cut, start, cut));
+    for (auto value : insts) {
+        TRY(function[start].insts.append(value));
+    }
+    TRY(function.append(start, Inst {
+        .kind = Inst::jump,
+        .type = Type::void_,
+        .as = { .target = rest },
+    }));
+    TRY(function[rest].preds.append(start));
+
+    for (u32 i = index + 1; i < initializers.size(); i++) {
+        auto& later = initializers[i];
+        if (later.start == end && later.start_index >= initializer.end_index) {
+            later.start = rest;
+            later.start_index -= initializer.end_index;
+        }
+        if (later.end == end && later.end_index >= initializer.end_index) {
+            later.end = rest;
+            later.end_index -= initializer.end_index;
+        }
+    }
+    return {};
+}
+
+static bool is_in_region(IR::Initializer const& initializer, BlockId block, u32 index)
+{
+    if (block == initializer.start && block == initializer.end) {
+        return index >= initializer.start_index && index < initializer.end_index;
+    }
+    if (block == initializer.start) {
+        return index >= initializer.start_index;
+    }
+    if (block == initializer.end) {
+        return index < initializer.end_index;
+    }
+    return block.raw() >= initializer.first_block && block.raw() < initializer.last_block;
+}
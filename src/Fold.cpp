@@ -0,0 +1,453 @@
+#include "./Passes.h"
+
+#include <JS/Number.h>
+#include <Ty/StringBuffer.h>
+
+static ErrorOr<bool> fold_constants(IR::Function&);
+static ErrorOr<bool> fold_inst(IR::Function&, IR::BlockId, IR::Value);
+static ErrorOr<bool> fold_phi(IR::Function&, IR::Value);
+static ErrorOr<bool> fold_branch(IR::Function&, IR::BlockId, IR::Value);
+static ErrorOr<bool> fold_switch(IR::Function&, IR::BlockId, IR::Value);
+static bool fold_variant(IR::Function&, IR::Value);
+static ErrorOr<bool> fold_concat(IR::Function&, IR::Value);
+static bool fold_table(IR::Function&, IR::Value);
+static ErrorOr<StringView> constant_text(IR::Inst const&);
+static bool is_constant(IR::Inst const&);
+static bool same_constant(IR::Inst const&, IR::Inst const&);
+
+ErrorOr<bool> fold_constants(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(fold_constants(function));
+    }
+    return changed;
+}
+
+static ErrorOr<bool> fold_constants(IR::Function& function)
+{
+    bool changed = false;
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        auto block = IR::BlockId(i);
+
+        bool folded_phi = false;
+        for (auto phi : function[block].phis.view()) {
+            folded_phi |= TRY(fold_phi(function, phi));
+        }
+        if (folded_phi) {
+            // Constants don't need to stay in the block, they're emitted
+            // where they're used.
+            auto phis = Vector<IR::Value>();
+            for (auto phi : function[block].phis.view()) {
+                if (function[phi].kind == IR::Inst::phi) {
+                    TRY(phis.append(phi));
+                }
+            }
+            function[block].phis = move(phis);
+            changed = true;
+        }
+
+        for (auto value : function[block].insts.view()) {
+            changed |= TRY(fold_inst(function, block, value));
+        }
+    }
+    return changed;
+}
+
+static ErrorOr<bool> fold_inst(IR::Function& function, IR::BlockId block, IR::Value value)
+{
+    auto const& inst = function[value];
+    if (inst.kind == IR::Inst::branch) {
+        return TRY(fold_branch(function, block, value));
+    }
+    if (inst.kind == IR::Inst::switch_) {
+        return TRY(fold_switch(function, block, value));
+    }
+    if (inst.kind == IR::Inst::get_tag || inst.kind == IR::Inst::unwrap) {
+        return fold_variant(function, value);
+    }
+    if (inst.kind == IR::Inst::concat) {
+        return TRY(fold_concat(function, value));
+    }
+    if (inst.kind == IR::Inst::length || inst.kind == IR::Inst::get_element) {
+        return fold_table(function, value);
+    }
+
+    auto operands = function.operands_of(value);
+    for (auto operand : operands) {
+        if (!is_constant(function[operand])) {
+            // Values of different types are never strictly equal, so
+            // there's no need to know what they are.
+            if (inst.kind == IR::Inst::strict_eq && operands.size() == 2) {
+                auto lhs_type = function[operands[0]].type;
+                auto rhs_type = function[operands[1]].type;
+                if (lhs_type != Type::none && rhs_type != Type::none && lhs_type != rhs_type) {
+                    function[value] = IR::Inst {
+                        .kind = IR::Inst::constant_boolean,
+                        .type = Type::boolean,
+                        .as = { .boolean = false },
+                    };
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    auto result = IR::Inst {};
+    switch (inst.kind) {
+    case IR::Inst::not_: {
+        auto const& operand = function[operands[0]];
+        if (operand.kind != IR::Inst::constant_boolean) {
+            return false;
+        }
+        result = IR::Inst {
+            .kind = IR::Inst::constant_boolean,
+            .type = Type::boolean,
+            .as = { .boolean = !operand.as.boolean },
+        };
+    } break;
+
+    case IR::Inst::add: {
+        auto const& lhs = function[operands[0]];
+        auto const& rhs = function[operands[1]];
+        if (lhs.kind == IR::Inst::constant_number && rhs.kind == IR::Inst::constant_number) {
+            result = IR::Inst {
+                .kind = IR::Inst::constant_number,
+                .type = inst.type,
+                .as = { .number = lhs.as.number + rhs.as.number },
+            };
+            break;
+        }
+        return false;
+    }
+
+    case IR::Inst::sub: {
+        auto const& lhs = function[operands[0]];
+        auto const& rhs = function[operands[1]];
+        if (lhs.kind != IR::Inst::constant_number || rhs.kind != IR::Inst::constant_number) {
+            return false;
+        }
+        result = IR::Inst {
+            .kind = IR::Inst::constant_number,
+            .type = inst.type,
+            .as = { .number = lhs.as.number - rhs.as.number },
+        };
+    } break;
+
+    case IR::Inst::lt: {
+        auto const& lhs = function[operands[0]];
+        auto const& rhs = function[operands[1]];
+        if (lhs.kind != IR::Inst::constant_number || rhs.kind != IR::Inst::constant_number) {
+            return false;
+        }
+        result = IR::Inst {
+            .kind = IR::Inst::constant_boolean,
+            .type = Type::boolean,
+            .as = { .boolean = lhs.as.number < rhs.as.number },
+        };
+    } break;
+
+    case IR::Inst::lt_eq: {
+        auto const& lhs = function[operands[0]];
+        auto const& rhs = function[operands[1]];
+        if (lhs.kind != IR::Inst::constant_number || rhs.kind != IR::Inst::constant_number) {
+            return false;
+        }
+        result = IR::Inst {
+            .kind = IR::Inst::constant_boolean,
+            .type = Type::boolean,
+            .as = { .boolean = lhs.as.number <= rhs.as.number },
+        };
+    } break;
+
+    case IR::Inst::strict_eq: {
+        auto const& lhs = function[operands[0]];
+        auto const& rhs = function[operands[1]];
+        result = IR::Inst {
+            .kind = IR::Inst::constant_boolean,
+            .type = Type::boolean,
+            .as = { .boolean = same_constant(lhs, rhs) },
+        };
+    } break;
+
+    case IR::Inst::match_string: {
+        auto const& operand = function[operands[0]];
+        if (operand.kind != IR::Inst::constant_string) {
+            return false;
+        }
+        auto strings = function.strings_of(value);
+        u32 index = strings.size();
+        for (u32 i = strings.size(); i > 0; i--) {
+            if (strings[i - 1] == operand.as.string) {
+                index = i - 1;
+            }
+        }
+        result = IR::Inst {
+            .kind = IR::Inst::constant_number,
+            .type = Type::number,
+            .as = { .number = (f64)index },
+        };
+    } break;
+
+    case IR::Inst::to_number: {
+        auto const& operand = function[operands[0]];
+        result = IR::Inst {
+            .kind = IR::Inst::constant_number,
+            .type = Type::number,
+            .as = { .number = operand.as.number },
+        };
+    } break;
+
+    case IR::Inst::to_index: {
+        // Same as JS::Number::as_index.
+        auto number = function[operands[0]].as.number;
+        bool is_index = number >= 0.0 && number < 4294967295.0 && number == (f64)(u32)number;
+        result = IR::Inst {
+            .kind = IR::Inst::constant_number,
+            .type = Type::index,
+            .as = { .number = is_index ? number : 4294967295.0 },
+        };
+    } break;
+
+    default:
+        return false;
+    }
+
+    function[value] = result;
+    return true;
+}
+
+static ErrorOr<bool> fold_phi(IR::Function& function, IR::Value phi)
+{
+    auto operands = function.operands_of(phi);
+    auto first = IR::Value();
+    for (auto operand : operands) {
+        if (operand == phi) {
+            continue;
+        }
+        if (!is_constant(function[operand])) {
+            return false;
+        }
+        if (!first.is_valid()) {
+            first = operand;
+            continue;
+        }
+        if (!same_constant(function[first], function[operand])) {
+            return false;
+        }
+    }
+    if (!first.is_valid()) {
+        return false;
+    }
+    function[phi] = function[first];
+    return true;
+}
+
+static ErrorOr<bool> fold_branch(IR::Function& function, IR::BlockId block, IR::Value value)
+{
+    auto const& cond = function[function.operands_of(value)[0]];
+    if (cond.kind != IR::Inst::constant_boolean) {
+        return false;
+    }
+
+    auto branch = function[value].as.branch;
+    auto taken = cond.as.boolean ? branch.then_ : branch.else_;
+    auto not_taken = cond.as.boolean ? branch.else_ : branch.then_;
+    function[value] = IR::Inst {
+        .kind = IR::Inst::jump,
+        .type = Type::void_,
+        .as = { .target = taken },
+    };
+
+    if (taken != not_taken) {
+        auto pred = function[not_taken].preds.find(block);
+        if (pred.has_value()) {
+            TRY(function.remove_predecessor(not_taken, pred->raw()));
+        }
+    }
+    return true;
+}
+
+static ErrorOr<bool> fold_switch(IR::Function& function, IR::BlockId block, IR::Value value)
+{
+    auto const& operand = function[function.operands_of(value)[0]];
+    if (operand.kind != IR::Inst::constant_number) {
+        return false;
+    }
+
+    auto targets = function.targets_of(value);
+    u32 taken = 0;
+    for (u32 i = 1; i < targets.size(); i++) {
+        if (operand.as.number == i - 1) {
+            taken = i;
+        }
+    }
+
+    // Every target listed the switch as a predecessor once per case that
+    // led there, only the taken edge is left.
+    for (u32 i = 0; i < targets.size(); i++) {
+        if (i == taken) {
+            continue;
+        }
+        auto pred = function[targets[i]].preds.find(block);
+        if (pred.has_value()) {
+            TRY(function.remove_predecessor(targets[i], pred->raw()));
+        }
+    }
+    function[value] = IR::Inst {
+        .kind = IR::Inst::jump,
+        .type = Type::void_,
+        .as = { .target = targets[taken] },
+    };
+    return true;
+}
+
+static bool fold_variant(IR::Function& function, IR::Value value)
+{
+    // Looking into a union that was just built gives what it was built
+    // from.
+    auto object = function.operands_of(value)[0];
+    auto const& wrap = function[object];
+    if (wrap.kind != IR::Inst::wrap) {
+        return false;
+    }
+    auto const& inst = function[value];
+    if (inst.kind == IR::Inst::get_tag) {
+        function[value] = IR::Inst {
+            .kind = IR::Inst::constant_number,
+            .type = Type::number,
+            .as = { .number = (f64)wrap.as.index },
+        };
+        return true;
+    }
+    if (inst.as.index != wrap.as.index) {
+        function[value] = IR::Inst {
+            .kind = IR::Inst::undef,
+            .type = inst.type,
+            .shape = inst.shape,
+        };
+        return true;
+    }
+    function.replace_all_uses(value, function.operands_of(object)[0]);
+    function[value] = IR::Inst {};
+    return true;
+}
+
+static bool fold_table(IR::Function& function, IR::Value value)
+{
+    // Arrays worked out at compile time have their length and elements
+    // right there.
+    auto operands = function.operands_of(value);
+    auto const& table = function[operands[0]];
+    if (table.kind != IR::Inst::constant_array) {
+        return false;
+    }
+    if (function[value].kind == IR::Inst::length) {
+        function[value] = IR::Inst {
+            .kind = IR::Inst::constant_number,
+            .type = Type::index,
+            .as = { .number = (f64)table.operands.count },
+        };
+        return true;
+    }
+    auto const& index = function[operands[1]];
+    bool is_in_range = index.as.number >= 0.0 && index.as.number < table.operands.count && index.as.number == (f64)(u32)index.as.number;
+    if (index.kind != IR::Inst::constant_number || !is_in_range) {
+        return false;
+    }
+    function.replace_all_uses(value, function.operands_of(operands[0])[(u32)index.as.number]);
+    function[value] = IR::Inst {};
+    return true;
+}
+
+static ErrorOr<bool> fold_concat(IR::Function& function, IR::Value value)
+{
+    // Neighbouring constants are joined here, so what's left to do at
+    // runtime is copying the parts that aren't known yet.
+    bool changed = false;
+    auto operands = Vector<IR::Value>();
+    for (auto operand : function.operands_of(value)) {
+        auto const& inst = function[operand];
+        if (inst.kind != IR::Inst::constant_string && inst.kind != IR::Inst::constant_number) {
+            TRY(operands.append(operand));
+            continue;
+        }
+        auto text = TRY(constant_text(inst));
+        if (!operands.is_empty() && function[operands.last()].kind == IR::Inst::constant_string) {
+            // Folded strings outlive the pass the same way parse tree
+            // nodes outlive the parser.
+            text = (new StringBuffer(TRY(StringBuffer::create_fill(function[operands.last()].as.string, text))))->view();
+            (void)operands.pop();
+        } else if (inst.kind == IR::Inst::constant_string && !text.is_empty()) {
+            TRY(operands.append(operand));
+            continue;
+        }
+        changed = true;
+        if (!text.is_empty()) {
+            TRY(operands.append(TRY(function.create_value(IR::Inst {
+                .kind = IR::Inst::constant_string,
+                .type = Type::string,
+                .as = { .string = text },
+            }))));
+        }
+    }
+    if (!changed) {
+        return false;
+    }
+
+    if (operands.is_empty()) {
+        function[value] = IR::Inst {
+            .kind = IR::Inst::constant_string,
+            .type = Type::string,
+            .as = { .string = ""sv },
+        };
+        return true;
+    }
+    if (operands.size() == 1 && function[operands[0]].type == Type::string) {
+        function.replace_all_uses(value, operands[0]);
+        function[value] = IR::Inst {};
+        return true;
+    }
+    function[value].operands = TRY(function.create_operands(operands.view()));
+    return true;
+}
+
+static ErrorOr<StringView> constant_text(IR::Inst const& inst)
+{
+    if (inst.kind == IR::Inst::constant_string) {
+        return inst.as.string;
+    }
+    char buffer[32];
+    auto* text = new StringBuffer(TRY(StringBuffer::create_fill(JS::Number(inst.as.number).to_text(buffer))));
+    return text->view();
+}
+
+static bool is_constant(IR::Inst const& inst)
+{
+    switch (inst.kind) {
+    case IR::Inst::constant_number:
+    case IR::Inst::constant_string:
+    case IR::Inst::constant_boolean:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool same_constant(IR::Inst const& lhs, IR::Inst const& rhs)
+{
+    if (lhs.kind != rhs.kind) {
+        return false;
+    }
+    switch (lhs.kind) {
+    case IR::Inst::constant_number:
+        return lhs.as.number == rhs.as.number;
+    case IR::Inst::constant_string:
+        return lhs.as.string == rhs.as.string;
+    case IR::Inst::constant_boolean:
+        return lhs.as.boolean == rhs.as.boolean;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,547 @@
+#include "./IR.h"
+
+#include <Ty/Hash.h>
+
+namespace IR {
+
+bool Inst::has_side_effects() const
+{
+    switch (kind) {
+    case nop:
+    case undef:
+    case constant_number:
+    case constant_string:
+    case constant_boolean:
+    case constant_array:
+    case param:
+    case phi:
+    case object:
+    case get_field:
+    case wrap:
+    case unwrap:
+    case get_tag:
+    case new_object:
+    case load_field:
+    case upcast:
+    case create_array:
+    case push:
+    case length:
+    case get_element:
+    case not_:
+    case add:
+    case sub:
+    case lt:
+    case lt_eq:
+    case strict_eq:
+    case match_string:
+    case to_number:
+    case to_index:
+    case concat:
+        return false;
+    case check_length:
+    case call:
+    case call_method:
+    case call_virtual:
+    case store_field:
+    case free_object:
+    case await_:
+    case jump:
+    case branch:
+    case switch_:
+    case ret:
+    case throw_:
+        return true;
+    }
+}
+
+View<Value> Function::operands_of(Value value)
+{
+    auto operands = insts[value].operands;
+    return View(this->operands.data() + operands.start, operands.count);
+}
+
+View<Value const> Function::operands_of(Value value) const
+{
+    auto operands = insts[value].operands;
+    return View(this->operands.data() + operands.start, operands.count);
+}
+
+View<BlockId> Function::targets_of(Value value)
+{
+    auto targets = insts[value].as.switch_;
+    return View(this->targets.data() + targets.start, targets.count);
+}
+
+View<BlockId const> Function::targets_of(Value value) const
+{
+    auto targets = insts[value].as.switch_;
+    return View(this->targets.data() + targets.start, targets.count);
+}
+
+View<StringView const> Function::strings_of(Value value) const
+{
+    auto strings = insts[value].as.strings;
+    return View(this->strings.data() + strings.start, strings.count);
+}
+
+ErrorOr<Vector<BlockId>> Function::successors(BlockId block) const
+{
+    auto successors = Vector<BlockId>();
+    auto const& insts = blocks[block].insts;
+    if (insts.is_empty()) {
+        return successors;
+    }
+    auto const& terminator = this->insts[insts.last()];
+    switch (terminator.kind) {
+    case Inst::jump:
+        TRY(successors.append(terminator.as.target));
+        break;
+    case Inst::branch:
+        TRY(successors.append(terminator.as.branch.then_));
+        TRY(successors.append(terminator.as.branch.else_));
+        break;
+    case Inst::switch_:
+        for (auto target : targets_of(insts.last())) {
+            TRY(successors.append(target));
+        }
+        break;
+    default:
+        break;
+    }
+    return successors;
+}
+
+ErrorOr<BlockId> Function::create_block()
+{
+    return TRY(blocks.append(Block()));
+}
+
+ErrorOr<Value> Function::create_value(Inst inst)
+{
+    return TRY(insts.append(inst));
+}
+
+ErrorOr<Operands> Function::create_operands(View<Value const> values)
+{
+    auto result = Operands {
+        .start = this->operands.size(),
+        .count = (u32)values.size(),
+    };
+    for (auto value : values) {
+        TRY(this->operands.append(value));
+    }
+    return result;
+}
+
+ErrorOr<Inst::Switch> Function::create_targets(View<BlockId const> targets)
+{
+    auto result = Inst::Switch {
+        .start = this->targets.size(),
+        .count = (u32)targets.size(),
+    };
+    for (auto target : targets) {
+        TRY(this->targets.append(target));
+    }
+    return result;
+}
+
+ErrorOr<Inst::Strings> Function::create_strings(View<StringView const> strings, u32 seed, u32 bits)
+{
+    auto result = Inst::Strings {
+        .start = this->strings.size(),
+        .count = (u32)strings.size(),
+        .seed = seed,
+        .bits = bits,
+    };
+    for (auto string : strings) {
+        TRY(this->strings.append(string));
+    }
+    return result;
+}
+
+ErrorOr<Value> Function::append(BlockId block, Inst inst)
+{
+    auto value = TRY(create_value(inst));
+    TRY(blocks[block].insts.append(value));
+    return value;
+}
+
+ErrorOr<Value> Function::append(BlockId block, Inst inst, View<Value const> operands)
+{
+    inst.operands = TRY(create_operands(operands));
+    return TRY(append(block, inst));
+}
+
+ErrorOr<Vector<u32>> Function::count_uses() const
+{
+    auto uses = TRY(Vector<u32>::create(insts.size()));
+    for (u32 i = 0; i < insts.size(); i++) {
+        TRY(uses.append(0));
+    }
+    for (auto const& block : blocks) {
+        for (auto phi : block.phis.view()) {
+            for (auto operand : operands_of(phi)) {
+                uses[operand.raw()]++;
+            }
+        }
+        for (auto inst : block.insts.view()) {
+            for (auto operand : operands_of(inst)) {
+                uses[operand.raw()]++;
+            }
+        }
+    }
+    return uses;
+}
+
+void Function::replace_all_uses(Value of, Value with)
+{
+    for (auto& operand : operands) {
+        if (operand == of) {
+            operand = with;
+        }
+    }
+}
+
+ErrorOr<void> Function::remove_predecessor(BlockId block, u32 index)
+{
+    auto& target = blocks[block];
+    for (auto phi : target.phis.view()) {
+        auto values = operands_of(phi);
+        for (u32 i = index; i + 1 < values.size(); i++) {
+            values[i] = values[i + 1];
+        }
+        insts[phi].operands.count--;
+    }
+
+    auto preds = TRY(Vector<BlockId>::create(target.preds.size()));
+    for (u32 i = 0; i < target.preds.size(); i++) {
+        if (i != index) {
+            TRY(preds.append(target.preds[i]));
+        }
+    }
+    target.preds = move(preds);
+    return {};
+}
+
+Optional<u32> Shape::find(StringView field) const
+{
+    for (u32 i = 0; i < fields.size(); i++) {
+        if (fields[i] == field) {
+            return i;
+        }
+    }
+    return {};
+}
+
+Optional<u32> Shape::find_presence(StringView field) const
+{
+    for (u32 i = 0; i < fields.size(); i++) {
+        if (is_presence(fields[i]) && fields[i].shrink(1) == field) {
+            return i;
+        }
+    }
+    return {};
+}
+
+Optional<u32> Shape::find_variant(StringView tag) const
+{
+    for (u32 i = 0; i < tags.size(); i++) {
+        if (tags[i] == tag) {
+            return i;
+        }
+    }
+    return {};
+}
+
+bool Shape::is_presence(StringView field)
+{
+    return field.ends_with("?"sv);
+}
+
+Optional<FunctionId> Module::find(StringView name) const
+{
+    for (u32 i = 0; i < functions.size(); i++) {
+        if (functions[i].name == name) {
+            return FunctionId(i);
+        }
+    }
+    return {};
+}
+
+Optional<ClassId> Module::find_class(ShapeId shape) const
+{
+    for (u32 i = 0; i < classes.size(); i++) {
+        if (classes[i].shape == shape) {
+            return ClassId(i);
+        }
+    }
+    return {};
+}
+
+bool Module::is_subclass(ClassId id, ClassId of) const
+{
+    for (; id.is_valid(); id = classes[id].base) {
+        if (id == of) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ClassId Module::introducing(ClassId id, u32 slot) const
+{
+    while (classes[id].base.is_valid() && slot < classes[classes[id].base].methods.size()) {
+        id = classes[id].base;
+    }
+    return id;
+}
+
+ErrorOr<Vector<FunctionId>> Module::implementations(ClassId id, u32 slot) const
+{
+    auto result = Vector<FunctionId>();
+    for (u32 i = 0; i < classes.size(); i++) {
+        if (!is_subclass(ClassId(i), id)) {
+            continue;
+        }
+        auto implementation = classes[i].implementations[slot];
+        if (!result.find(implementation).has_value()) {
+            TRY(result.append(implementation));
+        }
+    }
+    return result;
+}
+
+bool Module::dispatch_may_throw(ClassId id, u32 slot) const
+{
+    for (u32 i = 0; i < classes.size(); i++) {
+        if (!is_subclass(ClassId(i), id)) {
+            continue;
+        }
+        auto implementation = classes[i].implementations[slot];
+        if (implementation.is_valid() && functions[implementation].may_throw) {
+            return true;
+        }
+    }
+    return false;
+}
+
+u64 hash_multiplier(u32 seed)
+{
+    // Multiply-shift hashing wants an odd multiplier, spreading the seeds
+    // out keeps the ones tried close together from behaving alike.
+    return ((seed + 1) * 0x9E3779B97F4A7C15ULL) | 1;
+}
+
+u32 hash_slot(StringView string, u32 seed, u32 bits)
+{
+    auto hash = Ty::Hash().djbd(string.data(), string.size()).hash();
+    return (u32)((hash * hash_multiplier(seed)) >> (64 - bits));
+}
+
+StringView kind_name(Inst::Kind kind)
+{
+    switch (kind) {
+    case Inst::nop:                 return "nop"sv;
+    case Inst::undef:               return "undef"sv;
+
+    case Inst::constant_number:     return "constant_number"sv;
+    case Inst::constant_string:     return "constant_string"sv;
+    case Inst::constant_boolean:    return "constant_boolean"sv;
+    case Inst::constant_array:      return "constant_array"sv;
+    case Inst::param:               return "param"sv;
+    case Inst::phi:                 return "phi"sv;
+
+    case Inst::object:              return "object"sv;
+    case Inst::get_field:           return "get_field"sv;
+    case Inst::wrap:                return "wrap"sv;
+    case Inst::unwrap:              return "unwrap"sv;
+    case Inst::get_tag:             return "get_tag"sv;
+
+    case Inst::new_object:          return "new_object"sv;
+    case Inst::load_field:          return "load_field"sv;
+    case Inst::store_field:         return "store_field"sv;
+    case Inst::upcast:              return "upcast"sv;
+    case Inst::free_object:         return "free_object"sv;
+
+    case Inst::create_array:        return "create_array"sv;
+    case Inst::push:                return "push"sv;
+    case Inst::length:              return "length"sv;
+    case Inst::get_element:         return "get_element"sv;
+    case Inst::check_length:        return "check_length"sv;
+
+    case Inst::not_:                return "not"sv;
+    case Inst::add:                 return "add"sv;
+    case Inst::sub:                 return "sub"sv;
+    case Inst::lt:                  return "lt"sv;
+    case Inst::lt_eq:               return "lt_eq"sv;
+    case Inst::strict_eq:           return "strict_eq"sv;
+    case Inst::match_string:        return "match_string"sv;
+    case Inst::to_number:           return "to_number"sv;
+    case Inst::to_index:            return "to_index"sv;
+    case Inst::concat:              return "concat"sv;
+
+    case Inst::call:                return "call"sv;
+    case Inst::call_method:         return "call_method"sv;
+    case Inst::call_virtual:        return "call_virtual"sv;
+    case Inst::await_:              return "await"sv;
+
+    case Inst::jump:                return "jump"sv;
+    case Inst::branch:              return "branch"sv;
+    case Inst::switch_:             return "switch"sv;
+    case Inst::ret:                 return "ret"sv;
+    case Inst::throw_:              return "throw"sv;
+    }
+}
+
+static ErrorOr<u32> dump_inst(StringBuffer&, Module const&, Function const&, Value);
+
+ErrorOr<StringBuffer> dump(Module const& module)
+{
+    auto out = TRY(StringBuffer::create());
+    for (u32 i = 0; i < module.shapes.size(); i++) {
+        auto const& shape = module.shapes[i];
+        if (shape.is_union()) {
+            TRY(out.write("shape"sv, i, " = "sv));
+            for (u32 j = 0; j < shape.variants.size(); j++) {
+                TRY(out.write(j == 0 ? ""sv : " | "sv, shape.tag, ": \""sv, shape.tags[j], "\" shape"sv, shape.variants[j].raw()));
+            }
+            TRY(out.writeln(""sv));
+            continue;
+        }
+        TRY(out.write("shape"sv, i, " {"sv));
+        for (u32 j = 0; j < shape.fields.size(); j++) {
+            if (shape.types[j] == Type::object || shape.types[j] == Type::instance) {
+                TRY(out.write(" "sv, shape.fields[j], ": shape"sv, shape.shapes[j].raw()));
+            } else {
+                auto type = TRY(shape.types[j].to_string());
+                TRY(out.write(" "sv, shape.fields[j], ": "sv, type.view()));
+            }
+        }
+        TRY(out.writeln(" }"sv));
+    }
+    if (!module.shapes.is_empty()) {
+        TRY(out.writeln(""sv));
+    }
+    for (auto const& function : module.functions) {
+        auto return_type = TRY(function.return_type.to_string());
+        if (function.is_exported) {
+            TRY(out.write("export "sv));
+        }
+        if (function.is_async) {
+            TRY(out.write("async "sv));
+        }
+        TRY(out.write("function "sv, function.name, "("sv));
+        for (u32 i = 0; i < function.params.size(); i++) {
+            auto param = function.params[i];
+            auto type = TRY(function[param].type.to_string());
+            TRY(out.write(type.view(), " %"sv, param.raw()));
+            if (i + 1 < function.params.size()) {
+                TRY(out.write(", "sv));
+            }
+        }
+        TRY(out.write("): "sv, return_type.view()));
+        if (function.may_throw) {
+            TRY(out.write(" may_throw"sv));
+        }
+        TRY(out.writeln(""sv));
+
+        for (u32 i = 0; i < function.blocks.size(); i++) {
+            auto const& block = function.blocks[i];
+            if (block.is_removed()) {
+                continue;
+            }
+            TRY(out.write("b"sv, i, ":"sv));
+            for (auto pred : block.preds.view()) {
+                TRY(out.write(" b"sv, pred.raw()));
+            }
+            TRY(out.writeln(""sv));
+            for (auto phi : block.phis.view()) {
+                TRY(dump_inst(out, module, function, phi));
+            }
+            for (auto inst : block.insts.view()) {
+                TRY(dump_inst(out, module, function, inst));
+            }
+        }
+        TRY(out.writeln(""sv));
+    }
+    return out;
+}
+
+static ErrorOr<u32> dump_inst(StringBuffer& out, Module const& module, Function const& function, Value value)
+{
+    u32 size = 0;
+    auto const& inst = function[value];
+
+    size += TRY(out.write("    "sv));
+    if (inst.type == Type::object || inst.type == Type::instance) {
+        size += TRY(out.write("%"sv, value.raw(), ": shape"sv, inst.shape.raw(), " = "sv));
+    } else if (inst.type != Type::void_ && inst.type != Type::none) {
+        auto type = TRY(inst.type.to_string());
+        size += TRY(out.write("%"sv, value.raw(), ": "sv, type.view(), " = "sv));
+    }
+    size += TRY(out.write(kind_name(inst.kind)));
+
+    switch (inst.kind) {
+    case Inst::constant_number:
+        size += TRY(out.write(" "sv, inst.as.number));
+        break;
+    case Inst::constant_string:
+        size += TRY(out.write(" \""sv, inst.as.string, "\""sv));
+        break;
+    case Inst::constant_boolean:
+        size += TRY(out.write(" "sv, inst.as.boolean));
+        break;
+    case Inst::param:
+        size += TRY(out.write(" "sv, inst.as.index));
+        break;
+    case Inst::get_element:
+        if (inst.as.boolean) {
+            size += TRY(out.write(" in_bounds"sv));
+        }
+        break;
+    case Inst::get_field:
+    case Inst::wrap:
+    case Inst::unwrap:
+    case Inst::load_field:
+    case Inst::store_field:
+        size += TRY(out.write(" "sv, inst.as.index));
+        break;
+    case Inst::call_virtual: {
+        auto const& class_ = module[module.find_class(function[function.operands_of(value)[0]].shape).value()];
+        size += TRY(out.write(" "sv, class_.name, "."sv, class_.methods[inst.as.index]));
+    } break;
+    case Inst::call:
+        size += TRY(out.write(" "sv, module[inst.as.callee].name));
+        break;
+    case Inst::call_method: {
+        auto file = module.source.file;
+        size += TRY(out.write(" "sv, inst.as.method.object.view_in(file), "."sv, inst.as.method.member.view_in(file)));
+    } break;
+    case Inst::jump:
+        size += TRY(out.write(" b"sv, inst.as.target.raw()));
+        break;
+    case Inst::branch:
+        size += TRY(out.write(" b"sv, inst.as.branch.then_.raw(), " b"sv, inst.as.branch.else_.raw()));
+        break;
+    case Inst::switch_:
+        for (auto target : function.targets_of(value)) {
+            size += TRY(out.write(" b"sv, target.raw()));
+        }
+        break;
+    case Inst::match_string:
+        for (auto string : function.strings_of(value)) {
+            size += TRY(out.write(" \""sv, string, "\""sv));
+        }
+        break;
+    default:
+        break;
+    }
+
+    for (auto operand : function.operands_of(value)) {
+        size += TRY(out.write(" %"sv, operand.raw()));
+    }
+    size += TRY(out.writeln(""sv));
+    return size;
+}
+
+}
@@ -0,0 +1,315 @@
+#pragma once
+#include "./Parse.h"
+#include "./Source.h"
+#include "./Token.h"
+
+#include <Ty/ErrorOr.h>
+#include <Ty/Id.h>
+#include <Ty/StringBuffer.h>
+#include <Ty/StringView.h>
+#include <Ty/Vector.h>
+#include <Ty/View.h>
+
+// Typed SSA form sitting between the parse tree and codegen. Every
+// function owns flat arrays of instructions, operands and blocks, and
+// everything refers to everything else by index, so a whole function is
+// a handful of allocations no matter how large it grows.
+namespace IR {
+
+struct Inst;
+struct Block;
+struct Function;
+struct Shape;
+struct Class;
+
+using Value = Id<Inst>;
+using BlockId = Id<Block>;
+using FunctionId = Id<Function>;
+using ShapeId = Id<Shape>;
+using ClassId = Id<Class>;
+
+struct Operands {
+    u32 start { 0 };
+    u32 count { 0 };
+};
+
+struct Inst {
+    enum Kind : u8 {
+        nop,
+        undef,
+
+        constant_number,
+        constant_string,
+        constant_boolean,
+        // An array worked out at compile time, holding its operands. It
+        // lives in static storage rather than being built when it's used.
+        constant_array,
+        param,
+        phi,
+
+        object,
+        get_field,
+        wrap,
+        unwrap,
+        get_tag,
+
+        // Instances of classes are only referred to, so a field stored
+        // through one reference is seen through every other. upcast makes
+        // an instance usable where its base class is expected, and
+        // free_object gives one nothing refers to anymore back to its pool.
+        new_object,
+        load_field,
+        store_field,
+        upcast,
+        free_object,
+
+        // Arrays only ever grow by push, which gives a new array one
+        // element longer sharing storage with the one it was made from.
+        // The operand of create_array is how many elements it has room for.
+        // get_element checks its index against the length unless its
+        // boolean says a pass proved it in range, and check_length fails
+        // when the array is shorter than its second operand, so one check
+        // before a loop can stand in for every one in it.
+        create_array,
+        push,
+        length,
+        get_element,
+        check_length,
+
+        not_,
+        add,
+        sub,
+        lt,
+        lt_eq,
+        strict_eq,
+        match_string,
+        to_number,
+        to_index,
+
+        // Joins its operands, strings and numbers, into one new string.
+        // Chains of `+` on strings and template literals each become a
+        // single concat, so no string is built only to be copied again.
+        concat,
+
+        call,
+        call_method,
+        // Calls the method in slot as.index of whichever class its first
+        // operand turns out to be an instance of.
+        call_virtual,
+
+        // Suspends the async function it's in until the promise it's given
+        // settles, then gives what it settled with or throws what it was
+        // rejected with.
+        await_,
+
+        jump,
+        branch,
+        switch_,
+        ret,
+        throw_,
+    };
+
+    struct Method {
+        Token object;
+        Token member;
+    };
+
+    struct Branch {
+        BlockId then_;
+        BlockId else_;
+    };
+
+    // Jumps to the target at index operand + 1, or to the first one when
+    // the operand is past the last.
+    struct Switch {
+        u32 start;
+        u32 count;
+    };
+
+    // Gives the index of the operand among the listed strings, or their
+    // count when it's none of them. The seed picks a hash that puts every
+    // string in its own slot, so finding the candidate takes one hash and
+    // one compare no matter how many strings there are.
+    struct Strings {
+        u32 start;
+        u32 count;
+        u32 seed;
+        u32 bits;
+    };
+
+    bool is_terminator() const { return kind >= jump; }
+    bool has_side_effects() const;
+
+    Kind kind { nop };
+    Type type {};
+    ShapeId shape {};
+    Operands operands {};
+    union {
+        f64 number;
+        StringView string;
+        bool boolean;
+        u32 index;
+        FunctionId callee;
+        Method method;
+        BlockId target;
+        Branch branch;
+        Switch switch_;
+        Strings strings;
+    } as { 0.0 };
+};
+
+struct Block {
+    Vector<Value> phis {};
+    Vector<Value> insts {};
+    Vector<BlockId> preds {};
+
+    bool is_removed() const { return insts.is_empty(); }
+    Value terminator() const { return insts.last(); }
+};
+
+struct Function {
+    StringView name {};
+    Vector<Value> params {};
+    Type return_type {};
+    ShapeId return_shape {};
+
+    Vector<Inst> insts {};
+    Vector<Value> operands {};
+    Vector<Block> blocks {};
+    Vector<BlockId> targets {};
+    Vector<StringView> strings {};
+
+    bool may_throw { true };
+    bool is_exported { false };
+
+    // Calls give a promise of return_type instead of the value itself.
+    bool is_async { false };
+
+    static constexpr BlockId entry = BlockId(0);
+
+    Inst& operator[](Value value) { return insts[value]; }
+    Inst const& operator[](Value value) const { return insts[value]; }
+
+    Block& operator[](BlockId block) { return blocks[block]; }
+    Block const& operator[](BlockId block) const { return blocks[block]; }
+
+    View<Value> operands_of(Value);
+    View<Value const> operands_of(Value) const;
+
+    View<BlockId> targets_of(Value);
+    View<BlockId const> targets_of(Value) const;
+
+    View<StringView const> strings_of(Value) const;
+
+    ErrorOr<Vector<BlockId>> successors(BlockId) const;
+
+    ErrorOr<BlockId> create_block();
+    ErrorOr<Value> create_value(Inst);
+    ErrorOr<Operands> create_operands(View<Value const>);
+    ErrorOr<Inst::Switch> create_targets(View<BlockId const>);
+    ErrorOr<Inst::Strings> create_strings(View<StringView const>, u32 seed, u32 bits);
+
+    ErrorOr<Value> append(BlockId, Inst);
+    ErrorOr<Value> append(BlockId, Inst, View<Value const> operands);
+
+    ErrorOr<Vector<u32>> count_uses() const;
+    void replace_all_uses(Value of, Value with);
+    ErrorOr<void> remove_predecessor(BlockId block, u32 index);
+};
+
+// The layout of an object literal or object type. Object typed values
+// also carry the shape they were created with. Optional fields are
+// followed, after every other field, by a boolean `name?` field telling
+// whether they are present.
+struct Shape {
+    Vector<StringView> fields {};
+    Vector<Type> types {};
+    Vector<ShapeId> shapes {};
+
+    // Discriminated unions hold one of the variant shapes instead, told
+    // apart by which of the tags their `tag` field has.
+    StringView tag {};
+    Vector<StringView> tags {};
+    Vector<ShapeId> variants {};
+
+    Optional<u32> find(StringView field) const;
+    Optional<u32> find_presence(StringView field) const;
+    Optional<u32> find_variant(StringView tag) const;
+
+    // Arrays of this shape keep each field in an array of its own, so
+    // loops reading one field only touch that field's memory.
+    bool is_columnar { false };
+
+    bool is_union() const { return !variants.is_empty(); }
+
+    static bool is_presence(StringView field);
+};
+
+// A class keeps the methods of its base in the same slots, with the ones
+// it overrides pointing at its own functions, and the fields of its base
+// come first in its shape. Methods take the instance as their first
+// parameter.
+struct Class {
+    StringView name {};
+    ShapeId shape {};
+    ClassId base {};
+    FunctionId constructor {};
+    Vector<StringView> methods {};
+    Vector<FunctionId> implementations {};
+
+    // Fields of its own a profile showed are rarely used, by index in its
+    // shape. They live in a part allocated along with the instance.
+    Vector<bool> is_cold {};
+};
+
+// Where main computes one of the program's top-level constants, from
+// start_index in start up to end_index in end. Blocks first_block up to
+// last_block were made for it, and nothing outside jumps into them.
+struct Initializer {
+    BlockId start {};
+    u32 start_index { 0 };
+    BlockId end {};
+    u32 end_index { 0 };
+    u32 first_block { 0 };
+    u32 last_block { 0 };
+};
+
+struct Module {
+    Source source {};
+    Vector<Function> functions {};
+    Vector<Shape> shapes {};
+    FunctionId main {};
+    Vector<Initializer> initializers {};
+    Vector<Class> classes {};
+
+    Function& operator[](FunctionId id) { return functions[id]; }
+    Function const& operator[](FunctionId id) const { return functions[id]; }
+
+    Shape& operator[](ShapeId id) { return shapes[id]; }
+    Shape const& operator[](ShapeId id) const { return shapes[id]; }
+
+    Class& operator[](ClassId id) { return classes[id]; }
+    Class const& operator[](ClassId id) const { return classes[id]; }
+
+    Optional<FunctionId> find(StringView name) const;
+    Optional<ClassId> find_class(ShapeId) const;
+    bool is_subclass(ClassId, ClassId of) const;
+
+    // The class highest up the hierarchy that has the slot, which is
+    // where a call through the slot is declared.
+    ClassId introducing(ClassId, u32 slot) const;
+
+    // Every function a call through the slot could reach on an instance
+    // of the class or of any class derived from it, each once.
+    ErrorOr<Vector<FunctionId>> implementations(ClassId, u32 slot) const;
+    bool dispatch_may_throw(ClassId, u32 slot) const;
+};
+
+// Where a string lands in a hash table of 2^bits slots.
+u64 hash_multiplier(u32 seed);
+u32 hash_slot(StringView, u32 seed, u32 bits);
+
+StringView kind_name(Inst::Kind);
+ErrorOr<StringBuffer> dump(Module const&);
+
+}
@@ -0,0 +1,147 @@
+#include "./Passes.h"
+
+using IR::FunctionId;
+using IR::Inst;
+using IR::Value;
+
+static bool is_identical(IR::Module const&, FunctionId, FunctionId);
+static bool is_identical(IR::Module const&, FunctionId, FunctionId, Value);
+template <typename T>
+static bool is_identical(View<T const>, View<T const>);
+
+ErrorOr<bool> fold_identical_functions(IR::Module& module)
+{
+    // Instances of a generic function often come out the same, e.g. when
+    // a type argument is only passed along. Calls to a copy are sent to
+    // the first function it matches, and the copy is left unused.
+    auto canonical = TRY(Vector<FunctionId>::create(module.functions.size()));
+    bool changed = false;
+    for (u32 i = 0; i < module.functions.size(); i++) {
+        auto id = FunctionId(i);
+        TRY(canonical.append(id));
+        if (id == module.main || module[id].is_exported) {
+            continue;
+        }
+        for (u32 j = 0; j < i; j++) {
+            if (canonical[j] == FunctionId(j) && FunctionId(j) != module.main && is_identical(module, FunctionId(j), id)) {
+                canonical[i] = FunctionId(j);
+                changed = true;
+                break;
+            }
+        }
+    }
+    if (!changed) {
+        return false;
+    }
+
+    for (auto& function : module.functions) {
+        for (auto& inst : function.insts) {
+            if (inst.kind == Inst::call) {
+                inst.as.callee = canonical[inst.as.callee.raw()];
+            }
+        }
+    }
+    return true;
+}
+
+static bool is_identical(IR::Module const& module, FunctionId a_id, FunctionId b_id)
+{
+    auto const& a = module[a_id];
+    auto const& b = module[b_id];
+    if (!a.return_type.is_same(b.return_type) || a.return_shape != b.return_shape || a.may_throw != b.may_throw || a.is_async != b.is_async) {
+        return false;
+    }
+    if (!is_identical(a.params.view(), b.params.view())) {
+        return false;
+    }
+    if (a.insts.size() != b.insts.size() || a.blocks.size() != b.blocks.size()) {
+        return false;
+    }
+    for (u32 i = 0; i < a.insts.size(); i++) {
+        if (!is_identical(module, a_id, b_id, Value(i))) {
+            return false;
+        }
+    }
+    for (u32 i = 0; i < a.blocks.size(); i++) {
+        auto const& a_block = a.blocks[i];
+        auto const& b_block = b.blocks[i];
+        if (!is_identical(a_block.phis.view(), b_block.phis.view())
+            || !is_identical(a_block.insts.view(), b_block.insts.view())
+            || !is_identical(a_block.preds.view(), b_block.preds.view())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool is_identical(IR::Module const& module, FunctionId a_id, FunctionId b_id, Value value)
+{
+    auto const& a = module[a_id][value];
+    auto const& b = module[b_id][value];
+    if (a.kind != b.kind) {
+        return false;
+    }
+    if (a.kind == Inst::nop) {
+        return true;
+    }
+    if (!a.type.is_same(b.type) || a.shape != b.shape) {
+        return false;
+    }
+    if (!is_identical(module[a_id].operands_of(value), module[b_id].operands_of(value))) {
+        return false;
+    }
+
+    auto file = module.source.file;
+    switch (a.kind) {
+    case Inst::constant_number:
+        return a.as.number == b.as.number;
+    case Inst::constant_string:
+        return a.as.string == b.as.string;
+    case Inst::constant_boolean:
+    case Inst::get_element:
+        return a.as.boolean == b.as.boolean;
+    case Inst::param:
+    case Inst::get_field:
+    case Inst::wrap:
+    case Inst::unwrap:
+    case Inst::load_field:
+    case Inst::store_field:
+    case Inst::call_virtual:
+        return a.as.index == b.as.index;
+    case Inst::call:
+        // Functions that only differ in calling themselves are the same.
+        if (a.as.callee == a_id && b.as.callee == b_id) {
+            return true;
+        }
+        return a.as.callee == b.as.callee;
+    case Inst::call_method:
+        return a.as.method.object.view_in(file) == b.as.method.object.view_in(file)
+            && a.as.method.member.view_in(file) == b.as.method.member.view_in(file);
+    case Inst::jump:
+        return a.as.target == b.as.target;
+    case Inst::branch:
+        return a.as.branch.then_ == b.as.branch.then_ && a.as.branch.else_ == b.as.branch.else_;
+    case Inst::switch_:
+        return is_identical(module[a_id].targets_of(value), module[b_id].targets_of(value));
+    case Inst::match_string:
+        return a.as.strings.seed == b.as.strings.seed
+            && a.as.strings.bits == b.as.strings.bits
+            && is_identical(module[a_id].strings_of(value), module[b_id].strings_of(value));
+    default:
+        return true;
+    }
+}
+
+template <typename T>
+static bool is_identical(View<T const> a, View<T const> b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (u32 i = 0; i < a.size(); i++) {
+        if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
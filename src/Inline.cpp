@@ -0,0 +1,276 @@
+#include "./Passes.h"
+
+using IR::BlockId;
+using IR::FunctionId;
+using IR::Inst;
+using IR::Value;
+
+// Functions at most this large are inlined wherever they're called,
+// functions with a single caller may be up to max_single_call_size.
+static constexpr u32 max_inline_size = 16;
+static constexpr u32 max_single_call_size = 64;
+
+// Stop inlining into functions that have grown past this.
+static constexpr u32 max_caller_size = 512;
+
+static ErrorOr<bool> is_recursive(IR::Module const&, FunctionId);
+static ErrorOr<Vector<u32>> count_call_sites(IR::Module const&);
+static u32 inline_size(IR::Function const&);
+static ErrorOr<void> inline_call(IR::Function& caller, BlockId, u32 index, IR::Function const& callee);
+
+ErrorOr<bool> inline_functions(IR::Module& module)
+{
+    auto call_sites = TRY(count_call_sites(module));
+    auto can_inline = TRY(Vector<bool>::create(module.functions.size()));
+    for (u32 i = 0; i < module.functions.size(); i++) {
+        auto id = FunctionId(i);
+        auto size = inline_size(module[id]);
+        bool is_small = size <= max_inline_size || (call_sites[i] == 1 && size <= max_single_call_size);
+        TRY(can_inline.append(id != module.main && !module[id].is_async && is_small && !TRY(is_recursive(module, id))));
+    }
+
+    bool changed = false;
+    for (auto& caller : module.functions) {
+        for (u32 i = 0; i < caller.blocks.size(); i++) {
+            auto block = BlockId(i);
+            for (u32 j = 0; j < caller[block].insts.size(); j++) {
+                auto const& inst = caller[caller[block].insts[j]];
+                if (inst.kind != Inst::call || !can_inline[inst.as.callee.raw()]) {
+                    continue;
+                }
+                if (inline_size(caller) > max_caller_size) {
+                    break;
+                }
+                auto const& callee = module[inst.as.callee];
+                if (&callee == &caller) {
+                    continue;
+                }
+                TRY(inline_call(caller, block, j, callee));
+                changed = true;
+                // Everything after the call moved to a new block, which
+                // will be visited later.
+                break;
+            }
+        }
+    }
+    return changed;
+}
+
+static ErrorOr<bool> is_recursive(IR::Module const& module, FunctionId id)
+{
+    auto visited = TRY(Vector<bool>::create(module.functions.size()));
+    for (u32 i = 0; i < module.functions.size(); i++) {
+        TRY(visited.append(false));
+    }
+    auto worklist = Vector<FunctionId>();
+    TRY(worklist.append(id));
+    while (!worklist.is_empty()) {
+        auto const& function = module[*worklist.pop()];
+        for (auto const& block : function.blocks) {
+            for (auto value : block.insts.view()) {
+                auto const& inst = function[value];
+                if (inst.kind != Inst::call) {
+                    continue;
+                }
+                if (inst.as.callee == id) {
+                    return true;
+                }
+                if (!visited[inst.as.callee.raw()]) {
+                    visited[inst.as.callee.raw()] = true;
+                    TRY(worklist.append(inst.as.callee));
+                }
+            }
+        }
+    }
+    return false;
+}
+
+static ErrorOr<Vector<u32>> count_call_sites(IR::Module const& module)
+{
+    auto call_sites = TRY(Vector<u32>::create(module.functions.size()));
+    for (u32 i = 0; i < module.functions.size(); i++) {
+        TRY(call_sites.append(0));
+    }
+    for (auto const& function : module.functions) {
+        for (auto const& block : function.blocks) {
+            for (auto value : block.insts.view()) {
+                auto const& inst = function[value];
+                if (inst.kind == Inst::call) {
+                    call_sites[inst.as.callee.raw()]++;
+                }
+            }
+        }
+    }
+    return call_sites;
+}
+
+static u32 inline_size(IR::Function const& function)
+{
+    u32 size = 0;
+    for (auto const& block : function.blocks) {
+        size += block.phis.size();
+        for (auto value : block.insts.view()) {
+            switch (function[value].kind) {
+            case Inst::param:
+            case Inst::jump:
+            case Inst::constant_number:
+            case Inst::constant_string:
+            case Inst::constant_boolean:
+            case Inst::constant_array:
+                break;
+            default:
+                size++;
+            }
+        }
+    }
+    return size;
+}
+
+static ErrorOr<void> inline_call(IR::Function& caller, BlockId block, u32 index, IR::Function const& callee)
+{
+    auto call = caller[block].insts[index];
+    auto return_type = caller[call].type;
+    auto args = Vector<Value>();
+    for (auto arg : caller.operands_of(call)) {
+        TRY(args.append(arg));
+    }
+
+    // Split the calling block: everything after the call continues in a
+    // new block that the inlined returns jump to.
+    auto rest = TRY(caller.create_block());
+    for (u32 i = index + 1; i < caller[block].insts.size(); i++) {
+        TRY(caller[rest].insts.append(caller[block].insts[i]));
+    }
+    auto head = TRY(Vector<Value>::create(index + 1));
+    for (u32 i = 0; i <= index; i++) {
+        TRY(head.append(caller[block].insts[i]));
+    }
+    caller[block].insts = move(head);
+
+    for (auto successor : TRY(caller.successors(rest))) {
+        for (auto& pred : caller[successor].preds) {
+            if (pred == block) {
+                pred = rest;
+            }
+        }
+    }
+
+    // Copy every callee value and block, then patch up references now
+    // that everything has a place in the caller.
+    auto values = TRY(Vector<Value>::create(callee.insts.size()));
+    for (u32 i = 0; i < callee.insts.size(); i++) {
+        auto const& inst = callee.insts[i];
+        if (inst.kind == Inst::param) {
+            TRY(values.append(args[inst.as.index]));
+            continue;
+        }
+        auto copy = inst;
+        copy.operands = {};
+        if (inst.kind == Inst::match_string) {
+            auto strings = inst.as.strings;
+            copy.as.strings = TRY(caller.create_strings(callee.strings_of(Value(i)), strings.seed, strings.bits));
+        }
+        TRY(values.append(TRY(caller.create_value(copy))));
+    }
+
+    auto blocks = TRY(Vector<BlockId>::create(callee.blocks.size()));
+    for (u32 i = 0; i < callee.blocks.size(); i++) {
+        if (callee.blocks[i].is_removed()) {
+            TRY(blocks.append(BlockId()));
+            continue;
+        }
+        TRY(blocks.append(TRY(caller.create_block())));
+    }
+
+    auto returns = Vector<Value>();
+    for (u32 i = 0; i < callee.blocks.size(); i++) {
+        auto const& from = callee.blocks[i];
+        if (from.is_removed()) {
+            continue;
+        }
+        auto to = blocks[i];
+        for (auto pred : from.preds.view()) {
+            TRY(caller[to].preds.append(blocks[pred.raw()]));
+        }
+        for (auto phi : from.phis.view()) {
+            TRY(caller[to].phis.append(values[phi.raw()]));
+        }
+        for (auto value : from.insts.view()) {
+            if (callee[value].kind == Inst::param) {
+                continue;
+            }
+            TRY(caller[to].insts.append(values[value.raw()]));
+        }
+
+        auto terminator = values[from.terminator().raw()];
+        switch (caller[terminator].kind) {
+        case Inst::jump:
+            caller[terminator].as.target = blocks[caller[terminator].as.target.raw()];
+            break;
+        case Inst::branch: {
+            auto& branch = caller[terminator].as.branch;
+            branch.then_ = blocks[branch.then_.raw()];
+            branch.else_ = blocks[branch.else_.raw()];
+        } break;
+        case Inst::switch_: {
+            auto targets = Vector<BlockId>();
+            for (auto target : callee.targets_of(from.terminator())) {
+                TRY(targets.append(blocks[target.raw()]));
+            }
+            caller[terminator].as.switch_ = TRY(caller.create_targets(targets.view()));
+        } break;
+        case Inst::ret: {
+            auto operands = callee.operands_of(from.terminator());
+            if (operands.size() != 0) {
+                TRY(returns.append(values[operands[0].raw()]));
+            }
+            caller[terminator] = Inst {
+                .kind = Inst::jump,
+                .type = Type::void_,
+                .as = { .target = rest },
+            };
+            TRY(caller[rest].preds.append(to));
+        } break;
+        default:
+            break;
+        }
+    }
+
+    for (u32 i = 0; i < callee.insts.size(); i++) {
+        auto const& inst = callee.insts[i];
+        if (inst.kind == Inst::param || inst.kind == Inst::ret || inst.operands.count == 0) {
+            continue;
+        }
+        auto operands = Vector<Value>();
+        for (auto operand : callee.operands_of(Value(i))) {
+            TRY(operands.append(values[operand.raw()]));
+        }
+        caller[values[i]].operands = TRY(caller.create_operands(operands.view()));
+    }
+
+    // The call's result is whatever reached the return, which needs a phi
+    // when there's more than one way to get there.
+    auto result = Value();
+    if (return_type == Type::void_) {
+        result = call;
+    } else if (returns.is_empty()) {
+        result = TRY(caller.create_value(Inst { .kind = Inst::undef, .type = return_type, .shape = caller[call].shape }));
+    } else if (returns.size() == 1) {
+        result = returns[0];
+    } else {
+        result = TRY(caller.create_value(Inst { .kind = Inst::phi, .type = return_type, .shape = caller[call].shape }));
+        caller[result].operands = TRY(caller.create_operands(returns.view()));
+        TRY(caller[rest].phis.append(result));
+    }
+    if (result != call) {
+        caller.replace_all_uses(call, result);
+    }
+
+    caller[call] = Inst {
+        .kind = Inst::jump,
+        .type = Type::void_,
+        .as = { .target = blocks[IR::Function::entry.raw()] },
+    };
+    TRY(caller[blocks[IR::Function::entry.raw()]].preds.append(block));
+    return {};
+}
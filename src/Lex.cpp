@@ -14,9 +14,29 @@ const FixedToken keywords_and_types[] = {
     { Token::kw_throw,      "throw"sv },
     { Token::kw_return,     "return"sv },
     { Token::kw_const,      "const"sv },
+    { Token::kw_export,     "export"sv },
+    { Token::kw_interface,  "interface"sv },
+    { Token::kw_type,       "type"sv },
+    { Token::kw_in,         "in"sv },
+    { Token::kw_switch,     "switch"sv },
+    { Token::kw_case,       "case"sv },
+    { Token::kw_default,    "default"sv },
+    { Token::kw_break,      "break"sv },
+    { Token::kw_for,        "for"sv },
+    { Token::kw_of,         "of"sv },
+    { Token::kw_let,        "let"sv },
+    { Token::kw_async,      "async"sv },
+    { Token::kw_await,      "await"sv },
+    { Token::kw_yield,      "yield"sv },
+    { Token::kw_as,         "as"sv },
+    { Token::kw_readonly,   "readonly"sv },
+    { Token::kw_class,      "class"sv },
+    { Token::kw_extends,    "extends"sv },
+    { Token::kw_new,        "new"sv },
 
     { Token::type_boolean,  "boolean"sv },
     { Token::type_number,   "number"sv },
+    { Token::type_string,   "string"sv },
     { Token::type_void,     "void"sv },
 };
 
@@ -27,18 +47,26 @@ const FixedToken symbols_and_ops[] = {
     { Token::sym_lcurly,    "{"sv },
     { Token::sym_rcurly,    "}"sv },
 
+    { Token::sym_lbracket,  "["sv },
+    { Token::sym_rbracket,  "]"sv },
+
     { Token::sym_fat_arrow, "=>"sv },
     { Token::sym_colon,     ":"sv },
     { Token::sym_semicolon, ";"sv },
     { Token::sym_dot,       "."sv },
     { Token::sym_comma,     ","sv },
+    { Token::sym_question,  "?"sv },
+    { Token::sym_pipe,      "|"sv },
+    { Token::sym_star,      "*"sv },
 
     { Token::op_lt_eq,      "<="sv },
+    { Token::op_lt,         "<"sv },
+    { Token::op_gt,         ">"sv },
     { Token::op_minus,      "-"sv },
     { Token::op_plus,       "+"sv },
+    { Token::op_triple_eq,  "==="sv },
     { Token::op_assign,     "="sv },
     { Token::op_bang,       "!"sv },
-    { Token::op_triple_eq,  "==="sv },
 };
 
 static bool is_keyword_delim(StringView c)
@@ -59,6 +87,10 @@ ErrorOr<Vector<Token>, LexError> lex(Source source)
 {
     auto tokens = Vector<Token>();
 
+    // How many braces deep each substitution of the template literals
+    // being lexed is, so the `}` that ends it is told apart.
+    auto substitutions = Vector<u32>();
+
     auto file = source.file;
     u32 pos = 0;
     while(pos < file.size()) {
@@ -69,6 +101,25 @@ ErrorOr<Vector<Token>, LexError> lex(Source source)
             pos++;
             goto next_token;
         }
+        if (file[pos] == '`' || (file[pos] == '}' && !substitutions.is_empty() && substitutions.last() == 0)) {
+            if (file[pos] == '}') {
+                (void)substitutions.pop();
+            }
+            auto start = pos;
+            pos += relex_template_size(file, pos);
+            if (file.sub_view(pos, "${"sv.size()) == "${"sv) {
+                TRY(tokens.append(Token(Token::lit_template_head, start)));
+                TRY(substitutions.append(0));
+                pos += "${"sv.size();
+                goto next_token;
+            }
+            if (pos >= file.size()) {
+                return LexError::from_string_literal(source, start, "expected end of template literal");
+            }
+            TRY(tokens.append(Token(Token::lit_template, start)));
+            pos++;
+            goto next_token;
+        }
         for (auto keyword_or_type : keywords_and_types) {
             auto part = file.sub_view(pos, keyword_or_type.name.size());
             if (part == keyword_or_type.name) {
@@ -84,11 +135,17 @@ ErrorOr<Vector<Token>, LexError> lex(Source source)
             if (part == symbol_or_op.name) {
                 TRY(tokens.append(Token(symbol_or_op.kind, pos)));
                 pos += part.size();
+                if (!substitutions.is_empty() && symbol_or_op.kind == Token::sym_lcurly) {
+                    substitutions.last()++;
+                }
+                if (!substitutions.is_empty() && symbol_or_op.kind == Token::sym_rcurly) {
+                    substitutions.last()--;
+                }
                 goto next_token;
             }
         }
 
-        if (file[pos] == '"' || file[pos] == '\'' || file[pos] == '`') {
+        if (file[pos] == '"' || file[pos] == '\'') {
             auto token = Token(Token::lit_string, pos);
             TRY(tokens.append(token));
             pos += relex_string_size(file, pos) + 1;
@@ -146,6 +203,7 @@ next_token:;
 u32 relex_ident_size(StringView file, u32 pos);
 u32 relex_number_size(StringView file, u32 pos);
 u32 relex_string_size(StringView file, u32 pos);
+u32 relex_template_size(StringView file, u32 pos);
 
 u32 relex_ident_size(StringView file, u32 pos)
 {
@@ -190,6 +248,17 @@ u32 relex_string_size(StringView file, u32 pos)
     return size;
 }
 
+u32 relex_template_size(StringView file, u32 pos)
+{
+    u32 size = 1;
+    for (pos++; pos < file.size(); pos++, size++) {
+        if (file[pos] == '`' || file.sub_view(pos, "${"sv.size()) == "${"sv) {
+            break;
+        }
+    }
+    return size;
+}
+
 LexError LexError::from_string_literal(Source source, u32 pos, c_string message, c_string func)
 {
     return LexError(source, pos, message, func);
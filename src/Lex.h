@@ -31,3 +31,4 @@ ErrorOr<Vector<Token>, LexError> lex(Source source);
 u32 relex_ident_size(StringView file, u32 pos);
 u32 relex_number_size(StringView file, u32 pos);
 u32 relex_string_size(StringView file, u32 pos);
+u32 relex_template_size(StringView file, u32 pos);
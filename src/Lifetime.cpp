@@ -0,0 +1,163 @@
+#include "./Passes.h"
+
+using IR::BlockId;
+using IR::Inst;
+using IR::Value;
+
+struct Uses {
+    // Indexed by the instance a value refers to, with upcasts seen
+    // through.
+    Vector<bool> escapes {};
+    Vector<bool> is_used_elsewhere {};
+    Vector<bool> is_freed {};
+};
+
+static ErrorOr<Vector<Vector<bool>>> find_escaping_params(IR::Module const&);
+static ErrorOr<Uses> find_uses(IR::Function const&, View<Vector<bool> const> escaping_params);
+static ErrorOr<Vector<BlockId>> find_definitions(IR::Function const&);
+static Value strip_upcasts(IR::Function const&, Value);
+
+ErrorOr<bool> free_dead_objects(IR::Module& module)
+{
+    // An instance made with new that never escapes the block it was made
+    // in is dead by the end of it, so it goes back to the pool there.
+    auto escaping_params = TRY(find_escaping_params(module));
+    bool changed = false;
+    for (auto& function : module.functions) {
+        auto uses = TRY(find_uses(function, escaping_params.view()));
+        auto defined_in = TRY(find_definitions(function));
+        for (u32 i = 0; i < function.insts.size(); i++) {
+            if (function.insts[i].kind != Inst::new_object || uses.escapes[i] || uses.is_used_elsewhere[i] || uses.is_freed[i]) {
+                continue;
+            }
+            auto object = Value(i);
+            auto free = TRY(function.create_value(Inst {
+                .kind = Inst::free_object,
+                .type = Type::void_,
+                .operands = TRY(function.create_operands(View(&object, 1))),
+            }));
+            auto& insts = function[defined_in[i]].insts;
+            auto terminator = TRY(insts.pop().or_throw([] {
+                return Error::from_string_literal("block has no terminator");
+            }));
+            TRY(insts.append(free));
+            TRY(insts.append(terminator));
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static ErrorOr<Vector<Vector<bool>>> find_escaping_params(IR::Module const& module)
+{
+    // Whether each parameter of each function may outlive the call, which
+    // depends on the functions it's passed on to. Async functions keep
+    // theirs for as long as they're suspended.
+    auto escaping = TRY(Vector<Vector<bool>>::create(module.functions.size()));
+    for (auto const& function : module.functions) {
+        auto params = TRY(Vector<bool>::create(function.params.size()));
+        for (u32 i = 0; i < function.params.size(); i++) {
+            TRY(params.append(function.is_async));
+        }
+        TRY(escaping.append(move(params)));
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (u32 i = 0; i < module.functions.size(); i++) {
+            auto const& function = module.functions[i];
+            auto uses = TRY(find_uses(function, escaping.view()));
+            for (u32 j = 0; j < function.params.size(); j++) {
+                if (!escaping[i][j] && uses.escapes[function.params[j].raw()]) {
+                    escaping[i][j] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+    return escaping;
+}
+
+static ErrorOr<Uses> find_uses(IR::Function const& function, View<Vector<bool> const> escaping_params)
+{
+    // Instances may only have their fields read and written, be passed
+    // to functions that don't keep them, or be freed. Anything else, like
+    // being stored, returned or merged by a phi, lets them escape.
+    auto defined_in = TRY(find_definitions(function));
+    auto uses = Uses();
+    uses.escapes = TRY(Vector<bool>::create(function.insts.size()));
+    uses.is_used_elsewhere = TRY(Vector<bool>::create(function.insts.size()));
+    uses.is_freed = TRY(Vector<bool>::create(function.insts.size()));
+    for (u32 i = 0; i < function.insts.size(); i++) {
+        TRY(uses.escapes.append(false));
+        TRY(uses.is_used_elsewhere.append(false));
+        TRY(uses.is_freed.append(false));
+    }
+
+    auto mark_operands = [&](BlockId block, Value user) {
+        auto const& inst = function[user];
+        auto operands = function.operands_of(user);
+        for (u32 i = 0; i < operands.size(); i++) {
+            auto object = strip_upcasts(function, operands[i]);
+            if (function[object].type != Type::instance) {
+                continue;
+            }
+            if (defined_in[object.raw()] != block) {
+                uses.is_used_elsewhere[object.raw()] = true;
+            }
+            switch (inst.kind) {
+            case Inst::load_field:
+            case Inst::upcast:
+                continue;
+            case Inst::store_field:
+                uses.escapes[object.raw()] |= i != 0;
+                continue;
+            case Inst::free_object:
+                uses.is_freed[object.raw()] = true;
+                continue;
+            case Inst::call:
+                uses.escapes[object.raw()] |= escaping_params[inst.as.callee.raw()][i];
+                continue;
+            default:
+                uses.escapes[object.raw()] = true;
+                continue;
+            }
+        }
+    };
+
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        for (auto phi : function.blocks[i].phis.view()) {
+            mark_operands(BlockId(i), phi);
+        }
+        for (auto value : function.blocks[i].insts.view()) {
+            mark_operands(BlockId(i), value);
+        }
+    }
+    return uses;
+}
+
+static ErrorOr<Vector<BlockId>> find_definitions(IR::Function const& function)
+{
+    // Parameters and values not in any block are treated as defined
+    // outside every block.
+    auto defined_in = TRY(Vector<BlockId>::create(function.insts.size()));
+    for (u32 i = 0; i < function.insts.size(); i++) {
+        TRY(defined_in.append(BlockId()));
+    }
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        for (auto phi : function.blocks[i].phis.view()) {
+            defined_in[phi.raw()] = BlockId(i);
+        }
+        for (auto value : function.blocks[i].insts.view()) {
+            defined_in[value.raw()] = BlockId(i);
+        }
+    }
+    return defined_in;
+}
+
+static Value strip_upcasts(IR::Function const& function, Value value)
+{
+    while (function[value].kind == Inst::upcast) {
+        value = function.operands_of(value)[0];
+    }
+    return value;
+}
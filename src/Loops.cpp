@@ -0,0 +1,556 @@
+#include "./Passes.h"
+
+using IR::BlockId;
+using IR::Inst;
+using IR::Value;
+
+// A natural loop entered only through its header, which is only entered
+// from outside through the preheader.
+struct Loop {
+    BlockId header;
+    BlockId preheader;
+    Vector<bool> contains {};
+};
+
+static ErrorOr<bool> hoist_loop_invariants(IR::Function&);
+static ErrorOr<bool> form_counted_loops(IR::Function&);
+static ErrorOr<bool> form_counted_loop(IR::Function&, Loop const&);
+static ErrorOr<bool> remove_bounds_checks(IR::Function&);
+static ErrorOr<bool> remove_bounds_checks(IR::Function&, Loop const&, View<BlockId const> dominators, View<BlockId const> defined_in);
+static bool runs_to_completion(IR::Function const&, Loop const&);
+static ErrorOr<Vector<Loop>> find_loops(IR::Function const&, View<BlockId const> dominators);
+static ErrorOr<Vector<BlockId>> find_dominators(IR::Function const&);
+static bool dominates(View<BlockId const> dominators, BlockId, BlockId);
+static ErrorOr<Vector<BlockId>> find_definitions(IR::Function const&);
+static bool is_hoistable(Inst const&);
+static bool is_whole_index(Inst const&);
+static ErrorOr<void> insert_before_terminator(IR::Function&, BlockId, View<Value const>);
+
+ErrorOr<bool> hoist_loop_invariants(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(hoist_loop_invariants(function));
+    }
+    return changed;
+}
+
+ErrorOr<bool> form_counted_loops(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(form_counted_loops(function));
+    }
+    return changed;
+}
+
+ErrorOr<bool> remove_bounds_checks(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(remove_bounds_checks(function));
+    }
+    return changed;
+}
+
+static ErrorOr<bool> hoist_loop_invariants(IR::Function& function)
+{
+    // Values computed the same way on every trip around a loop, like the
+    // length of the array being walked, are computed once before it.
+    auto dominators = TRY(find_dominators(function));
+    auto loops = TRY(find_loops(function, dominators.view()));
+    auto defined_in = TRY(find_definitions(function));
+    bool changed = false;
+    for (auto const& loop : loops.view()) {
+        auto is_invariant = [&](Value value) {
+            auto block = defined_in[value.raw()];
+            return !block.is_valid() || !loop.contains[block.raw()];
+        };
+        auto hoisted = Vector<Value>();
+        for (u32 i = 0; i < function.blocks.size(); i++) {
+            if (!loop.contains[i]) {
+                continue;
+            }
+            auto& insts = function.blocks[i].insts;
+            auto kept = Vector<Value>();
+            for (auto value : insts.view()) {
+                bool is_hoisted = is_hoistable(function[value]);
+                for (auto operand : function.operands_of(value)) {
+                    is_hoisted = is_hoisted && is_invariant(operand);
+                }
+                if (is_hoisted) {
+                    TRY(hoisted.append(value));
+                    defined_in[value.raw()] = loop.preheader;
+                } else {
+                    TRY(kept.append(value));
+                }
+            }
+            insts = move(kept);
+        }
+        if (!hoisted.is_empty()) {
+            TRY(insert_before_terminator(function, loop.preheader, hoisted.view()));
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static ErrorOr<bool> form_counted_loops(IR::Function& function)
+{
+    auto dominators = TRY(find_dominators(function));
+    auto loops = TRY(find_loops(function, dominators.view()));
+    bool changed = false;
+    for (auto const& loop : loops.view()) {
+        changed |= TRY(form_counted_loop(function, loop));
+    }
+    return changed;
+}
+
+static ErrorOr<bool> form_counted_loop(IR::Function& function, Loop const& loop)
+{
+    // `for (let i = 0; i < xs.length; i = i + 1)` counts with a JS number.
+    // As long as it starts out whole, only grows by one and the loop stops
+    // at a length, it always fits an index, so it counts with one instead
+    // and indexes arrays without converting back and forth.
+    auto const& header = function[loop.header];
+    if (header.preds.size() != 2 || header.insts.is_empty()) {
+        return false;
+    }
+    auto terminator = header.terminator();
+    if (function[terminator].kind != Inst::branch) {
+        return false;
+    }
+    auto branch = function[terminator].as.branch;
+    if (!loop.contains[branch.then_.raw()] || loop.contains[branch.else_.raw()]) {
+        return false;
+    }
+    auto cond = function.operands_of(terminator)[0];
+    if (function[cond].kind != Inst::lt) {
+        return false;
+    }
+    auto counter = function.operands_of(cond)[0];
+    auto bound = function.operands_of(cond)[1];
+    if (function[counter].kind != Inst::phi || function[counter].type != Type::number || !header.phis.find(counter).has_value()) {
+        return false;
+    }
+    if (function[bound].kind != Inst::to_number || function[function.operands_of(bound)[0]].type != Type::index) {
+        return false;
+    }
+
+    auto uses = TRY(function.count_uses());
+    u32 outside = header.preds[0] == loop.preheader ? 0 : 1;
+    auto start = function.operands_of(counter)[outside];
+    auto next = function.operands_of(counter)[1 - outside];
+    if (!is_whole_index(function[start]) || function[next].kind != Inst::add || uses[next.raw()] != 1 || uses[cond.raw()] != 1) {
+        return false;
+    }
+    auto step = function.operands_of(next)[1];
+    if (function.operands_of(next)[0] != counter || function[step].kind != Inst::constant_number || function[step].as.number != 1.0) {
+        return false;
+    }
+
+    auto index_start = TRY(function.create_value(Inst {
+        .kind = Inst::constant_number,
+        .type = Type::index,
+        .as = { .number = function[start].as.number },
+    }));
+    auto index_step = TRY(function.create_value(Inst {
+        .kind = Inst::constant_number,
+        .type = Type::index,
+        .as = { .number = 1.0 },
+    }));
+    function[counter].type = Type::index;
+    function[next].type = Type::index;
+    function.operands_of(counter)[outside] = index_start;
+    function.operands_of(next)[1] = index_step;
+    function.operands_of(cond)[1] = function.operands_of(bound)[0];
+
+    // Everything else still sees a number. Unused, the conversion is
+    // removed with the rest of the dead values.
+    auto number = TRY(function.create_value(Inst { .kind = Inst::to_number, .type = Type::number }));
+    function[number].operands = TRY(function.create_operands(View(&counter, 1)));
+    auto insts = Vector<Value>();
+    TRY(insts.append(number));
+    for (auto value : function[loop.header].insts.view()) {
+        TRY(insts.append(value));
+    }
+    function[loop.header].insts = move(insts);
+    auto conversions = Vector<Value>();
+    for (u32 i = 0; i < function.insts.size(); i++) {
+        auto user = Value(i);
+        if (user == next || user == cond || user == number) {
+            continue;
+        }
+        if (function[user].kind == Inst::to_index && function.operands_of(user)[0] == counter) {
+            TRY(conversions.append(user));
+            continue;
+        }
+        for (auto& operand : function.operands_of(user)) {
+            if (operand == counter) {
+                operand = number;
+            }
+        }
+    }
+    for (auto conversion : conversions.view()) {
+        function.replace_all_uses(conversion, counter);
+    }
+    return true;
+}
+
+static ErrorOr<bool> remove_bounds_checks(IR::Function& function)
+{
+    auto dominators = TRY(find_dominators(function));
+    auto loops = TRY(find_loops(function, dominators.view()));
+    auto defined_in = TRY(find_definitions(function));
+    bool changed = false;
+    for (auto const& loop : loops.view()) {
+        changed |= TRY(remove_bounds_checks(function, loop, dominators.view(), defined_in.view()));
+    }
+    return changed;
+}
+
+static ErrorOr<bool> remove_bounds_checks(IR::Function& function, Loop const& loop, View<BlockId const> dominators, View<BlockId const> defined_in)
+{
+    // A counter growing by one that stops at the length of an array is
+    // always a valid index into it. Other arrays it indexes get one check
+    // before the loop instead, when the loop counts from zero and every
+    // trip reaches them without doing anything observable first, so
+    // failing early looks no different from failing on the way.
+    auto const& header = function[loop.header];
+    if (header.preds.size() != 2 || function[header.terminator()].kind != Inst::branch) {
+        return false;
+    }
+    auto branch = function[header.terminator()].as.branch;
+    if (!loop.contains[branch.then_.raw()] || loop.contains[branch.else_.raw()]) {
+        return false;
+    }
+    auto cond = function.operands_of(header.terminator())[0];
+    if (function[cond].kind != Inst::lt) {
+        return false;
+    }
+    auto counter = function.operands_of(cond)[0];
+    auto bound = function.operands_of(cond)[1];
+    // The length of a table worked out at compile time is a constant, which
+    // covers every table at least that long.
+    bool is_constant_bound = function[bound].kind == Inst::constant_number;
+    if (function[counter].type != Type::index || !header.phis.find(counter).has_value() || (function[bound].kind != Inst::length && !is_constant_bound)) {
+        return false;
+    }
+    auto array = is_constant_bound ? Value() : function.operands_of(bound)[0];
+
+    u32 outside = header.preds[0] == loop.preheader ? 0 : 1;
+    auto latch = header.preds[1 - outside];
+    auto start = function.operands_of(counter)[outside];
+    auto next = function.operands_of(counter)[1 - outside];
+    if (function[next].kind != Inst::add || function.operands_of(next)[0] != counter) {
+        return false;
+    }
+    auto step = function.operands_of(next)[1];
+    if (function[step].kind != Inst::constant_number || function[step].as.number != 1.0) {
+        return false;
+    }
+
+    auto is_invariant = [&](Value value) {
+        auto block = defined_in[value.raw()];
+        return !block.is_valid() || !loop.contains[block.raw()];
+    };
+    bool may_check_before = function[start].kind == Inst::constant_number
+        && function[start].as.number == 0.0
+        && is_invariant(bound)
+        && runs_to_completion(function, loop);
+
+    bool changed = false;
+    auto checked = Vector<Value>();
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        if (!loop.contains[i] || BlockId(i) == loop.header) {
+            continue;
+        }
+        for (u32 j = 0; j < function.blocks[i].insts.size(); j++) {
+            auto value = function.blocks[i].insts[j];
+            if (function[value].kind != Inst::get_element || function[value].as.boolean) {
+                continue;
+            }
+            auto object = function.operands_of(value)[0];
+            if (function.operands_of(value)[1] != counter) {
+                continue;
+            }
+            bool is_table = is_constant_bound
+                && function[object].kind == Inst::constant_array
+                && function[bound].as.number <= function[object].operands.count;
+            if (object != array && !is_table) {
+                if (!may_check_before || !is_invariant(object) || !dominates(dominators, BlockId(i), latch)) {
+                    continue;
+                }
+                if (!checked.find(object).has_value()) {
+                    Value operands[] = { object, bound };
+                    auto check = TRY(function.create_value(Inst { .kind = Inst::check_length, .type = Type::void_ }));
+                    function[check].operands = TRY(function.create_operands(View<Value const>(operands, 2)));
+                    TRY(insert_before_terminator(function, loop.preheader, View<Value const>(&check, 1)));
+                    TRY(checked.append(object));
+                }
+            }
+            function[value].as.boolean = true;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static bool runs_to_completion(IR::Function const& function, Loop const& loop)
+{
+    // Leaves only once the header says so, and does nothing on the way
+    // anyone could see.
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        if (!loop.contains[i]) {
+            continue;
+        }
+        for (auto value : function.blocks[i].insts.view()) {
+            auto const& inst = function[value];
+            switch (inst.kind) {
+            case Inst::jump:
+                if (!loop.contains[inst.as.target.raw()]) {
+                    return false;
+                }
+                break;
+            case Inst::branch:
+                if (BlockId(i) == loop.header) {
+                    break;
+                }
+                if (!loop.contains[inst.as.branch.then_.raw()] || !loop.contains[inst.as.branch.else_.raw()]) {
+                    return false;
+                }
+                break;
+            case Inst::switch_:
+                for (auto target : function.targets_of(value)) {
+                    if (!loop.contains[target.raw()]) {
+                        return false;
+                    }
+                }
+                break;
+            default:
+                if (inst.has_side_effects()) {
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+static ErrorOr<Vector<Loop>> find_loops(IR::Function const& function, View<BlockId const> dominators)
+{
+    // A back edge is a jump to a block dominating the one it leaves, and
+    // its loop is every block reaching it without passing the header.
+    auto loops = Vector<Loop>();
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        auto header = BlockId(i);
+        if (function[header].is_removed()) {
+            continue;
+        }
+        auto loop = Loop {
+            .header = header,
+            .preheader = BlockId(),
+        };
+        TRY(loop.contains.ensure_capacity(function.blocks.size()));
+        for (u32 j = 0; j < function.blocks.size(); j++) {
+            TRY(loop.contains.append(j == i));
+        }
+        auto worklist = Vector<BlockId>();
+        for (auto pred : function[header].preds.view()) {
+            if (dominates(dominators, header, pred) && !loop.contains[pred.raw()]) {
+                loop.contains[pred.raw()] = true;
+                TRY(worklist.append(pred));
+            }
+        }
+        if (worklist.is_empty()) {
+            continue;
+        }
+        while (!worklist.is_empty()) {
+            auto block = *worklist.pop();
+            for (auto pred : function[block].preds.view()) {
+                if (!loop.contains[pred.raw()]) {
+                    loop.contains[pred.raw()] = true;
+                    TRY(worklist.append(pred));
+                }
+            }
+        }
+
+        auto outside = Vector<BlockId>();
+        for (auto pred : function[header].preds.view()) {
+            if (!loop.contains[pred.raw()]) {
+                TRY(outside.append(pred));
+            }
+        }
+        if (outside.size() != 1 || TRY(function.successors(outside[0])).size() != 1) {
+            continue;
+        }
+        loop.preheader = outside[0];
+        TRY(loops.append(move(loop)));
+    }
+    return loops;
+}
+
+static ErrorOr<Vector<BlockId>> find_dominators(IR::Function const& function)
+{
+    // "A Simple, Fast Dominance Algorithm" (Cooper, Harvey and Kennedy),
+    // over blocks in reverse postorder. Unreachable blocks are left
+    // without an immediate dominator.
+    auto order = Vector<BlockId>();
+    auto is_visited = TRY(Vector<bool>::create(function.blocks.size()));
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        TRY(is_visited.append(false));
+    }
+    auto stack = Vector<BlockId>();
+    auto next_successor = TRY(Vector<u32>::create(function.blocks.size()));
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        TRY(next_successor.append(0));
+    }
+    TRY(stack.append(IR::Function::entry));
+    is_visited[IR::Function::entry.raw()] = true;
+    while (!stack.is_empty()) {
+        auto block = stack.last();
+        auto successors = TRY(function.successors(block));
+        auto& next = next_successor[block.raw()];
+        if (next < successors.size()) {
+            auto successor = successors[next++];
+            if (!is_visited[successor.raw()]) {
+                is_visited[successor.raw()] = true;
+                TRY(stack.append(successor));
+            }
+            continue;
+        }
+        TRY(order.append(block));
+        TRY(stack.pop().or_throw([] {
+            return Error::from_string_literal("block stack underflow");
+        }));
+    }
+
+    // order is in postorder, so a block's number is its place in it.
+    auto number = TRY(Vector<u32>::create(function.blocks.size()));
+    auto dominators = TRY(Vector<BlockId>::create(function.blocks.size()));
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        TRY(number.append(0));
+        TRY(dominators.append(BlockId()));
+    }
+    for (u32 i = 0; i < order.size(); i++) {
+        number[order[i].raw()] = i;
+    }
+    dominators[IR::Function::entry.raw()] = IR::Function::entry;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (u32 i = order.size(); i > 0; i--) {
+            auto block = order[i - 1];
+            if (block == IR::Function::entry) {
+                continue;
+            }
+            auto dominator = BlockId();
+            for (auto pred : function[block].preds.view()) {
+                if (!dominators[pred.raw()].is_valid()) {
+                    continue;
+                }
+                if (!dominator.is_valid()) {
+                    dominator = pred;
+                    continue;
+                }
+                auto other = pred;
+                while (dominator != other) {
+                    while (number[dominator.raw()] < number[other.raw()]) {
+                        dominator = dominators[dominator.raw()];
+                    }
+                    while (number[other.raw()] < number[dominator.raw()]) {
+                        other = dominators[other.raw()];
+                    }
+                }
+            }
+            if (dominators[block.raw()] != dominator) {
+                dominators[block.raw()] = dominator;
+                changed = true;
+            }
+        }
+    }
+    return dominators;
+}
+
+static bool dominates(View<BlockId const> dominators, BlockId a, BlockId b)
+{
+    if (!dominators[b.raw()].is_valid()) {
+        return false;
+    }
+    for (;;) {
+        if (a == b) {
+            return true;
+        }
+        if (b == IR::Function::entry) {
+            return false;
+        }
+        b = dominators[b.raw()];
+    }
+}
+
+static ErrorOr<Vector<BlockId>> find_definitions(IR::Function const& function)
+{
+    // Values outside of every block, like the undefs lowering makes, are
+    // left invalid.
+    auto defined_in = TRY(Vector<BlockId>::create(function.insts.size()));
+    for (u32 i = 0; i < function.insts.size(); i++) {
+        TRY(defined_in.append(BlockId()));
+    }
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        for (auto phi : function.blocks[i].phis.view()) {
+            defined_in[phi.raw()] = BlockId(i);
+        }
+        for (auto value : function.blocks[i].insts.view()) {
+            defined_in[value.raw()] = BlockId(i);
+        }
+    }
+    return defined_in;
+}
+
+static bool is_hoistable(Inst const& inst)
+{
+    // Only what can't fail or allocate, since the loop might not run at
+    // all. Reading an element may be out of bounds before the loop checks.
+    switch (inst.kind) {
+    case Inst::constant_number:
+    case Inst::constant_string:
+    case Inst::constant_boolean:
+    case Inst::constant_array:
+    case Inst::get_field:
+    case Inst::get_tag:
+    case Inst::length:
+    case Inst::not_:
+    case Inst::add:
+    case Inst::sub:
+    case Inst::lt:
+    case Inst::lt_eq:
+    case Inst::strict_eq:
+    case Inst::match_string:
+    case Inst::to_number:
+    case Inst::to_index:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool is_whole_index(Inst const& inst)
+{
+    return inst.kind == Inst::constant_number
+        && inst.as.number >= 0.0
+        && inst.as.number < 4294967295.0
+        && inst.as.number == (f64)(u32)inst.as.number;
+}
+
+static ErrorOr<void> insert_before_terminator(IR::Function& function, BlockId block, View<Value const> values)
+{
+    auto& insts = function[block].insts;
+    auto terminator = TRY(insts.pop().or_throw([] {
+        return Error::from_string_literal("preheader has no terminator");
+    }));
+    for (auto value : values) {
+        TRY(insts.append(value));
+    }
+    TRY(insts.append(terminator));
+    return {};
+}
@@ -0,0 +1,3205 @@
+#include "./Lower.h"
+
+#include <Ty/Parse.h>
+
+using IR::BlockId;
+using IR::Inst;
+using IR::Value;
+
+struct Definition {
+    StringView name;
+    BlockId block;
+    Value value;
+};
+
+struct IncompletePhi {
+    StringView name;
+    BlockId block;
+    Value phi;
+};
+
+struct TypeArg {
+    Type type;
+    IR::ShapeId shape;
+};
+
+struct Instance {
+    FuncDecl const* decl;
+    Vector<TypeArg> type_args;
+    IR::FunctionId id;
+};
+
+// Generic functions are compiled once per distinct list of type arguments
+// they're called with, each instance being a function of its own.
+struct Generics {
+    Vector<FuncDecl const*> decls {};
+    Vector<Instance> instances {};
+};
+
+// What type names refer to in some function: its type parameters, then
+// the interfaces and type aliases of the program.
+struct TypeScope {
+    View<TypeDecl const* const> types {};
+    FuncDecl const* decl { nullptr };
+    View<TypeArg const> type_args {};
+};
+
+// Guards against generic functions that call themselves with ever larger
+// type arguments.
+static constexpr u32 max_instances = 1024;
+
+// Guards against types that contain themselves, which can't be laid out.
+static constexpr u32 max_type_depth = 64;
+
+// Callbacks of xs.map(f), xs.filter(f) and xs.reduce(f, init) are called
+// from one loop for the whole chain, in the order the methods are called.
+static constexpr StringView array_methods[] = { "map"sv, "filter"sv, "reduce"sv, "forEach"sv };
+
+// Closures never exist at runtime: `const f = (x) => ...` only remembers
+// the arrow function, and every call to f and every array method it's
+// handed to lowers its body in place, reading what it captures straight
+// from the function around it. Nothing is allocated or called through a
+// pointer, but f can't be used as a value.
+struct Closure {
+    StringView name;
+    RValue const* value;
+};
+
+static constexpr u32 max_closure_depth = 32;
+
+// Generators never exist at runtime either: a for-of over a call to one
+// lowers the generator's body in place, and every yield lowers the loop
+// body right there with the loop variable bound to what was yielded.
+// Whatever the generator keeps across yields ends up in plain SSA values
+// of the function around the loop, so iterating allocates nothing.
+//
+// Variables of the generator are renamed so they can't clash with the
+// ones around the loop, and a yield switches back to the names around
+// the loop while it lowers the loop body.
+struct Rename {
+    StringView name;
+    StringView renamed;
+};
+
+struct GeneratorLoop {
+    FuncDecl const* decl;
+    ForOfStmt const* loop;
+    TypeArg element;
+    BlockId exit;
+    Vector<Rename> renames {};
+};
+
+// Inside `if (x.kind === "a")` and `case "a":`, x is known to hold that
+// variant of its union, so its fields can be read.
+struct Narrowing {
+    Value value;
+    u32 variant;
+};
+
+struct TagTest {
+    Value object;
+    Optional<u32> variant;
+};
+
+// Variables only visible in part of a function, like loop variables and
+// parameters of inlined callbacks. Once the scope ends, reads see what
+// the names referred to before again.
+struct LocalScope {
+    BlockId block;
+    u32 first_block;
+    u32 first_definition;
+    u32 first_rename;
+    Vector<StringView> names {};
+    Vector<Optional<Value>> shadowed {};
+};
+
+// SSA construction follows "Simple and Efficient Construction of Static
+// Single Assignment Form" (Braun et al.): variables are looked up through
+// the predecessors on demand, and phis are only placed in blocks whose
+// predecessors are not all known yet or that have several of them.
+struct Lowering {
+    IR::Module& module;
+    Source source;
+    Generics& generics;
+    IR::FunctionId function_id;
+    TypeScope scope {};
+    BlockId current {};
+    Vector<Definition> definitions {};
+    Vector<IncompletePhi> incomplete_phis {};
+    Vector<BlockId> sealed {};
+    View<VarDecl const* const> globals {};
+    Vector<StringView> constants {};
+    Vector<Narrowing> narrowings {};
+    Vector<BlockId> break_targets {};
+    View<FuncDecl const* const> decls {};
+    Vector<Closure> closures {};
+    u32 closure_depth { 0 };
+    Vector<Rename> renames {};
+    Vector<GeneratorLoop> generator_loops {};
+    u32 loops { 0 };
+
+    // Set while lowering a method or constructor of the class. Fields are
+    // initialized once the constructor is entered, or once it has called
+    // super in a derived class.
+    View<ClassDecl const* const> classes {};
+    IR::ClassId class_ {};
+    bool is_constructor { false };
+    bool has_called_super { false };
+
+    IR::Function& function() { return module[function_id]; }
+};
+
+static ErrorOr<void> collect_functions(Vector<FuncDecl const*>&, Expr const&);
+static ErrorOr<IR::FunctionId> declare_function(IR::Module&, StringView name, TypeScope const&, IR::ShapeId self = {});
+static ErrorOr<Vector<IR::ClassId>> declare_classes(IR::Module&, TypeScope const&, View<ClassDecl const* const>);
+static ErrorOr<void> declare_columnar_types(IR::Module&, TypeScope const&);
+static ErrorOr<void> declare_fields(IR::Module&, TypeScope const&, ClassDecl const&, IR::ClassId);
+static ErrorOr<void> declare_methods(IR::Module&, TypeScope const&, ClassDecl const&, IR::ClassId, Vector<FuncDecl const*>& constructors);
+static Optional<IR::ClassId> find_class(IR::Module const&, StringView name);
+static ErrorOr<TypeArg> resolve_type(IR::Module&, TypeScope const&, Type);
+static ErrorOr<TypeArg> resolve_type_recursive(IR::Module&, TypeScope const&, Type, u32 depth);
+static ErrorOr<IR::Shape> resolve_object_type(IR::Module&, TypeScope const&, ObjectType const&, StringView skip, u32 depth);
+static ErrorOr<IR::ShapeId> resolve_union_type(IR::Module&, TypeScope const&, UnionType const&, u32 depth);
+static ErrorOr<ObjectType const*> find_object_type(IR::Module const&, TypeScope const&, Type, u32 depth);
+static ErrorOr<void> declare_globals(Lowering&, View<VarDecl const> args);
+static bool is_pure(Expr const&, View<VarDecl const* const> globals, StringView file);
+static ErrorOr<void> lower_function(Lowering&, View<VarDecl const> args, View<Expr const> body);
+
+static ErrorOr<Value> lower_expr(Lowering&, Expr const&);
+static ErrorOr<Value> lower_rvalue(Lowering&, RValue const&);
+static ErrorOr<Value> lower_func_call(Lowering&, FuncCall const&);
+static ErrorOr<Value> lower_new_expr(Lowering&, NewExpr const&);
+static ErrorOr<void> begin_constructor(Lowering&);
+static ErrorOr<Value> call_super(Lowering&, View<Value const> args);
+static ErrorOr<void> initialize_fields(Lowering&);
+static ErrorOr<void> store_field(Lowering&, Value object, u32 index, Value);
+static ErrorOr<IR::FunctionId> instantiate(Lowering&, FuncDecl const&, FuncCall const&, View<Value const> args);
+static ErrorOr<IR::FunctionId> find_or_create_instance(Lowering&, FuncDecl const&, View<TypeArg const> type_args);
+static ErrorOr<Value> lower_if_stmt(Lowering&, IfStmt const&);
+static ErrorOr<Value> lower_switch_stmt(Lowering&, SwitchStmt const&);
+static ErrorOr<Value> lower_for_stmt(Lowering&, ForStmt const&);
+static ErrorOr<Value> lower_for_of_stmt(Lowering&, ForOfStmt const&);
+static ErrorOr<Value> lower_generator_loop(Lowering&, ForOfStmt const&, FuncDecl const& generator);
+static ErrorOr<void> lower_yield(Lowering&, Value);
+static FuncDecl const* find_generator(Lowering&, StringView name);
+static ErrorOr<Value> lower_index_expr(Lowering&, IndexExpr const&);
+static ErrorOr<void> lower_switch_cases(Lowering&, SwitchStmt const&, View<BlockId const> bodies, BlockId exit, Optional<Value> object);
+static ErrorOr<Optional<Value>> match_tag(Lowering&, RValue const&);
+static ErrorOr<Optional<TagTest>> match_tag_test(Lowering&, RValue const& lhs, RValue const& rhs);
+static ErrorOr<Value> lower_binary_expr(Lowering&, BinaryExpr const&);
+static ErrorOr<Value> lower_in_expr(Lowering&, BinaryExpr const&);
+static ErrorOr<Value> lower_dot_expr(Lowering&, DotExpr const&);
+static ErrorOr<Value> lower_field_access(Lowering&, Value object, RValue const& field);
+static ErrorOr<Value> lower_field_assignment(Lowering&, DotExpr const& target, RValue const& value);
+static ErrorOr<Value> narrow(Lowering&, Value object, StringView field);
+static ErrorOr<Value> lower_object_literal(Lowering&, ObjectLiteral const&);
+static ErrorOr<Value> lower_array_literal(Lowering&, ArrayLiteral const&);
+static ErrorOr<Value> freeze(Lowering&, Value);
+static bool is_readonly(Lowering&, Type, u32 depth);
+static ErrorOr<Value> lower_template_literal(Lowering&, TemplateLiteral const&);
+static ErrorOr<Value> lower_concat(Lowering&, View<Value const> parts);
+static ErrorOr<Value> lower_method_call(Lowering&, MethodCall const&);
+static ErrorOr<Value> lower_array_chain(Lowering&, MethodCall const&);
+static ErrorOr<Value> lower_virtual_call(Lowering&, MethodCall const&);
+static ErrorOr<Value> lower_super_call(Lowering&, MethodCall const&);
+static ErrorOr<Vector<Value>> lower_args(Lowering&, View<VarDecl const> args);
+static ErrorOr<Value> apply_callback(Lowering&, RValue const& callback, View<Value const> args);
+static ErrorOr<Value> call_function(Lowering&, IR::FunctionId, Vector<Value>&& args);
+static bool is_variable(Lowering&, StringView name);
+static bool is_array_method(StringView name);
+static RValue const* find_closure(Lowering&, StringView name);
+static bool is_pure_callback(Lowering&, Expr const&, Vector<FuncDecl const*>& visiting);
+static bool is_pure_function(Lowering&, StringView name, Vector<FuncDecl const*>& visiting);
+static ErrorOr<StringView> loop_variable(Lowering&, StringView name);
+static ErrorOr<StringView> declare_variable(Lowering&, StringView name);
+static StringView variable_name(Lowering&, StringView name);
+static ErrorOr<IR::ShapeId> find_or_create_shape(IR::Module&, IR::Shape&&);
+static ErrorOr<Value> coerce(Lowering&, Value, TypeArg to);
+static ErrorOr<Value> coerce_to_union(Lowering&, Value, IR::ShapeId to);
+static ErrorOr<Value> lower_number_literal(Lowering&, Token);
+static ErrorOr<Value> lower_string_literal(Lowering&, Token);
+
+static ErrorOr<Value> append(Lowering&, Inst, View<Value const> operands = {});
+static ErrorOr<void> jump(Lowering&, BlockId to);
+static ErrorOr<void> branch(Lowering&, Value cond, BlockId then_, BlockId else_);
+static LocalScope begin_scope(Lowering&);
+static ErrorOr<void> bind_variable(Lowering&, LocalScope&, StringView name, Value);
+static void end_scope(Lowering&, LocalScope const&);
+static ErrorOr<void> start_unreachable_block(Lowering&);
+static bool is_terminated(Lowering&);
+static bool is_reachable(Lowering&);
+
+static ErrorOr<void> write_variable(Lowering&, StringView name, BlockId, Value);
+static ErrorOr<Value> read_variable(Lowering&, StringView name, BlockId);
+static ErrorOr<Value> read_variable_recursive(Lowering&, StringView name, BlockId);
+static ErrorOr<Value> create_phi(Lowering&, BlockId);
+static ErrorOr<Value> add_phi_operands(Lowering&, StringView name, BlockId, Value phi);
+static ErrorOr<void> seal_block(Lowering&, BlockId);
+static bool is_sealed(Lowering&, BlockId);
+
+ErrorOr<IR::Module> lower(Source source, ParseTree const& tree)
+{
+    auto module = IR::Module {
+        .source = source,
+    };
+
+    auto all_decls = Vector<FuncDecl const*>();
+    for (auto const& expr : tree.expressions) {
+        TRY(collect_functions(all_decls, expr));
+    }
+
+    auto types = Vector<TypeDecl const*>();
+    for (auto const& expr : tree.expressions) {
+        if (expr != Expr::type_decl) {
+            continue;
+        }
+        auto name = expr.as.type_decl->name.view_in(source.file);
+        for (auto const* other : types) {
+            if (other->name.view_in(source.file) == name) {
+                return Error::from_string_literal("type declared more than once");
+            }
+        }
+        TRY(types.append(expr.as.type_decl));
+    }
+
+    auto classes = Vector<ClassDecl const*>();
+    for (auto const& expr : tree.expressions) {
+        if (expr == Expr::class_decl) {
+            TRY(classes.append(expr.as.class_decl));
+        }
+    }
+    auto class_order = TRY(declare_classes(module, TypeScope { .types = types.view() }, classes.view()));
+    TRY(declare_columnar_types(module, TypeScope { .types = types.view() }));
+
+    auto decls = Vector<FuncDecl const*>();
+    auto generics = Generics();
+    for (u32 i = 0; i < all_decls.size(); i++) {
+        auto name = all_decls[i]->name.view_in(source.file);
+        for (u32 j = 0; j < i; j++) {
+            if (all_decls[j]->name.view_in(source.file) == name) {
+                return Error::from_string_literal("function declared more than once");
+            }
+        }
+        if (all_decls[i]->is_generator) {
+            if (!all_decls[i]->type_params.is_empty() || all_decls[i]->is_async) {
+                return Error::from_string_literal("generators can't be generic or async");
+            }
+            continue;
+        }
+        if (all_decls[i]->type_params.is_empty()) {
+            TRY(decls.append(all_decls[i]));
+        } else {
+            TRY(generics.decls.append(all_decls[i]));
+        }
+    }
+
+    for (u32 i = 0; i < decls.size(); i++) {
+        auto scope = TypeScope {
+            .types = types.view(),
+            .decl = decls[i],
+        };
+        auto id = TRY(declare_function(module, decls[i]->name.view_in(source.file), scope));
+        module[id].is_exported = decls[i]->is_exported;
+    }
+    module.main = TRY(module.functions.append(IR::Function {
+        .name = "__main"sv,
+        .return_type = Type::void_,
+    }));
+    TRY(module[module.main].create_block());
+
+    // Methods are declared base class first, so overrides can be checked
+    // against what they override.
+    auto constructors = Vector<FuncDecl const*>();
+    for (u32 i = 0; i < classes.size(); i++) {
+        TRY(constructors.append(nullptr));
+    }
+    for (auto id : class_order.view()) {
+        TRY(declare_methods(module, TypeScope { .types = types.view() }, *classes[id.raw()], id, constructors));
+    }
+
+    // Top-level constants built only from literals and earlier such
+    // constants are known in every function, so they can be folded there
+    // instead of being passed around at runtime.
+    auto globals = Vector<VarDecl const*>();
+    for (auto const& expr : tree.expressions) {
+        if (expr == Expr::var_decl && !expr.as.var_decl->is_mutable && is_pure(expr.as.var_decl->default_value->value, globals.view(), source.file)) {
+            TRY(globals.append(expr.as.var_decl));
+        }
+    }
+
+    for (u32 i = 0; i < decls.size(); i++) {
+        auto lowering = Lowering(module, source, generics, IR::FunctionId(i));
+        lowering.scope = TypeScope {
+            .types = types.view(),
+            .decl = decls[i],
+        };
+        lowering.globals = globals.view();
+        lowering.decls = all_decls.view();
+        lowering.classes = classes.view();
+        TRY(lower_function(lowering, decls[i]->args.view(), decls[i]->block.exprs.view()));
+    }
+    auto lowering = Lowering(module, source, generics, module.main);
+    lowering.scope.types = types.view();
+    lowering.decls = all_decls.view();
+    lowering.classes = classes.view();
+    TRY(lower_function(lowering, View<VarDecl const>(), tree.expressions.view()));
+
+    for (u32 i = 0; i < classes.size(); i++) {
+        auto id = IR::ClassId(i);
+        auto bodies = Vector<FuncDecl const*>();
+        TRY(bodies.append(constructors[i]));
+        for (auto const& method : classes[i]->methods.view()) {
+            TRY(bodies.append(&method));
+        }
+        for (u32 j = 0; j < bodies.size(); j++) {
+            auto function = module[id].constructor;
+            if (j != 0) {
+                auto slot = module[id].methods.find(bodies[j]->name.view_in(source.file));
+                function = module[id].implementations[slot->raw()];
+            }
+            auto lowering = Lowering(module, source, generics, function);
+            lowering.scope = TypeScope {
+                .types = types.view(),
+                .decl = bodies[j],
+            };
+            lowering.globals = globals.view();
+            lowering.decls = all_decls.view();
+            lowering.classes = classes.view();
+            lowering.class_ = id;
+            lowering.is_constructor = j == 0;
+            TRY(lower_function(lowering, bodies[j]->args.view(), bodies[j]->block.exprs.view()));
+        }
+    }
+
+    // Lowering an instance may create more of them, so the list can grow
+    // while it's being walked.
+    for (u32 i = 0; i < generics.instances.size(); i++) {
+        auto const* decl = generics.instances[i].decl;
+        auto type_args = Vector<TypeArg>();
+        for (auto type_arg : generics.instances[i].type_args.view()) {
+            TRY(type_args.append(type_arg));
+        }
+        auto lowering = Lowering(module, source, generics, generics.instances[i].id);
+        lowering.scope = TypeScope {
+            .types = types.view(),
+            .decl = decl,
+            .type_args = type_args.view(),
+        };
+        lowering.globals = globals.view();
+        lowering.decls = all_decls.view();
+        lowering.classes = classes.view();
+        TRY(lower_function(lowering, decl->args.view(), decl->block.exprs.view()));
+    }
+
+    return module;
+}
+
+static ErrorOr<void> collect_functions(Vector<FuncDecl const*>& functions, Expr const& expr)
+{
+    if (expr == Expr::func_decl) {
+        TRY(functions.append(expr.as.func_decl));
+        for (auto const& inner : expr.as.func_decl->block.exprs.view()) {
+            TRY(collect_functions(functions, inner));
+        }
+    }
+    if (expr == Expr::block) {
+        for (auto const& inner : expr.as.block->exprs.view()) {
+            TRY(collect_functions(functions, inner));
+        }
+    }
+    if (expr == Expr::if_stmt) {
+        TRY(collect_functions(functions, expr.as.if_stmt->then));
+        TRY(collect_functions(functions, expr.as.if_stmt->else_));
+    }
+    return {};
+}
+
+static ErrorOr<IR::FunctionId> declare_function(IR::Module& module, StringView name, TypeScope const& scope, IR::ShapeId self)
+{
+    auto const& decl = *scope.decl;
+    auto return_type = TRY(resolve_type(module, scope, decl.return_type));
+    if (decl.is_async) {
+        if (return_type.type != Type::promise) {
+            return Error::from_string_literal("async functions have to return a promise");
+        }
+        return_type.type = return_type.type.element_type();
+    }
+    auto id = TRY(module.functions.append(IR::Function {
+        .name = name,
+        .return_type = return_type.type,
+        .return_shape = return_type.shape,
+        .is_async = decl.is_async,
+    }));
+
+    // Parameters exist before any body is lowered, so calls can be checked
+    // against functions declared further down.
+    auto& function = module[id];
+    auto entry = TRY(function.create_block());
+    if (self.is_valid()) {
+        TRY(function.params.append(TRY(function.append(entry, Inst {
+            .kind = Inst::param,
+            .type = Type::instance,
+            .shape = self,
+            .as = { .index = 0 },
+        }))));
+    }
+    for (u32 i = 0; i < decl.args.size(); i++) {
+        auto type = TRY(resolve_type(module, scope, decl.args[i].type));
+        auto param = TRY(function.append(entry, Inst {
+            .kind = Inst::param,
+            .type = type.type,
+            .shape = type.shape,
+            .as = { .index = function.params.size() },
+        }));
+        TRY(function.params.append(param));
+    }
+    return id;
+}
+
+static ErrorOr<Vector<IR::ClassId>> declare_classes(IR::Module& module, TypeScope const& scope, View<ClassDecl const* const> classes)
+{
+    auto file = module.source.file;
+    for (auto const* decl : classes) {
+        auto name = decl->name.view_in(file);
+        if (find_class(module, name).has_value()) {
+            return Error::from_string_literal("class declared more than once");
+        }
+        for (auto const* type : scope.types) {
+            if (type->name.view_in(file) == name) {
+                return Error::from_string_literal("class has the name of a type");
+            }
+        }
+        TRY(module.classes.append(IR::Class {
+            .name = name,
+            .shape = TRY(module.shapes.append(IR::Shape())),
+        }));
+    }
+    for (u32 i = 0; i < classes.size(); i++) {
+        if (!classes[i]->base.has_value()) {
+            continue;
+        }
+        module.classes[i].base = TRY(find_class(module, classes[i]->base->view_in(file)).or_throw([] {
+            return Error::from_string_literal("unknown base class");
+        }));
+    }
+
+    // Bases come before the classes derived from them.
+    auto order = Vector<IR::ClassId>();
+    while (order.size() < classes.size()) {
+        auto before = order.size();
+        for (u32 i = 0; i < classes.size(); i++) {
+            auto id = IR::ClassId(i);
+            auto base = module[id].base;
+            if (!order.find(id).has_value() && (!base.is_valid() || order.find(base).has_value())) {
+                TRY(order.append(id));
+            }
+        }
+        if (order.size() == before) {
+            return Error::from_string_literal("class extends itself");
+        }
+    }
+    for (auto id : order.view()) {
+        TRY(declare_fields(module, scope, *classes[id.raw()], id));
+    }
+    return order;
+}
+
+static ErrorOr<void> declare_fields(IR::Module& module, TypeScope const& scope, ClassDecl const& decl, IR::ClassId id)
+{
+    // Fields without a type take it from their initializer, which then
+    // has to be a literal.
+    auto file = module.source.file;
+    auto shape = IR::Shape();
+    if (module[id].base.is_valid()) {
+        auto const& base = module[module[module[id].base].shape];
+        for (u32 i = 0; i < base.fields.size(); i++) {
+            TRY(shape.fields.append(base.fields[i]));
+            TRY(shape.types.append(base.types[i]));
+            TRY(shape.shapes.append(base.shapes[i]));
+        }
+    }
+    for (auto const& field : decl.fields.view()) {
+        auto name = field.name.view_in(file);
+        if (shape.find(name).has_value()) {
+            return Error::from_string_literal("duplicate field in class");
+        }
+        auto type = TypeArg();
+        if (field.type != Type::none) {
+            type = TRY(resolve_type(module, scope, field.type));
+        } else if (field.default_value.has_value() && field.default_value->value == Expr::number_literal) {
+            type.type = Type::number;
+        } else if (field.default_value.has_value() && field.default_value->value == Expr::string_literal) {
+            type.type = Type::string;
+        } else {
+            return Error::from_string_literal("class fields need a type or a literal initializer");
+        }
+        TRY(shape.fields.append(name));
+        TRY(shape.types.append(type.type));
+        TRY(shape.shapes.append(type.shape));
+    }
+    module[module[id].shape] = move(shape);
+    return {};
+}
+
+static ErrorOr<void> declare_methods(IR::Module& module, TypeScope const& scope, ClassDecl const& decl, IR::ClassId id, Vector<FuncDecl const*>& constructors)
+{
+    auto file = module.source.file;
+    auto self = module[id].shape;
+    auto base = module[id].base;
+    if (base.is_valid()) {
+        for (u32 i = 0; i < module[base].methods.size(); i++) {
+            TRY(module[id].methods.append(module[base].methods[i]));
+            TRY(module[id].implementations.append(module[base].implementations[i]));
+        }
+    }
+
+    // A class without a constructor takes the arguments of its base's
+    // and passes them along.
+    if (decl.constructor.has_value()) {
+        constructors[id.raw()] = &decl.constructor.value();
+    } else {
+        auto* constructor = new FuncDecl { .return_type = Type(Type::void_) };
+        if (base.is_valid()) {
+            for (auto const& arg : constructors[base.raw()]->args.view()) {
+                TRY(constructor->args.append(VarDecl {
+                    .name = arg.name,
+                    .type = arg.type,
+                }));
+            }
+        }
+        constructors[id.raw()] = constructor;
+    }
+    auto* name = new StringBuffer(TRY(StringBuffer::create_fill(module[id].name, "__constructor"sv)));
+    module[id].constructor = TRY(declare_function(module, name->view(), TypeScope { .types = scope.types, .decl = constructors[id.raw()] }, self));
+
+    for (auto const& method : decl.methods.view()) {
+        auto method_name = method.name.view_in(file);
+        for (auto const& other : decl.methods.view()) {
+            if (&other != &method && other.name.view_in(file) == method_name) {
+                return Error::from_string_literal("method declared more than once");
+            }
+        }
+        auto* name = new StringBuffer(TRY(StringBuffer::create_fill(module[id].name, "__"sv, method_name)));
+        auto function = TRY(declare_function(module, name->view(), TypeScope { .types = scope.types, .decl = &method }, self));
+        auto slot = module[id].methods.find(method_name);
+        if (!slot.has_value()) {
+            TRY(module[id].methods.append(method_name));
+            TRY(module[id].implementations.append(function));
+            continue;
+        }
+
+        // Overrides are called through the same slot, so they have to
+        // take and give the same as what they override.
+        auto const& overridden = module[module[id].implementations[slot->raw()]];
+        auto const& overriding = module[function];
+        bool is_same = overridden.params.size() == overriding.params.size()
+            && overridden.return_type.is_same(overriding.return_type)
+            && overridden.return_shape == overriding.return_shape;
+        for (u32 i = 1; is_same && i < overriding.params.size(); i++) {
+            auto const& a = overridden[overridden.params[i]];
+            auto const& b = overriding[overriding.params[i]];
+            is_same = a.type.is_same(b.type) && a.shape == b.shape;
+        }
+        if (!is_same) {
+            return Error::from_string_literal("method overrides one with a different signature");
+        }
+        module[id].implementations[slot->raw()] = function;
+    }
+    return {};
+}
+
+static ErrorOr<void> declare_columnar_types(IR::Module& module, TypeScope const& scope)
+{
+    // Only shapes whose elements are all alike can be split into columns.
+    // Object types with the same fields share the shape, and with it the
+    // layout of their arrays.
+    for (auto const* decl : scope.types) {
+        if (!decl->is_columnar) {
+            continue;
+        }
+        auto type = TRY(resolve_type(module, scope, decl->type));
+        auto& shape = module[type.shape];
+        if (shape.is_union() || shape.fields.is_empty()) {
+            return Error::from_string_literal("@soa needs an interface with fields");
+        }
+        for (auto field : shape.fields.view()) {
+            if (IR::Shape::is_presence(field)) {
+                return Error::from_string_literal("@soa interfaces can't have optional fields");
+            }
+        }
+        shape.is_columnar = true;
+    }
+    return {};
+}
+
+static Optional<IR::ClassId> find_class(IR::Module const& module, StringView name)
+{
+    for (u32 i = 0; i < module.classes.size(); i++) {
+        if (module.classes[i].name == name) {
+            return IR::ClassId(i);
+        }
+    }
+    return {};
+}
+
+static ErrorOr<TypeArg> resolve_type(IR::Module& module, TypeScope const& scope, Type type)
+{
+    return TRY(resolve_type_recursive(module, scope, type, 0));
+}
+
+static ErrorOr<TypeArg> resolve_type_recursive(IR::Module& module, TypeScope const& scope, Type type, u32 depth)
+{
+    if (depth > max_type_depth) {
+        return Error::from_string_literal("type contains itself");
+    }
+    auto file = module.source.file;
+    if (type == Type::named) {
+        auto name = type.name().view_in(file);
+        for (u32 i = 0; scope.decl && i < scope.decl->type_params.size(); i++) {
+            if (scope.decl->type_params[i].view_in(file) == name) {
+                return scope.type_args[i];
+            }
+        }
+        for (auto const* decl : scope.types) {
+            if (decl->name.view_in(file) == name) {
+                auto global = TypeScope { .types = scope.types };
+                return TRY(resolve_type_recursive(module, global, decl->type, depth + 1));
+            }
+        }
+        if (auto class_ = find_class(module, name); class_.has_value()) {
+            return TypeArg {
+                .type = Type::instance,
+                .shape = module[class_.value()].shape,
+            };
+        }
+        return Error::from_string_literal("unknown type");
+    }
+    if (type == Type::union_) {
+        return TypeArg {
+            .type = Type::object,
+            .shape = TRY(resolve_union_type(module, scope, *type.union_type(), depth + 1)),
+        };
+    }
+    if (type == Type::literal) {
+        return TypeArg {
+            .type = Type::string,
+            .shape = IR::ShapeId(),
+        };
+    }
+    if (type == Type::array) {
+        auto element = TRY(resolve_type_recursive(module, scope, type.element_type(), depth + 1));
+        return TypeArg {
+            .type = Type::from_array(new Type(element.type)),
+            .shape = element.shape,
+        };
+    }
+    if (type == Type::promise) {
+        auto element = TRY(resolve_type_recursive(module, scope, type.element_type(), depth + 1));
+        return TypeArg {
+            .type = Type::from_promise(new Type(element.type)),
+            .shape = element.shape,
+        };
+    }
+    if (type != Type::object || !type.object_type()) {
+        return TypeArg {
+            .type = type,
+            .shape = IR::ShapeId(),
+        };
+    }
+    auto shape = TRY(resolve_object_type(module, scope, *type.object_type(), StringView(), depth));
+    return TypeArg {
+        .type = Type::object,
+        .shape = TRY(find_or_create_shape(module, move(shape))),
+    };
+}
+
+static ErrorOr<IR::Shape> resolve_object_type(IR::Module& module, TypeScope const& scope, ObjectType const& object, StringView skip, u32 depth)
+{
+    // Object types become shapes just like object literals do, so values
+    // of either kind share a layout whenever their fields match.
+    auto file = module.source.file;
+    auto shape = IR::Shape();
+    auto optional = Vector<StringView>();
+    for (auto const& field : object.fields) {
+        auto name = field.name.view_in(file);
+        if (name == skip) {
+            continue;
+        }
+        if (shape.find(name).has_value()) {
+            return Error::from_string_literal("duplicate field in object type");
+        }
+        auto field_type = TRY(resolve_type_recursive(module, scope, field.type, depth + 1));
+        TRY(shape.fields.append(name));
+        TRY(shape.types.append(field_type.type));
+        TRY(shape.shapes.append(field_type.shape));
+        if (field.is_optional) {
+            TRY(optional.append(name));
+        }
+    }
+    for (auto name : optional.view()) {
+        auto* presence = new StringBuffer(TRY(StringBuffer::create_fill(name, "?"sv)));
+        TRY(shape.fields.append(presence->view()));
+        TRY(shape.types.append(Type::boolean));
+        TRY(shape.shapes.append(IR::ShapeId()));
+    }
+    return shape;
+}
+
+static ErrorOr<IR::ShapeId> resolve_union_type(IR::Module& module, TypeScope const& scope, UnionType const& union_, u32 depth)
+{
+    auto file = module.source.file;
+    auto members = Vector<ObjectType const*>();
+    for (auto member : union_.members.view()) {
+        TRY(members.append(TRY(find_object_type(module, scope, member, depth + 1))));
+    }
+
+    // The tag is the first field with a string literal type that every
+    // member has, variants are then stored without it.
+    auto tag = StringView();
+    for (auto const& candidate : members[0]->fields) {
+        bool is_tag = true;
+        for (auto const* member : members) {
+            bool has_literal = false;
+            for (auto const& field : member->fields) {
+                has_literal |= field.name.view_in(file) == candidate.name.view_in(file) && field.type == Type::literal;
+            }
+            is_tag = is_tag && has_literal;
+        }
+        if (is_tag) {
+            tag = candidate.name.view_in(file);
+            break;
+        }
+    }
+    if (tag.is_empty()) {
+        return Error::from_string_literal("union members need a common field with a string literal type");
+    }
+
+    auto shape = IR::Shape {
+        .tag = tag,
+    };
+    for (auto const* member : members) {
+        for (auto const& field : member->fields) {
+            if (field.name.view_in(file) != tag) {
+                continue;
+            }
+            auto value = field.type.literal_token().view_in(file).chop_left(1);
+            if (shape.find_variant(value).has_value()) {
+                return Error::from_string_literal("union members share a tag");
+            }
+            TRY(shape.tags.append(value));
+        }
+        auto variant = TRY(resolve_object_type(module, scope, *member, tag, depth + 1));
+        TRY(shape.variants.append(TRY(find_or_create_shape(module, move(variant)))));
+    }
+    return TRY(find_or_create_shape(module, move(shape)));
+}
+
+static ErrorOr<ObjectType const*> find_object_type(IR::Module const& module, TypeScope const& scope, Type type, u32 depth)
+{
+    if (depth > max_type_depth) {
+        return Error::from_string_literal("type contains itself");
+    }
+    if (type == Type::object && type.object_type()) {
+        return type.object_type();
+    }
+    if (type == Type::named) {
+        auto file = module.source.file;
+        for (auto const* decl : scope.types) {
+            if (decl->name.view_in(file) == type.name().view_in(file)) {
+                return TRY(find_object_type(module, scope, decl->type, depth + 1));
+            }
+        }
+    }
+    return Error::from_string_literal("union members must be object types");
+}
+
+static ErrorOr<void> declare_globals(Lowering& lowering, View<VarDecl const> args)
+{
+    auto file = lowering.source.file;
+    for (u32 i = 0; i < lowering.globals.size(); i++) {
+        auto const& global = *lowering.globals[i];
+        auto name = global.name.view_in(file);
+
+        bool is_shadowed = false;
+        for (u32 j = 0; j < args.size(); j++) {
+            if (args[j].name.view_in(file) == name) {
+                is_shadowed = true;
+            }
+        }
+        if (global.default_value->value == Expr::arrow_func) {
+            if (!is_shadowed) {
+                TRY(lowering.closures.append(Closure { name, &global.default_value.value() }));
+            }
+            continue;
+        }
+
+        // Later constants may be built from this one, so it's defined even
+        // when a parameter hides it; the parameter is written over it.
+        auto value = TRY(lower_rvalue(lowering, *global.default_value));
+        TRY(write_variable(lowering, name, lowering.current, value));
+        if (!is_shadowed) {
+            TRY(lowering.constants.append(name));
+        }
+    }
+    return {};
+}
+
+static bool is_pure(Expr const& expr, View<VarDecl const* const> globals, StringView file)
+{
+    switch (expr) {
+    case Expr::lvalue_expr:
+        for (auto const* global : globals) {
+            if (global->name.view_in(file) == expr.as.lvalue_expr.view_in(file)) {
+                return true;
+            }
+        }
+        return false;
+    case Expr::string_literal:
+    case Expr::number_literal:
+        return true;
+    case Expr::unary_expr:
+        return expr.as.unary_expr->op != Token::kw_await && is_pure(expr.as.unary_expr->value.value, globals, file);
+    case Expr::binary_expr:
+        return expr.as.binary_expr->op != Token::op_assign
+            && is_pure(expr.as.binary_expr->lhs.value, globals, file)
+            && is_pure(expr.as.binary_expr->rhs.value, globals, file);
+    case Expr::rvalue_expr:
+        return is_pure(expr.as.rvalue_expr->value, globals, file);
+    default:
+        return false;
+    }
+}
+
+static ErrorOr<void> lower_function(Lowering& lowering, View<VarDecl const> args, View<Expr const> body)
+{
+    auto entry = IR::Function::entry;
+    TRY(seal_block(lowering, entry));
+    lowering.current = entry;
+
+    // Methods take the instance they're called on first.
+    auto const& params = lowering.function().params;
+    auto first = params.size() - args.size();
+    if (first == 1) {
+        TRY(write_variable(lowering, "this"sv, entry, params[0]));
+        TRY(lowering.constants.append("this"sv));
+    }
+    TRY(declare_globals(lowering, args));
+    for (u32 i = 0; i < args.size(); i++) {
+        auto param = lowering.function().params[first + i];
+        TRY(write_variable(lowering, args[i].name.view_in(lowering.source.file), entry, param));
+    }
+    if (lowering.is_constructor) {
+        TRY(begin_constructor(lowering));
+    }
+
+    for (u32 i = 0; i < body.size(); i++) {
+        bool is_initializer = lowering.function_id == lowering.module.main
+            && body[i] == Expr::var_decl
+            && !body[i].as.var_decl->is_mutable
+            && body[i].as.var_decl->default_value->value != Expr::arrow_func;
+        if (!is_initializer) {
+            TRY(lower_expr(lowering, body[i]));
+            continue;
+        }
+        auto initializer = IR::Initializer {
+            .start = lowering.current,
+            .start_index = lowering.function()[lowering.current].insts.size(),
+            .first_block = lowering.function().blocks.size(),
+        };
+        TRY(lower_expr(lowering, body[i]));
+        initializer.end = lowering.current;
+        initializer.end_index = lowering.function()[lowering.current].insts.size();
+        initializer.last_block = lowering.function().blocks.size();
+        TRY(lowering.module.initializers.append(initializer));
+    }
+    if (lowering.is_constructor && lowering.module[lowering.class_].base.is_valid() && !lowering.has_called_super) {
+        return Error::from_string_literal("constructors of derived classes have to call super");
+    }
+
+    if (!is_terminated(lowering)) {
+        auto return_type = lowering.function().return_type;
+        auto return_shape = lowering.function().return_shape;
+        bool is_reachable = lowering.current == entry || !lowering.function()[lowering.current].preds.is_empty();
+        if (return_type == Type::void_) {
+            TRY(append(lowering, Inst { .kind = Inst::ret, .type = Type::void_ }));
+        } else if (!is_reachable) {
+            auto undef = TRY(lowering.function().create_value(Inst {
+                .kind = Inst::undef,
+                .type = return_type,
+                .shape = return_shape,
+            }));
+            TRY(append(lowering, Inst { .kind = Inst::ret, .type = Type::void_ }, View(&undef, 1)));
+        } else {
+            return Error::from_string_literal("function lacks ending return statement");
+        }
+    }
+
+    // Phis that only see other phis can't pick up a type while they're
+    // being filled in, so settle them once every block is known.
+    auto& function = lowering.function();
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto const& block : function.blocks) {
+            for (auto phi : block.phis.view()) {
+                if (function[phi].type != Type::none) {
+                    continue;
+                }
+                for (auto operand : function.operands_of(phi)) {
+                    if (function[operand].type != Type::none) {
+                        function[phi].type = function[operand].type;
+                        function[phi].shape = function[operand].shape;
+                        changed = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return {};
+}
+
+static ErrorOr<Value> lower_expr(Lowering& lowering, Expr const& expr)
+{
+    switch (expr) {
+    case Expr::none:
+        return Value();
+
+    case Expr::block:
+        for (auto const& inner : expr.as.block->exprs.view()) {
+            TRY(lower_expr(lowering, inner));
+        }
+        return Value();
+
+    case Expr::var_decl: {
+        auto const& decl = *expr.as.var_decl;
+        auto name = decl.name.view_in(lowering.source.file);
+        if (decl.default_value->value == Expr::arrow_func) {
+            if (decl.is_mutable) {
+                return Error::from_string_literal("closures have to be declared const");
+            }
+            TRY(lowering.closures.append(Closure { name, &decl.default_value.value() }));
+            return Value();
+        }
+        auto value = TRY(lower_rvalue(lowering, *decl.default_value));
+        auto type = lowering.function()[value].type;
+        auto declared = TRY(resolve_type(lowering.module, lowering.scope, decl.type));
+        if (declared.type != Type::none && type != Type::none && declared.type != type) {
+            return Error::from_string_literal("initializer does not match declared type");
+        }
+        value = TRY(coerce(lowering, value, declared));
+        if (is_readonly(lowering, decl.type, 0)) {
+            auto frozen = TRY(freeze(lowering, value));
+            value = frozen.is_valid() ? frozen : value;
+        }
+        name = TRY(declare_variable(lowering, name));
+        TRY(write_variable(lowering, name, lowering.current, value));
+        if (!decl.is_mutable) {
+            TRY(lowering.constants.append(name));
+        }
+        return Value();
+    }
+
+    case Expr::func_decl:
+    case Expr::type_decl:
+    case Expr::class_decl:
+        return Value();
+
+    case Expr::func_call:
+        return TRY(lower_func_call(lowering, *expr.as.func_call));
+
+    case Expr::new_expr:
+        return TRY(lower_new_expr(lowering, *expr.as.new_expr));
+
+    case Expr::if_stmt:
+        return TRY(lower_if_stmt(lowering, *expr.as.if_stmt));
+
+    case Expr::switch_stmt:
+        return TRY(lower_switch_stmt(lowering, *expr.as.switch_stmt));
+
+    case Expr::for_stmt:
+        return TRY(lower_for_stmt(lowering, *expr.as.for_stmt));
+
+    case Expr::for_of_stmt:
+        return TRY(lower_for_of_stmt(lowering, *expr.as.for_of_stmt));
+
+    case Expr::break_stmt:
+        if (lowering.break_targets.is_empty()) {
+            return Error::from_string_literal("break outside of switch or loop");
+        }
+        TRY(jump(lowering, lowering.break_targets.last()));
+        TRY(start_unreachable_block(lowering));
+        return Value();
+
+    case Expr::throw_stmt: {
+        auto value = TRY(lower_rvalue(lowering, expr.as.throw_stmt->value));
+        TRY(append(lowering, Inst { .kind = Inst::throw_, .type = Type::void_ }, View(&value, 1)));
+        TRY(start_unreachable_block(lowering));
+        return Value();
+    }
+
+    case Expr::return_stmt: {
+        if (!lowering.generator_loops.is_empty()) {
+            if (expr.as.return_stmt->value.value != Expr::none) {
+                return Error::from_string_literal("generators can't return values");
+            }
+            TRY(jump(lowering, lowering.generator_loops.last().exit));
+            TRY(start_unreachable_block(lowering));
+            return Value();
+        }
+        if (expr.as.return_stmt->value.value == Expr::none) {
+            if (lowering.function().return_type != Type::void_) {
+                return Error::from_string_literal("return without a value in function returning one");
+            }
+            TRY(append(lowering, Inst { .kind = Inst::ret, .type = Type::void_ }));
+            TRY(start_unreachable_block(lowering));
+            return Value();
+        }
+        auto value = TRY(lower_rvalue(lowering, expr.as.return_stmt->value));
+        value = TRY(coerce(lowering, value, TypeArg {
+            .type = lowering.function().return_type,
+            .shape = lowering.function().return_shape,
+        }));
+        TRY(append(lowering, Inst { .kind = Inst::ret, .type = Type::void_ }, View(&value, 1)));
+        TRY(start_unreachable_block(lowering));
+        return Value();
+    }
+
+    case Expr::yield_stmt: {
+        if (lowering.generator_loops.is_empty()) {
+            return Error::from_string_literal("yield outside of a generator");
+        }
+        auto value = TRY(lower_rvalue(lowering, expr.as.yield_stmt->value));
+        value = TRY(coerce(lowering, value, lowering.generator_loops.last().element));
+        TRY(lower_yield(lowering, value));
+        return Value();
+    }
+
+    case Expr::unary_expr: {
+        auto const& unary = *expr.as.unary_expr;
+        auto value = TRY(lower_rvalue(lowering, unary.value));
+        if (unary.op == Token::kw_await) {
+            if (!lowering.function().is_async) {
+                return Error::from_string_literal("await is only allowed in async functions");
+            }
+            auto const& promise = lowering.function()[value];
+            if (promise.type != Type::promise) {
+                return Error::from_string_literal("only promises can be awaited");
+            }
+            return TRY(append(lowering, Inst {
+                .kind = Inst::await_,
+                .type = promise.type.element_type(),
+                .shape = promise.shape,
+            }, View(&value, 1)));
+        }
+        if (unary.op == Token::kw_as) {
+            auto frozen = TRY(freeze(lowering, value));
+            return frozen.is_valid() ? frozen : value;
+        }
+        if (unary.op != Token::op_bang) {
+            return Error::unimplemented();
+        }
+        return TRY(append(lowering, Inst { .kind = Inst::not_, .type = Type::boolean }, View(&value, 1)));
+    }
+
+    case Expr::binary_expr:
+        return TRY(lower_binary_expr(lowering, *expr.as.binary_expr));
+
+    case Expr::dot_expr:
+        return TRY(lower_dot_expr(lowering, *expr.as.dot_expr));
+
+    case Expr::method_call:
+        return TRY(lower_method_call(lowering, *expr.as.method_call));
+
+    case Expr::index_expr:
+        return TRY(lower_index_expr(lowering, *expr.as.index_expr));
+
+    case Expr::arrow_func:
+        return Error::from_string_literal("arrow functions can only be passed to array methods");
+
+    case Expr::lvalue_expr: {
+        auto name = expr.as.lvalue_expr.view_in(lowering.source.file);
+        if (!is_variable(lowering, name) && find_closure(lowering, name)) {
+            return Error::from_string_literal("closures can only be called or passed to array methods");
+        }
+        return TRY(read_variable(lowering, variable_name(lowering, name), lowering.current));
+    }
+
+    case Expr::rvalue_expr:
+        return TRY(lower_rvalue(lowering, *expr.as.rvalue_expr));
+
+    case Expr::string_literal:
+        return TRY(lower_string_literal(lowering, expr.as.string_literal));
+
+    case Expr::number_literal:
+        return TRY(lower_number_literal(lowering, expr.as.number_literal));
+
+    case Expr::object_literal:
+        return TRY(lower_object_literal(lowering, *expr.as.object_literal));
+
+    case Expr::array_literal:
+        return TRY(lower_array_literal(lowering, *expr.as.array_literal));
+
+    case Expr::template_literal:
+        return TRY(lower_template_literal(lowering, *expr.as.template_literal));
+    }
+}
+
+static ErrorOr<Value> lower_rvalue(Lowering& lowering, RValue const& rvalue)
+{
+    auto value = TRY(lower_expr(lowering, rvalue.value));
+    if (!value.is_valid()) {
+        return Error::from_string_literal("expression does not produce a value");
+    }
+    return value;
+}
+
+static ErrorOr<Value> lower_func_call(Lowering& lowering, FuncCall const& call)
+{
+    auto file = lowering.source.file;
+    auto name = call.name.view_in(file);
+    FuncDecl const* generic = nullptr;
+    for (auto const* decl : lowering.generics.decls) {
+        if (decl->name.view_in(file) == name) {
+            generic = decl;
+        }
+    }
+    if (!generic && !call.type_args.is_empty()) {
+        return Error::from_string_literal("type arguments given to non-generic function");
+    }
+    if (name == "super"sv && lowering.is_constructor) {
+        auto args = TRY(lower_args(lowering, call.args.view()));
+        return TRY(call_super(lowering, args.view()));
+    }
+
+    auto args = Vector<Value>();
+    for (auto const& arg : call.args.view()) {
+        if (!arg.default_value) {
+            return Error::from_string_literal("expected some value for function parameter");
+        }
+        TRY(args.append(TRY(lower_rvalue(lowering, *arg.default_value))));
+    }
+
+    if (!is_variable(lowering, name)) {
+        if (auto const* closure = find_closure(lowering, name)) {
+            return TRY(apply_callback(lowering, *closure, args.view()));
+        }
+    }
+    if (find_generator(lowering, name)) {
+        return Error::from_string_literal("generators can only be looped over with for-of");
+    }
+    auto callee = IR::FunctionId();
+    if (generic) {
+        callee = TRY(instantiate(lowering, *generic, call, args.view()));
+    } else {
+        callee = TRY(lowering.module.find(name).or_throw([] {
+            return Error::from_string_literal("call to undeclared function");
+        }));
+    }
+    return TRY(call_function(lowering, callee, move(args)));
+}
+
+static ErrorOr<Value> lower_new_expr(Lowering& lowering, NewExpr const& expr)
+{
+    auto id = TRY(find_class(lowering.module, expr.name.view_in(lowering.source.file)).or_throw([] {
+        return Error::from_string_literal("unknown class");
+    }));
+    auto object = TRY(append(lowering, Inst {
+        .kind = Inst::new_object,
+        .type = Type::instance,
+        .shape = lowering.module[id].shape,
+    }));
+    auto args = Vector<Value>();
+    TRY(args.append(object));
+    for (auto arg : TRY(lower_args(lowering, expr.args.view()))) {
+        TRY(args.append(arg));
+    }
+    TRY(call_function(lowering, lowering.module[id].constructor, move(args)));
+    return object;
+}
+
+static ErrorOr<void> begin_constructor(Lowering& lowering)
+{
+    if (!lowering.module[lowering.class_].base.is_valid()) {
+        TRY(initialize_fields(lowering));
+        return {};
+    }
+    if (lowering.classes[lowering.class_.raw()]->constructor.has_value()) {
+        return {};
+    }
+    auto args = Vector<Value>();
+    auto const& params = lowering.function().params;
+    for (u32 i = 1; i < params.size(); i++) {
+        TRY(args.append(params[i]));
+    }
+    TRY(call_super(lowering, args.view()));
+    return {};
+}
+
+static ErrorOr<Value> call_super(Lowering& lowering, View<Value const> args)
+{
+    auto base = lowering.module[lowering.class_].base;
+    if (!base.is_valid()) {
+        return Error::from_string_literal("super called in a class without a base");
+    }
+    if (lowering.has_called_super) {
+        return Error::from_string_literal("super called more than once");
+    }
+    auto values = Vector<Value>();
+    TRY(values.append(TRY(read_variable(lowering, "this"sv, lowering.current))));
+    for (auto arg : args) {
+        TRY(values.append(arg));
+    }
+    auto result = TRY(call_function(lowering, lowering.module[base].constructor, move(values)));
+    lowering.has_called_super = true;
+    TRY(initialize_fields(lowering));
+    return result;
+}
+
+static ErrorOr<void> initialize_fields(Lowering& lowering)
+{
+    // Fields of the base were initialized by its constructor, and ones
+    // without an initializer start out zeroed.
+    auto const& decl = *lowering.classes[lowering.class_.raw()];
+    auto self = TRY(read_variable(lowering, "this"sv, lowering.current));
+    auto shape = lowering.module[lowering.class_].shape;
+    auto first = lowering.module[shape].fields.size() - decl.fields.size();
+    for (u32 i = 0; i < decl.fields.size(); i++) {
+        if (decl.fields[i].default_value.has_value()) {
+            auto value = TRY(lower_rvalue(lowering, *decl.fields[i].default_value));
+            TRY(store_field(lowering, self, first + i, value));
+        }
+    }
+    return {};
+}
+
+static ErrorOr<void> store_field(Lowering& lowering, Value object, u32 index, Value value)
+{
+    auto const& shape = lowering.module[lowering.function()[object].shape];
+    auto field = TypeArg {
+        .type = shape.types[index],
+        .shape = shape.shapes[index],
+    };
+    if (lowering.function()[value].type != field.type) {
+        return Error::from_string_literal("value does not match the type of the field");
+    }
+    Value operands[] = { object, TRY(coerce(lowering, value, field)) };
+    TRY(append(lowering, Inst {
+        .kind = Inst::store_field,
+        .type = Type::void_,
+        .as = { .index = index },
+    }, View<Value const>(operands, 2)));
+    return {};
+}
+
+static ErrorOr<IR::FunctionId> instantiate(Lowering& lowering, FuncDecl const& decl, FuncCall const& call, View<Value const> args)
+{
+    auto file = lowering.source.file;
+    auto type_args = Vector<TypeArg>();
+    if (!call.type_args.is_empty()) {
+        if (call.type_args.size() != decl.type_params.size()) {
+            return Error::from_string_literal("wrong number of type arguments");
+        }
+        for (auto type : call.type_args.view()) {
+            TRY(type_args.append(TRY(resolve_type(lowering.module, lowering.scope, type))));
+        }
+        return TRY(find_or_create_instance(lowering, decl, type_args.view()));
+    }
+
+    // Type arguments that are left out are the types of the arguments
+    // passed for parameters of that type.
+    if (decl.args.size() != args.size()) {
+        return Error::from_string_literal("wrong number of arguments");
+    }
+    for (auto param : decl.type_params.view()) {
+        auto type_arg = TypeArg();
+        for (u32 i = 0; i < decl.args.size(); i++) {
+            auto type = decl.args[i].type;
+            if (type != Type::named || type.name().view_in(file) != param.view_in(file)) {
+                continue;
+            }
+            auto const& arg = lowering.function()[args[i]];
+            if (type_arg.type != Type::none && (!type_arg.type.is_same(arg.type) || type_arg.shape != arg.shape)) {
+                return Error::from_string_literal("conflicting type arguments");
+            }
+            type_arg = TypeArg {
+                .type = arg.type,
+                .shape = arg.shape,
+            };
+        }
+        if (type_arg.type == Type::none) {
+            return Error::from_string_literal("could not infer type argument");
+        }
+        TRY(type_args.append(type_arg));
+    }
+    return TRY(find_or_create_instance(lowering, decl, type_args.view()));
+}
+
+static ErrorOr<IR::FunctionId> find_or_create_instance(Lowering& lowering, FuncDecl const& decl, View<TypeArg const> type_args)
+{
+    auto& generics = lowering.generics;
+    for (auto const& instance : generics.instances) {
+        if (instance.decl != &decl) {
+            continue;
+        }
+        bool is_same = true;
+        for (u32 i = 0; i < type_args.size(); i++) {
+            is_same = is_same
+                && instance.type_args[i].type.is_same(type_args[i].type)
+                && instance.type_args[i].shape == type_args[i].shape;
+        }
+        if (is_same) {
+            return instance.id;
+        }
+    }
+    if (generics.instances.size() >= max_instances) {
+        return Error::from_string_literal("too many instances of generic function");
+    }
+
+    // identity<number> becomes identity__number, identity<number[]>
+    // identity__Array_number.
+    auto* name = new StringBuffer(TRY(StringBuffer::create_fill(decl.name.view_in(lowering.source.file))));
+    for (auto type_arg : type_args) {
+        TRY(name->write("_"sv));
+        auto type = type_arg.type;
+        for (; type == Type::array; type = type.element_type()) {
+            TRY(name->write("_Array"sv));
+        }
+        if (type == Type::object || type == Type::instance) {
+            TRY(name->write("_Shape"sv, type_arg.shape.raw()));
+            continue;
+        }
+        auto type_name = TRY(type.to_string());
+        TRY(name->write("_"sv, type_name.view()));
+    }
+
+    auto scope = TypeScope {
+        .types = lowering.scope.types,
+        .decl = &decl,
+        .type_args = type_args,
+    };
+    auto id = TRY(declare_function(lowering.module, name->view(), scope));
+    auto instance = Instance {
+        .decl = &decl,
+        .type_args = {},
+        .id = id,
+    };
+    for (auto type_arg : type_args) {
+        TRY(instance.type_args.append(type_arg));
+    }
+    TRY(generics.instances.append(move(instance)));
+    return id;
+}
+
+static ErrorOr<Value> lower_if_stmt(Lowering& lowering, IfStmt const& stmt)
+{
+    auto cond = TRY(lower_rvalue(lowering, stmt.cond));
+    auto& function = lowering.function();
+
+    auto then_block = TRY(function.create_block());
+    auto else_block = BlockId();
+    if (stmt.else_ != Expr::none) {
+        else_block = TRY(function.create_block());
+    }
+    auto merge_block = TRY(function.create_block());
+    if (!else_block.is_valid()) {
+        else_block = merge_block;
+    }
+
+    TRY(append(lowering, Inst {
+        .kind = Inst::branch,
+        .type = Type::void_,
+        .as = { .branch = { .then_ = then_block, .else_ = else_block } },
+    }, View(&cond, 1)));
+    TRY(function[then_block].preds.append(lowering.current));
+    TRY(function[else_block].preds.append(lowering.current));
+
+    TRY(seal_block(lowering, then_block));
+    lowering.current = then_block;
+    auto narrowed = false;
+    if (stmt.cond.value == Expr::binary_expr && stmt.cond.value.as.binary_expr->op == Token::op_triple_eq) {
+        auto const& cond = *stmt.cond.value.as.binary_expr;
+        auto test = TRY(match_tag_test(lowering, cond.lhs, cond.rhs));
+        if (test.has_value() && test->variant.has_value()) {
+            TRY(lowering.narrowings.append(Narrowing {
+                .value = test->object,
+                .variant = test->variant.value(),
+            }));
+            narrowed = true;
+        }
+    }
+    TRY(lower_expr(lowering, stmt.then));
+    if (narrowed) {
+        TRY(lowering.narrowings.pop().or_throw([] {
+            return Error::unreachable();
+        }));
+    }
+    TRY(jump(lowering, merge_block));
+
+    if (else_block != merge_block) {
+        TRY(seal_block(lowering, else_block));
+        lowering.current = else_block;
+        TRY(lower_expr(lowering, stmt.else_));
+        TRY(jump(lowering, merge_block));
+    }
+
+    TRY(seal_block(lowering, merge_block));
+    lowering.current = merge_block;
+    return Value();
+}
+
+static ErrorOr<Value> lower_switch_stmt(Lowering& lowering, SwitchStmt const& stmt)
+{
+    auto bodies = Vector<BlockId>();
+    auto default_body = Optional<BlockId>();
+    for (auto const& switch_case : stmt.cases.view()) {
+        auto body = TRY(lowering.function().create_block());
+        TRY(bodies.append(body));
+        if (!switch_case.value.has_value()) {
+            default_body = body;
+        }
+    }
+    auto exit = TRY(lowering.function().create_block());
+    auto otherwise = default_body.has_value() ? default_body.value() : exit;
+
+    // Switching on the tag of a union jumps straight to the case through
+    // a table indexed by tag.
+    auto object = TRY(match_tag(lowering, stmt.value));
+    if (object.has_value()) {
+        auto& function = lowering.function();
+        auto value = object.value();
+        auto const& shape = lowering.module[function[value].shape];
+        auto targets = Vector<BlockId>();
+        TRY(targets.append(otherwise));
+        for (u32 i = 0; i < shape.tags.size(); i++) {
+            TRY(targets.append(otherwise));
+        }
+        for (u32 i = 0; i < stmt.cases.size(); i++) {
+            auto const& switch_case = stmt.cases[i];
+            if (!switch_case.value.has_value()) {
+                continue;
+            }
+            if (switch_case.value->value != Expr::string_literal) {
+                return Error::from_string_literal("expected a tag to switch on");
+            }
+            auto name = switch_case.value->value.as.string_literal.view_in(lowering.source.file).chop_left(1);
+            auto variant = TRY(shape.find_variant(name).or_throw([] {
+                return Error::from_string_literal("no variant of the union has this tag");
+            }));
+            if (targets[variant + 1] == otherwise) {
+                targets[variant + 1] = bodies[i];
+            }
+        }
+
+        auto tag = TRY(append(lowering, Inst { .kind = Inst::get_tag, .type = Type::number }, View(&value, 1)));
+        TRY(append(lowering, Inst {
+            .kind = Inst::switch_,
+            .type = Type::void_,
+            .as = { .switch_ = TRY(function.create_targets(targets.view())) },
+        }, View(&tag, 1)));
+        for (auto target : targets.view()) {
+            TRY(function[target].preds.append(lowering.current));
+        }
+        TRY(lower_switch_cases(lowering, stmt, bodies.view(), exit, value));
+        return Value();
+    }
+
+    // Anything else is compared against each case in turn.
+    auto value = TRY(lower_rvalue(lowering, stmt.value));
+    for (u32 i = 0; i < stmt.cases.size(); i++) {
+        if (!stmt.cases[i].value.has_value()) {
+            continue;
+        }
+        Value operands[] = {
+            value,
+            TRY(lower_rvalue(lowering, stmt.cases[i].value.value())),
+        };
+        auto cond = TRY(append(lowering, Inst { .kind = Inst::strict_eq, .type = Type::boolean }, View<Value const>(operands, 2)));
+        auto& function = lowering.function();
+        auto next = TRY(function.create_block());
+        TRY(append(lowering, Inst {
+            .kind = Inst::branch,
+            .type = Type::void_,
+            .as = { .branch = { .then_ = bodies[i], .else_ = next } },
+        }, View(&cond, 1)));
+        TRY(function[bodies[i]].preds.append(lowering.current));
+        TRY(function[next].preds.append(lowering.current));
+        TRY(seal_block(lowering, next));
+        lowering.current = next;
+    }
+    TRY(jump(lowering, otherwise));
+    TRY(lower_switch_cases(lowering, stmt, bodies.view(), exit, {}));
+    return Value();
+}
+
+static ErrorOr<void> lower_switch_cases(Lowering& lowering, SwitchStmt const& stmt, View<BlockId const> bodies, BlockId exit, Optional<Value> object)
+{
+    TRY(lowering.break_targets.append(exit));
+    for (u32 i = 0; i < stmt.cases.size(); i++) {
+        // Cases without a break run on into the next one, which then
+        // can't assume which variant it has.
+        bool falls_through = i != 0 && is_reachable(lowering);
+        if (falls_through) {
+            TRY(jump(lowering, bodies[i]));
+        }
+        TRY(seal_block(lowering, bodies[i]));
+        lowering.current = bodies[i];
+
+        auto const& switch_case = stmt.cases[i];
+        bool narrowed = false;
+        if (object.has_value() && switch_case.value.has_value() && !falls_through) {
+            auto const& shape = lowering.module[lowering.function()[object.value()].shape];
+            auto name = switch_case.value->value.as.string_literal.view_in(lowering.source.file).chop_left(1);
+            TRY(lowering.narrowings.append(Narrowing {
+                .value = object.value(),
+                .variant = TRY(shape.find_variant(name).or_throw([] {
+                    return Error::unreachable();
+                })),
+            }));
+            narrowed = true;
+        }
+        for (auto const& expr : switch_case.body.view()) {
+            TRY(lower_expr(lowering, expr));
+        }
+        if (narrowed) {
+            TRY(lowering.narrowings.pop().or_throw([] {
+                return Error::unreachable();
+            }));
+        }
+    }
+    if (is_reachable(lowering)) {
+        TRY(jump(lowering, exit));
+    }
+    TRY(lowering.break_targets.pop().or_throw([] {
+        return Error::unreachable();
+    }));
+    TRY(seal_block(lowering, exit));
+    lowering.current = exit;
+    return {};
+}
+
+static ErrorOr<Value> lower_for_stmt(Lowering& lowering, ForStmt const& stmt)
+{
+    TRY(lower_expr(lowering, stmt.init));
+    auto& function = lowering.function();
+    auto header = TRY(function.create_block());
+    auto body = TRY(function.create_block());
+    auto latch = TRY(function.create_block());
+    auto exit = TRY(function.create_block());
+
+    // The header isn't sealed before the latch jumps back to it.
+    TRY(jump(lowering, header));
+    lowering.current = header;
+    auto cond = TRY(lower_rvalue(lowering, stmt.cond));
+    TRY(branch(lowering, cond, body, exit));
+
+    TRY(seal_block(lowering, body));
+    lowering.current = body;
+    TRY(lowering.break_targets.append(exit));
+    TRY(lower_expr(lowering, stmt.body));
+    TRY(lowering.break_targets.pop().or_throw([] {
+        return Error::unreachable();
+    }));
+    TRY(jump(lowering, latch));
+
+    TRY(seal_block(lowering, latch));
+    lowering.current = latch;
+    TRY(lower_rvalue(lowering, stmt.update));
+    TRY(jump(lowering, header));
+    TRY(seal_block(lowering, header));
+
+    TRY(seal_block(lowering, exit));
+    lowering.current = exit;
+    return Value();
+}
+
+static ErrorOr<Value> lower_for_of_stmt(Lowering& lowering, ForOfStmt const& stmt)
+{
+    if (stmt.iterable.value == Expr::func_call) {
+        auto name = stmt.iterable.value.as.func_call->name.view_in(lowering.source.file);
+        if (auto const* generator = find_generator(lowering, name)) {
+            return TRY(lower_generator_loop(lowering, stmt, *generator));
+        }
+    }
+
+    // Arrays never change once built, so the loop counts up to a length
+    // read once and reads the elements straight from their storage.
+    auto array = TRY(lower_rvalue(lowering, stmt.iterable));
+    if (lowering.function()[array].type != Type::array) {
+        return Error::from_string_literal("can only loop over arrays");
+    }
+    auto index_name = TRY(loop_variable(lowering, "index"sv));
+    auto length = TRY(append(lowering, Inst { .kind = Inst::length, .type = Type::index }, View(&array, 1)));
+    auto zero = TRY(append(lowering, Inst {
+        .kind = Inst::constant_number,
+        .type = Type::index,
+        .as = { .number = 0.0 },
+    }));
+    TRY(write_variable(lowering, index_name, lowering.current, zero));
+
+    auto& function = lowering.function();
+    auto header = TRY(function.create_block());
+    auto body = TRY(function.create_block());
+    auto latch = TRY(function.create_block());
+    auto exit = TRY(function.create_block());
+
+    TRY(jump(lowering, header));
+    lowering.current = header;
+    Value compare[] = { TRY(read_variable(lowering, index_name, header)), length };
+    auto cond = TRY(append(lowering, Inst { .kind = Inst::lt, .type = Type::boolean }, View<Value const>(compare, 2)));
+    TRY(branch(lowering, cond, body, exit));
+
+    TRY(seal_block(lowering, body));
+    lowering.current = body;
+    Value get[] = { array, compare[0] };
+    auto element = TRY(append(lowering, Inst {
+        .kind = Inst::get_element,
+        .type = function[array].type.element_type(),
+        .shape = function[array].shape,
+    }, View<Value const>(get, 2)));
+    auto scope = begin_scope(lowering);
+    TRY(bind_variable(lowering, scope, stmt.name.view_in(lowering.source.file), element));
+    TRY(lowering.break_targets.append(exit));
+    TRY(lower_expr(lowering, stmt.body));
+    TRY(lowering.break_targets.pop().or_throw([] {
+        return Error::unreachable();
+    }));
+    end_scope(lowering, scope);
+    TRY(jump(lowering, latch));
+
+    TRY(seal_block(lowering, latch));
+    lowering.current = latch;
+    Value increment[] = {
+        TRY(read_variable(lowering, index_name, latch)),
+        TRY(append(lowering, Inst {
+            .kind = Inst::constant_number,
+            .type = Type::index,
+            .as = { .number = 1.0 },
+        })),
+    };
+    auto next_index = TRY(append(lowering, Inst { .kind = Inst::add, .type = Type::index }, View<Value const>(increment, 2)));
+    TRY(write_variable(lowering, index_name, latch, next_index));
+    TRY(jump(lowering, header));
+    TRY(seal_block(lowering, header));
+
+    TRY(seal_block(lowering, exit));
+    lowering.current = exit;
+    return Value();
+}
+
+static ErrorOr<Value> lower_generator_loop(Lowering& lowering, ForOfStmt const& stmt, FuncDecl const& generator)
+{
+    auto file = lowering.source.file;
+    auto const& call = *stmt.iterable.value.as.func_call;
+    for (auto const& loop : lowering.generator_loops) {
+        if (loop.decl == &generator) {
+            return Error::from_string_literal("generators can't loop over themselves");
+        }
+    }
+    if (call.args.size() != generator.args.size()) {
+        return Error::from_string_literal("wrong number of arguments");
+    }
+    auto scope = TypeScope {
+        .types = lowering.scope.types,
+        .decl = &generator,
+    };
+    auto type = TRY(resolve_type(lowering.module, scope, generator.return_type));
+    if (type.type != Type::generator) {
+        return Error::from_string_literal("generators have to return a generator");
+    }
+
+    auto args = Vector<Value>();
+    for (u32 i = 0; i < call.args.size(); i++) {
+        if (!call.args[i].default_value) {
+            return Error::from_string_literal("expected some value for function parameter");
+        }
+        auto value = TRY(lower_rvalue(lowering, *call.args[i].default_value));
+        TRY(args.append(TRY(coerce(lowering, value, TRY(resolve_type(lowering.module, scope, generator.args[i].type))))));
+    }
+
+    auto exit = TRY(lowering.function().create_block());
+    TRY(lowering.generator_loops.append(GeneratorLoop {
+        .decl = &generator,
+        .loop = &stmt,
+        .element = TypeArg {
+            .type = type.type.element_type(),
+            .shape = type.shape,
+        },
+        .exit = exit,
+        .renames = move(lowering.renames),
+    }));
+    lowering.renames = Vector<Rename>();
+    for (u32 i = 0; i < args.size(); i++) {
+        auto name = TRY(declare_variable(lowering, generator.args[i].name.view_in(file)));
+        TRY(write_variable(lowering, name, lowering.current, args[i]));
+    }
+    for (auto const& expr : generator.block.exprs.view()) {
+        TRY(lower_expr(lowering, expr));
+    }
+    if (!is_terminated(lowering)) {
+        TRY(jump(lowering, exit));
+    }
+    auto loop = TRY(lowering.generator_loops.pop().or_throw([] {
+        return Error::unreachable();
+    }));
+    lowering.renames = move(loop.renames);
+
+    TRY(seal_block(lowering, exit));
+    lowering.current = exit;
+    return Value();
+}
+
+static ErrorOr<void> lower_yield(Lowering& lowering, Value value)
+{
+    // The loop body belongs to the code around the loop, so yields and
+    // returns in it aren't the generator's, and its names are the ones
+    // around the loop.
+    auto loop = TRY(lowering.generator_loops.pop().or_throw([] {
+        return Error::unreachable();
+    }));
+    auto renames = move(lowering.renames);
+    lowering.renames = move(loop.renames);
+
+    auto scope = begin_scope(lowering);
+    TRY(bind_variable(lowering, scope, loop.loop->name.view_in(lowering.source.file), value));
+    TRY(lowering.break_targets.append(loop.exit));
+    TRY(lower_expr(lowering, loop.loop->body));
+    TRY(lowering.break_targets.pop().or_throw([] {
+        return Error::unreachable();
+    }));
+    end_scope(lowering, scope);
+
+    loop.renames = move(lowering.renames);
+    lowering.renames = move(renames);
+    TRY(lowering.generator_loops.append(move(loop)));
+    return {};
+}
+
+static FuncDecl const* find_generator(Lowering& lowering, StringView name)
+{
+    if (is_variable(lowering, name)) {
+        return nullptr;
+    }
+    for (auto const* decl : lowering.decls) {
+        if (decl->is_generator && decl->name.view_in(lowering.source.file) == name) {
+            return decl;
+        }
+    }
+    return nullptr;
+}
+
+static ErrorOr<Value> lower_index_expr(Lowering& lowering, IndexExpr const& expr)
+{
+    auto array = TRY(lower_rvalue(lowering, expr.object));
+    if (lowering.function()[array].type != Type::array) {
+        return Error::from_string_literal("can only index arrays");
+    }
+    auto index = TRY(lower_rvalue(lowering, expr.index));
+    if (lowering.function()[index].type == Type::number) {
+        index = TRY(append(lowering, Inst { .kind = Inst::to_index, .type = Type::index }, View(&index, 1)));
+    }
+    if (lowering.function()[index].type != Type::index) {
+        return Error::from_string_literal("array indices have to be numbers");
+    }
+    Value operands[] = { array, index };
+    return TRY(append(lowering, Inst {
+        .kind = Inst::get_element,
+        .type = lowering.function()[array].type.element_type(),
+        .shape = lowering.function()[array].shape,
+    }, View<Value const>(operands, 2)));
+}
+
+static ErrorOr<Optional<Value>> match_tag(Lowering& lowering, RValue const& rvalue)
+{
+    // Only `x.tag` where x is a variable holding a union.
+    if (rvalue.value != Expr::dot_expr) {
+        return Optional<Value>();
+    }
+    auto const& dot = *rvalue.value.as.dot_expr;
+    if (dot.rhs.value != Expr::lvalue_expr) {
+        return Optional<Value>();
+    }
+    auto file = lowering.source.file;
+    auto object = TRY(read_variable(lowering, variable_name(lowering, dot.lhs.view_in(file)), lowering.current));
+    auto const& inst = lowering.function()[object];
+    if (inst.type != Type::object || !lowering.module[inst.shape].is_union()) {
+        return Optional<Value>();
+    }
+    if (lowering.module[inst.shape].tag != dot.rhs.value.as.lvalue_expr.view_in(file)) {
+        return Optional<Value>();
+    }
+    return Optional<Value>(object);
+}
+
+static ErrorOr<Optional<TagTest>> match_tag_test(Lowering& lowering, RValue const& lhs, RValue const& rhs)
+{
+    auto const* tag = &lhs;
+    auto const* literal = &rhs;
+    if (lhs.value == Expr::string_literal) {
+        tag = &rhs;
+        literal = &lhs;
+    }
+    if (literal->value != Expr::string_literal) {
+        return Optional<TagTest>();
+    }
+    auto object = TRY(match_tag(lowering, *tag));
+    if (!object.has_value()) {
+        return Optional<TagTest>();
+    }
+    auto const& shape = lowering.module[lowering.function()[object.value()].shape];
+    auto name = literal->value.as.string_literal.view_in(lowering.source.file).chop_left(1);
+    return Optional<TagTest>(TagTest {
+        .object = object.value(),
+        .variant = shape.find_variant(name),
+    });
+}
+
+static ErrorOr<Value> lower_binary_expr(Lowering& lowering, BinaryExpr const& expr)
+{
+    if (expr.op == Token::op_assign) {
+        if (expr.lhs.value == Expr::dot_expr) {
+            return TRY(lower_field_assignment(lowering, *expr.lhs.value.as.dot_expr, expr.rhs));
+        }
+        if (expr.lhs.value != Expr::lvalue_expr) {
+            return Error::from_string_literal("can only assign to variables and fields");
+        }
+        auto name = variable_name(lowering, expr.lhs.value.as.lvalue_expr.view_in(lowering.source.file));
+        if (lowering.constants.find(name).has_value()) {
+            return Error::from_string_literal("assignment to constant variable");
+        }
+        auto value = TRY(lower_rvalue(lowering, expr.rhs));
+        if (lowering.function()[value].type == Type::instance) {
+            // A variable of a base class can be given any class derived
+            // from it.
+            auto const& previous = lowering.function()[TRY(read_variable(lowering, name, lowering.current))];
+            value = TRY(coerce(lowering, value, TypeArg { .type = previous.type, .shape = previous.shape }));
+        }
+        TRY(write_variable(lowering, name, lowering.current, value));
+        return value;
+    }
+    if (expr.op == Token::kw_in) {
+        return TRY(lower_in_expr(lowering, expr));
+    }
+    if (expr.op == Token::op_triple_eq) {
+        auto test = TRY(match_tag_test(lowering, expr.lhs, expr.rhs));
+        if (test.has_value() && !test->variant.has_value()) {
+            return TRY(append(lowering, Inst {
+                .kind = Inst::constant_boolean,
+                .type = Type::boolean,
+                .as = { .boolean = false },
+            }));
+        }
+        if (test.has_value()) {
+            // Comparing tags is comparing small numbers, not strings.
+            Value operands[] = {
+                TRY(append(lowering, Inst { .kind = Inst::get_tag, .type = Type::number }, View(&test->object, 1))),
+                TRY(append(lowering, Inst {
+                    .kind = Inst::constant_number,
+                    .type = Type::number,
+                    .as = { .number = (f64)test->variant.value() },
+                })),
+            };
+            return TRY(append(lowering, Inst { .kind = Inst::strict_eq, .type = Type::boolean }, View<Value const>(operands, 2)));
+        }
+    }
+
+    Value operands[] = {
+        TRY(lower_rvalue(lowering, expr.lhs)),
+        TRY(lower_rvalue(lowering, expr.rhs)),
+    };
+    auto lhs_type = lowering.function()[operands[0]].type;
+    auto rhs_type = lowering.function()[operands[1]].type;
+    if (expr.op == Token::op_plus && (lhs_type == Type::string || rhs_type == Type::string)) {
+        return TRY(lower_concat(lowering, View<Value const>(operands, 2)));
+    }
+
+    auto inst = Inst {};
+    switch (expr.op) {
+    case Token::op_plus:
+        inst = Inst { .kind = Inst::add, .type = lhs_type };
+        break;
+    case Token::op_minus:
+        inst = Inst { .kind = Inst::sub, .type = Type::number };
+        break;
+    case Token::op_lt:
+        inst = Inst { .kind = Inst::lt, .type = Type::boolean };
+        break;
+    case Token::op_lt_eq:
+        inst = Inst { .kind = Inst::lt_eq, .type = Type::boolean };
+        break;
+    case Token::op_triple_eq:
+        inst = Inst { .kind = Inst::strict_eq, .type = Type::boolean };
+        break;
+    default:
+        return Error::unimplemented();
+    }
+    return TRY(append(lowering, inst, View<Value const>(operands, 2)));
+}
+
+static ErrorOr<Value> lower_in_expr(Lowering& lowering, BinaryExpr const& expr)
+{
+    if (expr.lhs.value != Expr::string_literal) {
+        return Error::from_string_literal("expected field name on the left of 'in'");
+    }
+    auto name = expr.lhs.value.as.string_literal.view_in(lowering.source.file).chop_left(1);
+    auto object = TRY(lower_rvalue(lowering, expr.rhs));
+    if (lowering.function()[object].type != Type::object) {
+        return Error::from_string_literal("can only look for fields in objects");
+    }
+
+    // Only optional fields need to be looked for at runtime, whether any
+    // other field is there is known from the shape.
+    auto const& shape = lowering.module[lowering.function()[object].shape];
+    if (auto presence = shape.find_presence(name); presence.has_value()) {
+        return TRY(append(lowering, Inst {
+            .kind = Inst::get_field,
+            .type = Type::boolean,
+            .as = { .index = presence.value() },
+        }, View(&object, 1)));
+    }
+    return TRY(append(lowering, Inst {
+        .kind = Inst::constant_boolean,
+        .type = Type::boolean,
+        .as = { .boolean = shape.find(name).has_value() },
+    }));
+}
+
+static ErrorOr<Value> lower_dot_expr(Lowering& lowering, DotExpr const& expr)
+{
+    if (expr.rhs.value == Expr::lvalue_expr || expr.rhs.value == Expr::dot_expr) {
+        auto object = TRY(read_variable(lowering, variable_name(lowering, expr.lhs.view_in(lowering.source.file)), lowering.current));
+        return TRY(lower_field_access(lowering, object, expr.rhs));
+    }
+    if (expr.rhs.value != Expr::func_call) {
+        return Error::unimplemented();
+    }
+    auto const& call = *expr.rhs.value.as.func_call;
+
+    auto args = Vector<Value>();
+    for (auto const& arg : call.args.view()) {
+        if (!arg.default_value) {
+            return Error::from_string_literal("expected some value for function parameter");
+        }
+        TRY(args.append(TRY(lower_rvalue(lowering, *arg.default_value))));
+    }
+
+    return TRY(append(lowering, Inst {
+        .kind = Inst::call_method,
+        .type = Type::void_,
+        .as = { .method = { .object = expr.lhs, .member = call.name } },
+    }, args.view()));
+}
+
+static ErrorOr<Value> lower_field_access(Lowering& lowering, Value object, RValue const& field)
+{
+    // a.b.c parses as a . (b . c), so walk down the right hand side.
+    auto file = lowering.source.file;
+    auto name = StringView();
+    if (field.value == Expr::lvalue_expr) {
+        name = field.value.as.lvalue_expr.view_in(file);
+    } else if (field.value == Expr::dot_expr) {
+        name = field.value.as.dot_expr->lhs.view_in(file);
+    } else {
+        return Error::unimplemented();
+    }
+
+    if (lowering.function()[object].type == Type::array && name == "length"sv && field.value == Expr::lvalue_expr) {
+        auto length = TRY(append(lowering, Inst { .kind = Inst::length, .type = Type::index }, View(&object, 1)));
+        return TRY(append(lowering, Inst { .kind = Inst::to_number, .type = Type::number }, View(&length, 1)));
+    }
+    if (lowering.function()[object].type == Type::instance) {
+        auto const& shape = lowering.module[lowering.function()[object].shape];
+        auto index = TRY(shape.find(name).or_throw([] {
+            return Error::from_string_literal("class has no such field");
+        }));
+        auto value = TRY(append(lowering, Inst {
+            .kind = Inst::load_field,
+            .type = shape.types[index],
+            .shape = shape.shapes[index],
+            .as = { .index = index },
+        }, View(&object, 1)));
+        if (field.value == Expr::dot_expr) {
+            return TRY(lower_field_access(lowering, value, field.value.as.dot_expr->rhs));
+        }
+        return value;
+    }
+    if (lowering.function()[object].type != Type::object) {
+        return Error::from_string_literal("can only read fields of objects");
+    }
+    if (lowering.module[lowering.function()[object].shape].is_union()) {
+        object = TRY(narrow(lowering, object, name));
+        if (lowering.function()[object].kind == Inst::constant_string) {
+            return object;
+        }
+    }
+    auto const& shape = lowering.module[lowering.function()[object].shape];
+    auto index = TRY(shape.find(name).or_throw([] {
+        return Error::from_string_literal("object has no such field");
+    }));
+    auto value = TRY(append(lowering, Inst {
+        .kind = Inst::get_field,
+        .type = shape.types[index],
+        .shape = shape.shapes[index],
+        .as = { .index = index },
+    }, View(&object, 1)));
+
+    if (field.value == Expr::dot_expr) {
+        return TRY(lower_field_access(lowering, value, field.value.as.dot_expr->rhs));
+    }
+    return value;
+}
+
+static ErrorOr<Value> lower_field_assignment(Lowering& lowering, DotExpr const& target, RValue const& value)
+{
+    // a.b.c = x reads a.b and stores into its field c. Only instances of
+    // classes can be changed, objects never are.
+    auto file = lowering.source.file;
+    auto object = TRY(read_variable(lowering, variable_name(lowering, target.lhs.view_in(file)), lowering.current));
+    auto const* field = &target.rhs;
+    while (field->value == Expr::dot_expr) {
+        auto const& inner = *field->value.as.dot_expr;
+        object = TRY(lower_field_access(lowering, object, RValue { .value = Expr::lvalue(inner.lhs) }));
+        field = &inner.rhs;
+    }
+    if (field->value != Expr::lvalue_expr) {
+        return Error::from_string_literal("can only assign to variables and fields");
+    }
+    if (lowering.function()[object].type != Type::instance) {
+        return Error::from_string_literal("only fields of class instances can be assigned to");
+    }
+    auto index = TRY(lowering.module[lowering.function()[object].shape].find(field->value.as.lvalue_expr.view_in(file)).or_throw([] {
+        return Error::from_string_literal("class has no such field");
+    }));
+    auto result = TRY(lower_rvalue(lowering, value));
+    TRY(store_field(lowering, object, index, result));
+    return result;
+}
+
+static ErrorOr<Value> narrow(Lowering& lowering, Value object, StringView field)
+{
+    auto const& shape = lowering.module[lowering.function()[object].shape];
+    auto narrowing = Optional<Narrowing>();
+    for (auto const& candidate : lowering.narrowings) {
+        if (candidate.value == object) {
+            narrowing = candidate;
+        }
+    }
+    if (!narrowing.has_value()) {
+        return Error::from_string_literal("check the tag of a union before reading its fields");
+    }
+    auto variant = narrowing->variant;
+    if (field == shape.tag) {
+        return TRY(append(lowering, Inst {
+            .kind = Inst::constant_string,
+            .type = Type::string,
+            .as = { .string = shape.tags[variant] },
+        }));
+    }
+    return TRY(append(lowering, Inst {
+        .kind = Inst::unwrap,
+        .type = Type::object,
+        .shape = shape.variants[variant],
+        .as = { .index = variant },
+    }, View(&object, 1)));
+}
+
+static ErrorOr<Value> lower_object_literal(Lowering& lowering, ObjectLiteral const& object)
+{
+    auto file = lowering.source.file;
+    auto shape = IR::Shape();
+    auto values = Vector<Value>();
+    for (auto const& field : object.fields.view()) {
+        auto name = field.name.view_in(file);
+        if (shape.find(name).has_value()) {
+            return Error::from_string_literal("duplicate field in object literal");
+        }
+        auto value = TRY(lower_rvalue(lowering, field.value));
+        TRY(shape.fields.append(name));
+        TRY(shape.types.append(lowering.function()[value].type));
+        TRY(shape.shapes.append(lowering.function()[value].shape));
+        TRY(values.append(value));
+    }
+    auto id = TRY(find_or_create_shape(lowering.module, move(shape)));
+    return TRY(append(lowering, Inst {
+        .kind = Inst::object,
+        .type = Type::object,
+        .shape = id,
+    }, values.view()));
+}
+
+static ErrorOr<Value> lower_template_literal(Lowering& lowering, TemplateLiteral const& literal)
+{
+    auto parts = Vector<Value>();
+    for (u32 i = 0; i < literal.strings.size(); i++) {
+        if (literal.strings[i].view_in(lowering.source.file).size() > 1) {
+            TRY(parts.append(TRY(lower_string_literal(lowering, literal.strings[i]))));
+        }
+        if (i < literal.values.size()) {
+            TRY(parts.append(TRY(lower_rvalue(lowering, literal.values[i]))));
+        }
+    }
+    return TRY(lower_concat(lowering, parts.view()));
+}
+
+static ErrorOr<Value> lower_concat(Lowering& lowering, View<Value const> parts)
+{
+    // Parts that are concats themselves are spliced in, so however long a
+    // chain gets, only the string at its end is built.
+    auto& function = lowering.function();
+    auto operands = Vector<Value>();
+    for (auto part : parts) {
+        if (function[part].kind == Inst::concat) {
+            for (auto operand : function.operands_of(part)) {
+                TRY(operands.append(operand));
+            }
+            continue;
+        }
+        // Reads in unreachable code give values of no type at all.
+        auto type = function[part].type;
+        if (type != Type::string && type != Type::number && type != Type::none) {
+            return Error::from_string_literal("can only join strings and numbers");
+        }
+        TRY(operands.append(part));
+    }
+    return TRY(append(lowering, Inst {
+        .kind = Inst::concat,
+        .type = Type::string,
+    }, operands.view()));
+}
+
+static ErrorOr<Value> lower_array_literal(Lowering& lowering, ArrayLiteral const& array)
+{
+    // Elements all have the type of the first one, so `[]` has none.
+    if (array.items.is_empty()) {
+        return Error::from_string_literal("empty array literals are not supported");
+    }
+    auto values = Vector<Value>();
+    for (auto const& item : array.items.view()) {
+        TRY(values.append(TRY(lower_rvalue(lowering, item))));
+    }
+    auto const& first = lowering.function()[values[0]];
+    auto element = TypeArg { .type = first.type, .shape = first.shape };
+    auto type = Type::from_array(new Type(element.type));
+
+    // Instances of different classes are held as the closest base they
+    // have in common.
+    if (element.type == Type::instance) {
+        auto const& module = lowering.module;
+        auto common = module.find_class(element.shape).value();
+        for (auto value : values.view()) {
+            auto const& item = lowering.function()[value];
+            if (item.type != Type::instance) {
+                break;
+            }
+            auto class_ = module.find_class(item.shape).value();
+            while (common.is_valid() && !module.is_subclass(class_, common)) {
+                common = module[common].base;
+            }
+            if (!common.is_valid()) {
+                return Error::from_string_literal("array elements have different types");
+            }
+        }
+        element.shape = module[common].shape;
+    }
+
+    auto capacity = TRY(append(lowering, Inst {
+        .kind = Inst::constant_number,
+        .type = Type::index,
+        .as = { .number = (f64)values.size() },
+    }));
+    auto result = TRY(append(lowering, Inst {
+        .kind = Inst::create_array,
+        .type = type,
+        .shape = element.shape,
+    }, View(&capacity, 1)));
+    for (auto value : values.view()) {
+        if (!lowering.function()[value].type.is_same(element.type)) {
+            return Error::from_string_literal("array elements have different types");
+        }
+        Value operands[] = { result, TRY(coerce(lowering, value, element)) };
+        result = TRY(append(lowering, Inst {
+            .kind = Inst::push,
+            .type = type,
+            .shape = element.shape,
+        }, View<Value const>(operands, 2)));
+    }
+    return result;
+}
+
+static ErrorOr<Value> freeze(Lowering& lowering, Value value)
+{
+    // Arrays that are never changed and only hold constants become static
+    // data, so they cost nothing to create. What built them is left for
+    // dead value removal. Anything else isn't frozen.
+    auto inst = lowering.function()[value];
+    switch (inst.kind) {
+    case Inst::constant_number:
+    case Inst::constant_string:
+    case Inst::constant_boolean:
+    case Inst::constant_array:
+        return value;
+
+    case Inst::object: {
+        auto fields = Vector<Value>();
+        bool changed = false;
+        for (auto field : lowering.function().operands_of(value)) {
+            TRY(fields.append(field));
+        }
+        for (auto& field : fields) {
+            auto frozen = TRY(freeze(lowering, field));
+            if (!frozen.is_valid()) {
+                return Value();
+            }
+            changed |= frozen != field;
+            field = frozen;
+        }
+        if (!changed) {
+            return value;
+        }
+        return TRY(append(lowering, inst, fields.view()));
+    }
+
+    case Inst::push: {
+        auto pushed = Vector<Value>();
+        auto array = value;
+        while (lowering.function()[array].kind == Inst::push) {
+            auto operands = lowering.function().operands_of(array);
+            TRY(pushed.append(operands[1]));
+            array = operands[0];
+        }
+        if (lowering.function()[array].kind != Inst::create_array) {
+            return Value();
+        }
+        auto elements = Vector<Value>();
+        for (auto element : pushed.in_reverse()) {
+            auto frozen = TRY(freeze(lowering, element));
+            if (!frozen.is_valid()) {
+                return Value();
+            }
+            TRY(elements.append(frozen));
+        }
+        return TRY(append(lowering, Inst {
+            .kind = Inst::constant_array,
+            .type = inst.type,
+            .shape = inst.shape,
+        }, elements.view()));
+    }
+
+    default:
+        return Value();
+    }
+}
+
+static bool is_readonly(Lowering& lowering, Type type, u32 depth)
+{
+    if (type.is_readonly()) {
+        return true;
+    }
+    if (type != Type::named || depth > max_type_depth) {
+        return false;
+    }
+    auto name = type.name().view_in(lowering.source.file);
+    for (auto const* decl : lowering.scope.types) {
+        if (decl->name.view_in(lowering.source.file) == name) {
+            return is_readonly(lowering, decl->type, depth + 1);
+        }
+    }
+    return false;
+}
+
+static ErrorOr<Value> lower_method_call(Lowering& lowering, MethodCall const& call)
+{
+    auto file = lowering.source.file;
+    bool is_lvalue = call.object.value == Expr::lvalue_expr;
+    if (is_lvalue && call.object.value.as.lvalue_expr.view_in(file) == "super"sv) {
+        return TRY(lower_super_call(lowering, call));
+    }
+    if (!is_lvalue || is_variable(lowering, call.object.value.as.lvalue_expr.view_in(file))) {
+        if (is_array_method(call.name.view_in(file))) {
+            return TRY(lower_array_chain(lowering, call));
+        }
+        return TRY(lower_virtual_call(lowering, call));
+    }
+
+    auto args = TRY(lower_args(lowering, call.args.view()));
+    return TRY(append(lowering, Inst {
+        .kind = Inst::call_method,
+        .type = Type::void_,
+        .as = { .method = { .object = call.object.value.as.lvalue_expr, .member = call.name } },
+    }, args.view()));
+}
+
+static ErrorOr<Value> lower_array_chain(Lowering& lowering, MethodCall const& last)
+{
+    // xs.map(f).filter(g).reduce(h, 0) is one loop over xs handing each
+    // element through f, g and h in turn, so the arrays in between are
+    // never built. That's only the same as calling the methods one after
+    // the other when the callbacks can't see each other run.
+    auto file = lowering.source.file;
+    auto stages = Vector<MethodCall const*>();
+    auto const* source = &last.object;
+    for (auto const* call = &last;;) {
+        auto name = call->name.view_in(file);
+        if (!is_array_method(name)) {
+            return Error::from_string_literal("unknown array method");
+        }
+        if (call->args.size() != (name == "reduce"sv ? 2 : 1) || !call->args[0].default_value) {
+            return Error::from_string_literal("wrong number of arguments");
+        }
+        if ((name == "reduce"sv || name == "forEach"sv) && call != &last) {
+            return Error::from_string_literal("reduce and forEach have to end a chain of array methods");
+        }
+        auto const& callback = call->args[0].default_value->value;
+        auto visiting = Vector<FuncDecl const*>();
+        bool is_pure = callback == Expr::lvalue_expr && !is_variable(lowering, callback.as.lvalue_expr.view_in(file))
+            ? is_pure_function(lowering, callback.as.lvalue_expr.view_in(file), visiting)
+            : is_pure_callback(lowering, callback, visiting);
+        if (!is_pure && name != "forEach"sv) {
+            return Error::from_string_literal("callbacks of array methods have to be pure");
+        }
+        TRY(stages.append(call));
+        // forEach is called for what its callback does, so whatever comes
+        // before it has to be done first for those effects to happen in
+        // the same order.
+        if (!is_pure) {
+            source = &call->object;
+            break;
+        }
+        if (call->object.value != Expr::method_call) {
+            source = &call->object;
+            break;
+        }
+        call = call->object.value.as.method_call;
+    }
+
+    auto array = TRY(lower_rvalue(lowering, *source));
+    if (lowering.function()[array].type != Type::array) {
+        return Error::from_string_literal("array methods can only be called on arrays");
+    }
+    auto index_name = TRY(loop_variable(lowering, "index"sv));
+    auto result_name = TRY(loop_variable(lowering, "result"sv));
+    bool is_reduce = last.name.view_in(file) == "reduce"sv;
+    bool is_for_each = last.name.view_in(file) == "forEach"sv;
+
+    auto length = TRY(append(lowering, Inst { .kind = Inst::length, .type = Type::index }, View(&array, 1)));
+    auto zero = TRY(append(lowering, Inst {
+        .kind = Inst::constant_number,
+        .type = Type::index,
+        .as = { .number = 0.0 },
+    }));
+    auto result = Value();
+    if (is_reduce) {
+        result = TRY(lower_rvalue(lowering, *last.args[1].default_value));
+    } else if (!is_for_each) {
+        // Its type is only known once the last callback has been lowered.
+        result = TRY(append(lowering, Inst { .kind = Inst::create_array, .type = Type::none }, View(&length, 1)));
+    }
+    auto output = result;
+    TRY(write_variable(lowering, index_name, lowering.current, zero));
+    if (!is_for_each) {
+        TRY(write_variable(lowering, result_name, lowering.current, result));
+    }
+
+    auto header = TRY(lowering.function().create_block());
+    auto body = TRY(lowering.function().create_block());
+    auto latch = TRY(lowering.function().create_block());
+    auto exit = TRY(lowering.function().create_block());
+
+    // The header isn't sealed before the latch jumps back to it.
+    TRY(jump(lowering, header));
+    lowering.current = header;
+    Value compare[] = { TRY(read_variable(lowering, index_name, header)), length };
+    auto cond = TRY(append(lowering, Inst { .kind = Inst::lt, .type = Type::boolean }, View<Value const>(compare, 2)));
+    TRY(branch(lowering, cond, body, exit));
+
+    TRY(seal_block(lowering, body));
+    lowering.current = body;
+    Value get[] = { array, compare[0] };
+    auto element = TRY(append(lowering, Inst {
+        .kind = Inst::get_element,
+        .type = lowering.function()[array].type.element_type(),
+        .shape = lowering.function()[array].shape,
+    }, View<Value const>(get, 2)));
+    for (u32 i = stages.size(); i > 0; i--) {
+        auto const& stage = *stages[i - 1];
+        auto name = stage.name.view_in(file);
+        auto const& callback = *stage.args[0].default_value;
+        if (name == "map"sv) {
+            element = TRY(apply_callback(lowering, callback, View(&element, 1)));
+            if (!element.is_valid()) {
+                return Error::from_string_literal("map callbacks have to return a value");
+            }
+            continue;
+        }
+        if (name == "filter"sv) {
+            auto keep = TRY(apply_callback(lowering, callback, View(&element, 1)));
+            if (!keep.is_valid() || lowering.function()[keep].type != Type::boolean) {
+                return Error::from_string_literal("filter callbacks have to return a boolean");
+            }
+            auto next = TRY(lowering.function().create_block());
+            TRY(branch(lowering, keep, next, latch));
+            TRY(seal_block(lowering, next));
+            lowering.current = next;
+            continue;
+        }
+        if (name == "forEach"sv) {
+            TRY(apply_callback(lowering, callback, View(&element, 1)));
+            continue;
+        }
+        Value args[] = { TRY(read_variable(lowering, result_name, lowering.current)), element };
+        auto acc = TRY(apply_callback(lowering, callback, View<Value const>(args, 2)));
+        if (!acc.is_valid()) {
+            return Error::from_string_literal("reduce callbacks have to return a value");
+        }
+        TRY(write_variable(lowering, result_name, lowering.current, acc));
+    }
+    if (!is_reduce && !is_for_each) {
+        auto element_type = TypeArg { .type = lowering.function()[element].type, .shape = lowering.function()[element].shape };
+        lowering.function()[output].type = Type::from_array(new Type(element_type.type));
+        lowering.function()[output].shape = element_type.shape;
+        Value operands[] = { TRY(read_variable(lowering, result_name, lowering.current)), element };
+        auto pushed = TRY(append(lowering, Inst {
+            .kind = Inst::push,
+            .type = lowering.function()[output].type,
+            .shape = element_type.shape,
+        }, View<Value const>(operands, 2)));
+        TRY(write_variable(lowering, result_name, lowering.current, pushed));
+    }
+    TRY(jump(lowering, latch));
+
+    TRY(seal_block(lowering, latch));
+    lowering.current = latch;
+    Value increment[] = {
+        TRY(read_variable(lowering, index_name, latch)),
+        TRY(append(lowering, Inst {
+            .kind = Inst::constant_number,
+            .type = Type::index,
+            .as = { .number = 1.0 },
+        })),
+    };
+    auto next_index = TRY(append(lowering, Inst { .kind = Inst::add, .type = Type::index }, View<Value const>(increment, 2)));
+    TRY(write_variable(lowering, index_name, latch, next_index));
+    TRY(jump(lowering, header));
+    TRY(seal_block(lowering, header));
+
+    TRY(seal_block(lowering, exit));
+    lowering.current = exit;
+    if (is_for_each) {
+        return TRY(lowering.function().create_value(Inst { .kind = Inst::undef, .type = Type::void_ }));
+    }
+    return TRY(read_variable(lowering, result_name, exit));
+}
+
+static ErrorOr<Value> lower_virtual_call(Lowering& lowering, MethodCall const& call)
+{
+    // Which function runs depends on the class of the instance, unless a
+    // pass can tell it's always the same one.
+    auto& module = lowering.module;
+    auto object = TRY(lower_rvalue(lowering, call.object));
+    if (lowering.function()[object].type != Type::instance) {
+        return Error::from_string_literal("unknown array method");
+    }
+    auto const& class_ = module[module.find_class(lowering.function()[object].shape).value()];
+    auto slot = TRY(class_.methods.find(call.name.view_in(lowering.source.file)).or_throw([] {
+        return Error::from_string_literal("class has no such method");
+    }));
+    auto args = TRY(lower_args(lowering, call.args.view()));
+    auto const& callee = module[class_.implementations[slot.raw()]];
+    if (args.size() + 1 != callee.params.size()) {
+        return Error::from_string_literal("wrong number of arguments");
+    }
+    auto operands = Vector<Value>();
+    TRY(operands.append(object));
+    for (u32 i = 0; i < args.size(); i++) {
+        auto const& param = callee[callee.params[i + 1]];
+        TRY(operands.append(TRY(coerce(lowering, args[i], TypeArg { .type = param.type, .shape = param.shape }))));
+    }
+    return TRY(append(lowering, Inst {
+        .kind = Inst::call_virtual,
+        .type = callee.return_type,
+        .shape = callee.return_shape,
+        .as = { .index = slot.raw() },
+    }, operands.view()));
+}
+
+static ErrorOr<Value> lower_super_call(Lowering& lowering, MethodCall const& call)
+{
+    // super.method() always means the base's, so it's a direct call.
+    auto& module = lowering.module;
+    if (!lowering.class_.is_valid() || !module[lowering.class_].base.is_valid()) {
+        return Error::from_string_literal("super used outside of a derived class");
+    }
+    auto const& base = module[module[lowering.class_].base];
+    auto slot = TRY(base.methods.find(call.name.view_in(lowering.source.file)).or_throw([] {
+        return Error::from_string_literal("class has no such method");
+    }));
+    auto args = Vector<Value>();
+    TRY(args.append(TRY(read_variable(lowering, "this"sv, lowering.current))));
+    for (auto arg : TRY(lower_args(lowering, call.args.view()))) {
+        TRY(args.append(arg));
+    }
+    return TRY(call_function(lowering, base.implementations[slot.raw()], move(args)));
+}
+
+static ErrorOr<Vector<Value>> lower_args(Lowering& lowering, View<VarDecl const> args)
+{
+    auto values = Vector<Value>();
+    for (auto const& arg : args) {
+        if (!arg.default_value) {
+            return Error::from_string_literal("expected some value for function parameter");
+        }
+        TRY(values.append(TRY(lower_rvalue(lowering, *arg.default_value))));
+    }
+    return values;
+}
+
+static ErrorOr<Value> apply_callback(Lowering& lowering, RValue const& callback, View<Value const> args)
+{
+    auto file = lowering.source.file;
+    if (callback.value == Expr::lvalue_expr) {
+        auto name = callback.value.as.lvalue_expr.view_in(file);
+        if (is_variable(lowering, name)) {
+            return Error::from_string_literal("callbacks have to be arrow functions or function names");
+        }
+        if (auto const* closure = find_closure(lowering, name)) {
+            return TRY(apply_callback(lowering, *closure, args));
+        }
+        for (auto const* decl : lowering.generics.decls) {
+            if (decl->name.view_in(file) == name) {
+                return Error::from_string_literal("generic functions can't be used as callbacks");
+            }
+        }
+        auto callee = TRY(lowering.module.find(name).or_throw([] {
+            return Error::from_string_literal("call to undeclared function");
+        }));
+        auto values = Vector<Value>();
+        for (auto arg : args) {
+            TRY(values.append(arg));
+        }
+        return TRY(call_function(lowering, callee, move(values)));
+    }
+    if (callback.value != Expr::arrow_func) {
+        return Error::from_string_literal("callbacks have to be arrow functions or function names");
+    }
+
+    // The body is lowered in place with the parameters bound like
+    // variables.
+    auto const& arrow = *callback.value.as.arrow_func;
+    if (arrow.params.size() != args.size()) {
+        return Error::from_string_literal("wrong number of arguments");
+    }
+    if (lowering.closure_depth == max_closure_depth) {
+        return Error::from_string_literal("closures can't call themselves");
+    }
+    auto scope = begin_scope(lowering);
+    for (u32 i = 0; i < args.size(); i++) {
+        TRY(bind_variable(lowering, scope, arrow.params[i].name.view_in(file), args[i]));
+    }
+    lowering.closure_depth++;
+    auto value = TRY(lower_expr(lowering, arrow.body.value));
+    lowering.closure_depth--;
+    end_scope(lowering, scope);
+    return value;
+}
+
+static ErrorOr<Value> call_function(Lowering& lowering, IR::FunctionId callee, Vector<Value>&& args)
+{
+    if (lowering.module[callee].params.size() != args.size()) {
+        return Error::from_string_literal("wrong number of arguments");
+    }
+    for (u32 i = 0; i < args.size(); i++) {
+        auto const& param = lowering.module[callee][lowering.module[callee].params[i]];
+        args[i] = TRY(coerce(lowering, args[i], TypeArg {
+            .type = param.type,
+            .shape = param.shape,
+        }));
+    }
+
+    auto type = lowering.module[callee].return_type;
+    if (lowering.module[callee].is_async) {
+        type = Type::from_promise(new Type(type));
+    }
+    return TRY(append(lowering, Inst {
+        .kind = Inst::call,
+        .type = type,
+        .shape = lowering.module[callee].return_shape,
+        .as = { .callee = callee },
+    }, args.view()));
+}
+
+static bool is_variable(Lowering& lowering, StringView name)
+{
+    name = variable_name(lowering, name);
+    for (auto const& definition : lowering.definitions) {
+        if (definition.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_array_method(StringView name)
+{
+    for (auto method : array_methods) {
+        if (method == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_pure_callback(Lowering& lowering, Expr const& expr, Vector<FuncDecl const*>& visiting)
+{
+    // Assignments only ever change parameters, but are still ruled out
+    // rather than told apart from ones that matter.
+    auto is_pure = [&](Expr const& inner) {
+        return is_pure_callback(lowering, inner, visiting);
+    };
+    switch (expr) {
+    case Expr::none:
+    case Expr::func_decl:
+    case Expr::type_decl:
+    case Expr::class_decl:
+    case Expr::break_stmt:
+    case Expr::lvalue_expr:
+    case Expr::string_literal:
+    case Expr::number_literal:
+        return true;
+    case Expr::throw_stmt:
+    case Expr::yield_stmt:
+    case Expr::for_stmt:
+    case Expr::for_of_stmt:
+    case Expr::new_expr:
+        return false;
+    case Expr::index_expr:
+        return is_pure(expr.as.index_expr->object.value) && is_pure(expr.as.index_expr->index.value);
+    case Expr::block:
+        for (auto const& inner : expr.as.block->exprs.view()) {
+            if (!is_pure(inner)) {
+                return false;
+            }
+        }
+        return true;
+    case Expr::var_decl:
+        return !expr.as.var_decl->default_value || is_pure(expr.as.var_decl->default_value->value);
+    case Expr::if_stmt:
+        return is_pure(expr.as.if_stmt->cond.value)
+            && is_pure(expr.as.if_stmt->then)
+            && is_pure(expr.as.if_stmt->else_);
+    case Expr::switch_stmt:
+        if (!is_pure(expr.as.switch_stmt->value.value)) {
+            return false;
+        }
+        for (auto const& case_ : expr.as.switch_stmt->cases.view()) {
+            if (case_.value.has_value() && !is_pure(case_.value->value)) {
+                return false;
+            }
+            for (auto const& inner : case_.body.view()) {
+                if (!is_pure(inner)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    case Expr::return_stmt:
+        return is_pure(expr.as.return_stmt->value.value);
+    case Expr::unary_expr:
+        return expr.as.unary_expr->op != Token::kw_await && is_pure(expr.as.unary_expr->value.value);
+    case Expr::binary_expr:
+        return expr.as.binary_expr->op != Token::op_assign
+            && is_pure(expr.as.binary_expr->lhs.value)
+            && is_pure(expr.as.binary_expr->rhs.value);
+    case Expr::dot_expr:
+        return is_pure(expr.as.dot_expr->rhs.value);
+    case Expr::rvalue_expr:
+        return is_pure(expr.as.rvalue_expr->value);
+    case Expr::arrow_func:
+        return is_pure(expr.as.arrow_func->body.value);
+    case Expr::object_literal:
+        for (auto const& field : expr.as.object_literal->fields.view()) {
+            if (!is_pure(field.value.value)) {
+                return false;
+            }
+        }
+        return true;
+    case Expr::array_literal:
+        for (auto const& item : expr.as.array_literal->items.view()) {
+            if (!is_pure(item.value)) {
+                return false;
+            }
+        }
+        return true;
+    case Expr::template_literal:
+        for (auto const& value : expr.as.template_literal->values.view()) {
+            if (!is_pure(value.value)) {
+                return false;
+            }
+        }
+        return true;
+    case Expr::method_call: {
+        auto const& call = *expr.as.method_call;
+        if (!is_array_method(call.name.view_in(lowering.source.file)) || !is_pure(call.object.value)) {
+            return false;
+        }
+        for (auto const& arg : call.args.view()) {
+            if (arg.default_value && !is_pure(arg.default_value->value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    case Expr::func_call: {
+        auto const& call = *expr.as.func_call;
+        for (auto const& arg : call.args.view()) {
+            if (arg.default_value && !is_pure(arg.default_value->value)) {
+                return false;
+            }
+        }
+        return is_pure_function(lowering, call.name.view_in(lowering.source.file), visiting);
+    }
+    }
+    return false;
+}
+
+static bool is_pure_function(Lowering& lowering, StringView name, Vector<FuncDecl const*>& visiting)
+{
+    if (auto const* closure = find_closure(lowering, name)) {
+        if (lowering.closure_depth == max_closure_depth) {
+            return false;
+        }
+        lowering.closure_depth++;
+        bool is_pure = is_pure_callback(lowering, closure->value, visiting);
+        lowering.closure_depth--;
+        return is_pure;
+    }
+    for (auto const* decl : lowering.decls) {
+        if (decl->name.view_in(lowering.source.file) != name) {
+            continue;
+        }
+        // Calls back into a function being looked at add nothing new.
+        if (visiting.find(decl).has_value()) {
+            return true;
+        }
+        if (!visiting.append(decl).has_value()) {
+            return false;
+        }
+        for (auto const& inner : decl->block.exprs.view()) {
+            if (!is_pure_callback(lowering, inner, visiting)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+static RValue const* find_closure(Lowering& lowering, StringView name)
+{
+    for (u32 i = lowering.closures.size(); i > 0; i--) {
+        if (lowering.closures[i - 1].name == name) {
+            return lowering.closures[i - 1].value;
+        }
+    }
+    return nullptr;
+}
+
+static ErrorOr<StringView> loop_variable(Lowering& lowering, StringView name)
+{
+    // Names no program can use, one set per loop.
+    auto* buffer = new StringBuffer(TRY(StringBuffer::create_fill("#"sv, name, lowering.loops++)));
+    return buffer->view();
+}
+
+static ErrorOr<StringView> declare_variable(Lowering& lowering, StringView name)
+{
+    if (lowering.generator_loops.is_empty()) {
+        return name;
+    }
+    auto renamed = TRY(loop_variable(lowering, name));
+    TRY(lowering.renames.append(Rename { name, renamed }));
+    return renamed;
+}
+
+static StringView variable_name(Lowering& lowering, StringView name)
+{
+    for (u32 i = lowering.renames.size(); i > 0; i--) {
+        if (lowering.renames[i - 1].name == name) {
+            return lowering.renames[i - 1].renamed;
+        }
+    }
+    return name;
+}
+
+static ErrorOr<IR::ShapeId> find_or_create_shape(IR::Module& module, IR::Shape&& shape)
+{
+    for (u32 i = 0; i < module.shapes.size(); i++) {
+        auto const& other = module.shapes[i];
+        if (other.fields.size() != shape.fields.size() || module.find_class(IR::ShapeId(i)).has_value()) {
+            continue;
+        }
+        if (other.tag != shape.tag || other.variants.size() != shape.variants.size()) {
+            continue;
+        }
+        bool is_same = true;
+        for (u32 j = 0; j < shape.fields.size(); j++) {
+            is_same = is_same
+                && other.fields[j] == shape.fields[j]
+                && other.types[j].is_same(shape.types[j])
+                && other.shapes[j] == shape.shapes[j];
+        }
+        for (u32 j = 0; j < shape.variants.size(); j++) {
+            is_same = is_same
+                && other.tags[j] == shape.tags[j]
+                && other.variants[j] == shape.variants[j];
+        }
+        if (is_same) {
+            return IR::ShapeId(i);
+        }
+    }
+    return TRY(module.shapes.append(move(shape)));
+}
+
+static ErrorOr<Value> coerce(Lowering& lowering, Value value, TypeArg to)
+{
+    auto from = lowering.function()[value].shape;
+    if (to.type == Type::instance && lowering.function()[value].type == Type::instance && from != to.shape) {
+        auto const& module = lowering.module;
+        if (!module.is_subclass(module.find_class(from).value(), module.find_class(to.shape).value())) {
+            return Error::from_string_literal("instance used where an unrelated class is expected");
+        }
+        return TRY(append(lowering, Inst {
+            .kind = Inst::upcast,
+            .type = Type::instance,
+            .shape = to.shape,
+        }, View(&value, 1)));
+    }
+    if (to.type != Type::object || lowering.function()[value].type != Type::object || from == to.shape) {
+        return value;
+    }
+    if (lowering.module[to.shape].is_union()) {
+        return TRY(coerce_to_union(lowering, value, to.shape));
+    }
+    if (lowering.module[from].is_union()) {
+        return Error::from_string_literal("union used where an object type is expected");
+    }
+
+    // Objects are rebuilt field by field in the layout of the type they're
+    // used as. Building the copy is free once the objects are taken apart.
+    auto& module = lowering.module;
+    auto values = Vector<Value>();
+    for (u32 i = 0; i < module[to.shape].fields.size(); i++) {
+        auto name = module[to.shape].fields[i];
+        auto type = module[to.shape].types[i];
+        auto shape = module[to.shape].shapes[i];
+        if (IR::Shape::is_presence(name)) {
+            auto field = name.shrink(1);
+            if (auto presence = module[from].find_presence(field); presence.has_value()) {
+                TRY(values.append(TRY(append(lowering, Inst {
+                    .kind = Inst::get_field,
+                    .type = Type::boolean,
+                    .as = { .index = presence.value() },
+                }, View(&value, 1)))));
+                continue;
+            }
+            TRY(values.append(TRY(append(lowering, Inst {
+                .kind = Inst::constant_boolean,
+                .type = Type::boolean,
+                .as = { .boolean = module[from].find(field).has_value() },
+            }))));
+            continue;
+        }
+        if (auto index = module[from].find(name); index.has_value()) {
+            if (module[from].types[index.value()] != type) {
+                return Error::from_string_literal("object field has the wrong type");
+            }
+            auto field = TRY(append(lowering, Inst {
+                .kind = Inst::get_field,
+                .type = type,
+                .shape = module[from].shapes[index.value()],
+                .as = { .index = index.value() },
+            }, View(&value, 1)));
+            TRY(values.append(TRY(coerce(lowering, field, TypeArg { .type = type, .shape = shape }))));
+            continue;
+        }
+        if (!module[to.shape].find_presence(name).has_value()) {
+            return Error::from_string_literal("object is missing a field");
+        }
+        TRY(values.append(TRY(lowering.function().create_value(Inst {
+            .kind = Inst::undef,
+            .type = type,
+            .shape = shape,
+        }))));
+    }
+    return TRY(append(lowering, Inst {
+        .kind = Inst::object,
+        .type = Type::object,
+        .shape = to.shape,
+    }, values.view()));
+}
+
+static ErrorOr<Value> coerce_to_union(Lowering& lowering, Value value, IR::ShapeId to)
+{
+    // Which variant an object literal is comes from its tag, which has to
+    // be known while compiling.
+    auto& function = lowering.function();
+    auto const& from = lowering.module[function[value].shape];
+    auto const& union_ = lowering.module[to];
+    auto field = from.find(union_.tag);
+    if (from.is_union() || !field.has_value() || function[value].kind != Inst::object) {
+        return Error::from_string_literal("can only make unions from object literals with a tag");
+    }
+    auto const& tag = function[function.operands_of(value)[field.value()]];
+    if (tag.kind != Inst::constant_string) {
+        return Error::from_string_literal("the tag of a union member has to be a string literal");
+    }
+    auto variant = TRY(union_.find_variant(tag.as.string).or_throw([] {
+        return Error::from_string_literal("no variant of the union has this tag");
+    }));
+    auto shape = union_.variants[variant];
+    auto object = TRY(coerce(lowering, value, TypeArg { .type = Type::object, .shape = shape }));
+    return TRY(append(lowering, Inst {
+        .kind = Inst::wrap,
+        .type = Type::object,
+        .shape = to,
+        .as = { .index = variant },
+    }, View(&object, 1)));
+}
+
+static ErrorOr<Value> lower_number_literal(Lowering& lowering, Token token)
+{
+    auto text = token.view_in(lowering.source.file);
+    auto number = TRY(Parse<f64>::from(text).or_throw([] {
+        return Error::from_string_literal("invalid number literal");
+    }));
+    return TRY(append(lowering, Inst {
+        .kind = Inst::constant_number,
+        .type = Type::number,
+        .as = { .number = number },
+    }));
+}
+
+static ErrorOr<Value> lower_string_literal(Lowering& lowering, Token token)
+{
+    // The token view starts at the opening quote and stops just short of
+    // the closing one.
+    auto text = token.view_in(lowering.source.file).chop_left(1);
+    return TRY(append(lowering, Inst {
+        .kind = Inst::constant_string,
+        .type = Type::string,
+        .as = { .string = text },
+    }));
+}
+
+static ErrorOr<Value> append(Lowering& lowering, Inst inst, View<Value const> operands)
+{
+    if (operands.size() == 0) {
+        return TRY(lowering.function().append(lowering.current, inst));
+    }
+    return TRY(lowering.function().append(lowering.current, inst, operands));
+}
+
+static ErrorOr<void> jump(Lowering& lowering, BlockId to)
+{
+    if (is_terminated(lowering)) {
+        return {};
+    }
+    TRY(append(lowering, Inst {
+        .kind = Inst::jump,
+        .type = Type::void_,
+        .as = { .target = to },
+    }));
+    TRY(lowering.function()[to].preds.append(lowering.current));
+    return {};
+}
+
+static ErrorOr<void> branch(Lowering& lowering, Value cond, BlockId then_, BlockId else_)
+{
+    auto from = lowering.current;
+    TRY(append(lowering, Inst {
+        .kind = Inst::branch,
+        .type = Type::void_,
+        .as = { .branch = { .then_ = then_, .else_ = else_ } },
+    }, View(&cond, 1)));
+    TRY(lowering.function()[then_].preds.append(from));
+    TRY(lowering.function()[else_].preds.append(from));
+    return {};
+}
+
+static LocalScope begin_scope(Lowering& lowering)
+{
+    return LocalScope {
+        .block = lowering.current,
+        .first_block = lowering.function().blocks.size(),
+        .first_definition = lowering.definitions.size(),
+        .first_rename = lowering.renames.size(),
+    };
+}
+
+static ErrorOr<void> bind_variable(Lowering& lowering, LocalScope& scope, StringView name, Value value)
+{
+    name = TRY(declare_variable(lowering, name));
+    auto shadowed = Optional<Value>();
+    for (auto const& definition : lowering.definitions) {
+        if (definition.name == name && definition.block == scope.block) {
+            shadowed = definition.value;
+        }
+    }
+    TRY(scope.names.append(name));
+    TRY(scope.shadowed.append(move(shadowed)));
+    TRY(write_variable(lowering, name, scope.block, value));
+    return {};
+}
+
+static void end_scope(Lowering& lowering, LocalScope const& scope)
+{
+    while (lowering.renames.size() > scope.first_rename) {
+        (void)lowering.renames.pop();
+    }
+    // Definitions made while the scope was open, including the ones
+    // reads leave behind in blocks on the way, are forgotten.
+    for (u32 i = 0; i < scope.names.size(); i++) {
+        for (u32 j = 0; j < lowering.definitions.size(); j++) {
+            auto& definition = lowering.definitions[j];
+            if (definition.name != scope.names[i]) {
+                continue;
+            }
+            if (definition.block == scope.block && scope.shadowed[i].has_value()) {
+                definition.value = scope.shadowed[i].value();
+                continue;
+            }
+            if (definition.block == scope.block || definition.block.raw() >= scope.first_block || j >= scope.first_definition) {
+                definition.name = StringView();
+            }
+        }
+    }
+}
+
+static ErrorOr<void> start_unreachable_block(Lowering& lowering)
+{
+    lowering.current = TRY(lowering.function().create_block());
+    TRY(seal_block(lowering, lowering.current));
+    return {};
+}
+
+static bool is_terminated(Lowering& lowering)
+{
+    auto& function = lowering.function();
+    auto const& insts = function[lowering.current].insts;
+    if (insts.is_empty()) {
+        return false;
+    }
+    return function[insts.last()].is_terminator();
+}
+
+static bool is_reachable(Lowering& lowering)
+{
+    if (is_terminated(lowering)) {
+        return false;
+    }
+    return lowering.current == IR::Function::entry || !lowering.function()[lowering.current].preds.is_empty();
+}
+
+static ErrorOr<void> write_variable(Lowering& lowering, StringView name, BlockId block, Value value)
+{
+    for (auto& definition : lowering.definitions) {
+        if (definition.name == name && definition.block == block) {
+            definition.value = value;
+            return {};
+        }
+    }
+    TRY(lowering.definitions.append(Definition {
+        .name = name,
+        .block = block,
+        .value = value,
+    }));
+    return {};
+}
+
+static ErrorOr<Value> read_variable(Lowering& lowering, StringView name, BlockId block)
+{
+    for (auto const& definition : lowering.definitions) {
+        if (definition.name == name && definition.block == block) {
+            return definition.value;
+        }
+    }
+    return TRY(read_variable_recursive(lowering, name, block));
+}
+
+static ErrorOr<Value> read_variable_recursive(Lowering& lowering, StringView name, BlockId block)
+{
+    auto& function = lowering.function();
+    auto value = Value();
+    if (!is_sealed(lowering, block)) {
+        value = TRY(create_phi(lowering, block));
+        TRY(lowering.incomplete_phis.append(IncompletePhi {
+            .name = name,
+            .block = block,
+            .phi = value,
+        }));
+        // Loop headers are the only blocks left unsealed, and the value
+        // coming into the loop gives the phi its type before the back
+        // edge is known.
+        if (!function[block].preds.is_empty()) {
+            TRY(write_variable(lowering, name, block, value));
+            auto incoming = TRY(read_variable(lowering, name, function[block].preds[0]));
+            function[value].type = function[incoming].type;
+            function[value].shape = function[incoming].shape;
+        }
+    } else if (function[block].preds.size() == 1) {
+        value = TRY(read_variable(lowering, name, function[block].preds[0]));
+    } else if (function[block].preds.is_empty()) {
+        if (block == IR::Function::entry) {
+            return Error::from_string_literal("use of undeclared variable");
+        }
+        value = TRY(function.create_value(Inst { .kind = Inst::undef }));
+    } else {
+        value = TRY(create_phi(lowering, block));
+        TRY(write_variable(lowering, name, block, value));
+        value = TRY(add_phi_operands(lowering, name, block, value));
+    }
+    TRY(write_variable(lowering, name, block, value));
+    return value;
+}
+
+static ErrorOr<Value> create_phi(Lowering& lowering, BlockId block)
+{
+    auto& function = lowering.function();
+    auto phi = TRY(function.create_value(Inst { .kind = Inst::phi }));
+    TRY(function[block].phis.append(phi));
+    return phi;
+}
+
+static ErrorOr<Value> add_phi_operands(Lowering& lowering, StringView name, BlockId block, Value phi)
+{
+    auto& function = lowering.function();
+    auto values = Vector<Value>();
+    for (u32 i = 0; i < function[block].preds.size(); i++) {
+        TRY(values.append(TRY(read_variable(lowering, name, function[block].preds[i]))));
+    }
+    function[phi].operands = TRY(function.create_operands(values.view()));
+    for (auto value : values.view()) {
+        if (function[value].type != Type::none) {
+            function[phi].type = function[value].type;
+            function[phi].shape = function[value].shape;
+            break;
+        }
+    }
+    return phi;
+}
+
+static ErrorOr<void> seal_block(Lowering& lowering, BlockId block)
+{
+    for (u32 i = 0; i < lowering.incomplete_phis.size(); i++) {
+        auto incomplete = lowering.incomplete_phis[i];
+        if (incomplete.block == block) {
+            TRY(add_phi_operands(lowering, incomplete.name, block, incomplete.phi));
+        }
+    }
+    TRY(lowering.sealed.append(block));
+    return {};
+}
+
+static bool is_sealed(Lowering& lowering, BlockId block)
+{
+    return lowering.sealed.find(block).has_value();
+}
@@ -0,0 +1,5 @@
+#pragma once
+#include "./IR.h"
+#include "./Parse.h"
+
+ErrorOr<IR::Module> lower(Source, ParseTree const&);
@@ -0,0 +1,69 @@
+#include "./Passes.h"
+
+static bool may_throw(IR::Module const&, IR::Function const&);
+static bool may_dispatch_throw(IR::Module const&, IR::Function const&, IR::Value);
+
+ErrorOr<bool> analyze_may_throw(IR::Module& module)
+{
+    // Start out assuming nothing throws and only mark functions that reach
+    // a throw or a call to a function already known to throw, until
+    // nothing new is found. Functions that stop throwing after other
+    // passes have run will be cleared again on the next round.
+    auto previous = TRY(Vector<bool>::create(module.functions.size()));
+    for (auto& function : module.functions) {
+        TRY(previous.append(function.may_throw));
+        function.may_throw = false;
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& function : module.functions) {
+            if (!function.may_throw && may_throw(module, function)) {
+                function.may_throw = true;
+                changed = true;
+            }
+        }
+    }
+
+    for (u32 i = 0; i < module.functions.size(); i++) {
+        if (module.functions[i].may_throw != previous[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool may_throw(IR::Module const& module, IR::Function const& function)
+{
+    for (auto const& block : function.blocks) {
+        for (auto value : block.insts.view()) {
+            auto const& inst = function[value];
+            if (inst.kind == IR::Inst::throw_) {
+                return true;
+            }
+            if (inst.kind == IR::Inst::await_) {
+                return true;
+            }
+            // Member calls only reach the runtime library, which never throws.
+            // Async functions reject their promise instead of throwing.
+            if (inst.kind == IR::Inst::call && module[inst.as.callee].may_throw && !module[inst.as.callee].is_async) {
+                return true;
+            }
+            if (inst.kind == IR::Inst::call_virtual && may_dispatch_throw(module, function, value)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool may_dispatch_throw(IR::Module const& module, IR::Function const& function, IR::Value value)
+{
+    // Every override is called through the same declaration, so whether
+    // one throws decides for all of them.
+    auto const& receiver = function[function.operands_of(value)[0]];
+    auto class_ = module.find_class(receiver.shape).value();
+    auto slot = function[value].as.index;
+    return module.dispatch_may_throw(module.introducing(class_, slot), slot);
+}
@@ -214,16 +214,37 @@ ErrorOr<Vector<VarDecl>, ParseError> parse_parameters(Parser& parser);
 ErrorOr<FuncDecl, ParseError> parse_function(Parser& parser);
 ErrorOr<FuncCall, ParseError> parse_func_call(Parser& parser);
 ErrorOr<Vector<VarDecl>, ParseError> parse_func_call_args(Parser& parser);
+ErrorOr<Vector<Token>, ParseError> parse_type_params(Parser& parser);
+ErrorOr<Vector<Type>, ParseError> parse_type_args(Parser& parser);
+bool is_type_args(Parser const& parser, usize ahead);
 ErrorOr<Type, ParseError> parse_type(Parser& parser);
+ErrorOr<Type, ParseError> parse_type_member(Parser& parser);
+ErrorOr<Type, ParseError> parse_element_type(Parser& parser);
+ErrorOr<ObjectType, ParseError> parse_object_type(Parser& parser);
+ErrorOr<TypeDecl, ParseError> parse_type_decl(Parser& parser);
+ErrorOr<ClassDecl, ParseError> parse_class(Parser& parser);
 ErrorOr<Block, ParseError> parse_block(Parser& parser);
 ErrorOr<Expr, ParseError> parse_expression(Parser& parser);
+ErrorOr<VarDecl, ParseError> parse_var_decl(Parser& parser);
 ErrorOr<IfStmt, ParseError> parse_if(Parser& parser);
+ErrorOr<SwitchStmt, ParseError> parse_switch(Parser& parser);
+ErrorOr<Expr, ParseError> parse_for(Parser& parser);
 ErrorOr<RValue, ParseError> parse_rvalue(Parser& parser);
+ErrorOr<RValue, ParseError> parse_primary(Parser& parser);
+ErrorOr<RValue, ParseError> parse_postfix(Parser& parser);
+ErrorOr<ObjectLiteral, ParseError> parse_object_literal(Parser& parser);
+ErrorOr<ArrayLiteral, ParseError> parse_array_literal(Parser& parser);
+ErrorOr<TemplateLiteral, ParseError> parse_template_literal(Parser& parser);
+ErrorOr<ArrowFunc, ParseError> parse_arrow_func(Parser& parser);
+ErrorOr<NewExpr, ParseError> parse_new(Parser& parser);
+bool is_arrow_func(Parser const& parser);
+bool has_doc_tag(Parser const& parser, Token token, StringView tag);
 ErrorOr<ThrowStmt, ParseError> parse_throw(Parser& parser);
 ErrorOr<ReturnStmt, ParseError> parse_return(Parser& parser);
+ErrorOr<YieldStmt, ParseError> parse_yield(Parser& parser);
 
 ErrorOr<UnaryExpr, ParseError> parse_unary(Parser& parser);
-ErrorOr<BinaryExpr, ParseError> parse_binary(Parser& parser);
+ErrorOr<RValue, ParseError> parse_binary(Parser& parser, u32 min_precedence);
 ErrorOr<DotExpr, ParseError> parse_dot_expr(Parser& parser);
 
 ErrorOr<ParseTree, ParseError> parse(Source source, View<Token> tokens)
@@ -244,8 +265,22 @@ ErrorOr<ParseTree, ParseError> parse(Source source, View<Token> tokens)
 ErrorOr<FuncDecl, ParseError> parse_function(Parser& parser)
 {
     auto func = FuncDecl();
+    bool is_async = false;
+    if (parser.peek() == Token::kw_async) {
+        TRY(parser.expect(Token::kw_async));
+        is_async = true;
+    }
     TRY(parser.expect(Token::kw_function));
+    bool is_generator = false;
+    if (parser.peek() == Token::sym_star) {
+        TRY(parser.expect(Token::sym_star));
+        is_generator = true;
+    }
     auto name = TRY(parser.expect(Token::lit_ident));
+    auto type_params = Vector<Token>();
+    if (parser.peek() == Token::op_lt) {
+        type_params = TRY(parse_type_params(parser));
+    }
     TRY(parser.expect(Token::sym_lparen));
     auto parameters = TRY(parse_parameters(parser));
     TRY(parser.expect(Token::sym_colon));
@@ -253,18 +288,26 @@ ErrorOr<FuncDecl, ParseError> parse_function(Parser& parser)
     auto block = TRY(parse_block(parser));
     return FuncDecl {
         .name = name,
+        .type_params = move(type_params),
         .args = move(parameters),
         .return_type = type,
         .block = move(block),
+        .is_async = is_async,
+        .is_generator = is_generator,
     };
 }
 
 ErrorOr<FuncCall, ParseError> parse_func_call(Parser& parser)
 {
     auto ident = TRY(parser.expect(Token::lit_ident));
+    auto type_args = Vector<Type>();
+    if (parser.peek() == Token::op_lt) {
+        type_args = TRY(parse_type_args(parser));
+    }
     auto args = TRY(parse_func_call_args(parser));
     return FuncCall {
         .name = ident,
+        .type_args = move(type_args),
         .args = move(args),
     };
 }
@@ -301,20 +344,244 @@ ErrorOr<Vector<VarDecl>, ParseError> parse_parameters(Parser& parser)
             .type = type,
             .default_value = {},
         }));
+        if (parser.peek() == Token::sym_comma) {
+            TRY(parser.expect(Token::sym_comma));
+        }
     }
     TRY(parser.expect(Token::sym_rparen));
     return parameters;
 }
 
+ErrorOr<Vector<Token>, ParseError> parse_type_params(Parser& parser)
+{
+    auto params = Vector<Token>();
+    TRY(parser.expect(Token::op_lt));
+    while (parser.peek() != Token::op_gt) {
+        TRY(params.append(TRY(parser.expect(Token::lit_ident))));
+        if (parser.peek() == Token::sym_comma) {
+            TRY(parser.expect(Token::sym_comma));
+        }
+    }
+    TRY(parser.expect(Token::op_gt));
+    return params;
+}
+
+ErrorOr<Vector<Type>, ParseError> parse_type_args(Parser& parser)
+{
+    auto args = Vector<Type>();
+    TRY(parser.expect(Token::op_lt));
+    while (parser.peek() != Token::op_gt) {
+        TRY(args.append(TRY(parse_type(parser))));
+        if (parser.peek() == Token::sym_comma) {
+            TRY(parser.expect(Token::sym_comma));
+        }
+    }
+    TRY(parser.expect(Token::op_gt));
+    return args;
+}
+
+bool is_type_args(Parser const& parser, usize ahead)
+{
+    // f<T>(x) is a call with type arguments, so look for the closing '>'
+    // followed by '(' before committing to it.
+    if (parser.peek(ahead) != Token::op_lt) {
+        return false;
+    }
+    for (ahead++; parser.peek(ahead).has_value(); ahead++) {
+        auto token = *parser.peek(ahead);
+        if (token.is_type() || token == Token::lit_ident || token == Token::sym_comma) {
+            continue;
+        }
+        return token == Token::op_gt && parser.peek(ahead + 1) == Token::sym_lparen;
+    }
+    return false;
+}
+
 ErrorOr<Type, ParseError> parse_type(Parser& parser)
 {
+    if (parser.peek() == Token::sym_pipe) {
+        TRY(parser.expect(Token::sym_pipe));
+    }
+    auto type = TRY(parse_type_member(parser));
+    if (parser.peek() != Token::sym_pipe) {
+        return type;
+    }
+    auto union_ = UnionType();
+    TRY(union_.members.append(type));
+    while (parser.peek() == Token::sym_pipe) {
+        TRY(parser.expect(Token::sym_pipe));
+        TRY(union_.members.append(TRY(parse_type_member(parser))));
+    }
+    return Type::from_union(new UnionType(move(union_)));
+}
+
+ErrorOr<Type, ParseError> parse_type_member(Parser& parser)
+{
+    if (parser.peek() == Token::kw_readonly) {
+        TRY(parser.expect(Token::kw_readonly));
+        auto type = TRY(parse_type_member(parser));
+        if (type != Type::array) {
+            return ParseError(Error::from_string_literal("only arrays can be readonly"));
+        }
+        return Type::from_readonly_array(&type.element_type());
+    }
+    auto type = TRY(parse_element_type(parser));
+    while (parser.peek() == Token::sym_lbracket) {
+        TRY(parser.expect(Token::sym_lbracket));
+        TRY(parser.expect(Token::sym_rbracket));
+        type = Type::from_array(new Type(type));
+    }
+    return type;
+}
+
+ErrorOr<Type, ParseError> parse_element_type(Parser& parser)
+{
+    if (parser.peek() == Token::lit_string) {
+        return Type::from_literal(*parser.next());
+    }
+    if (parser.peek() == Token::lit_ident && parser.peek(1) == Token::op_lt) {
+        auto name = parser.peek()->view_in(parser.source().file);
+        if (name == "Promise"sv || name == "Generator"sv || name == "ReadonlyArray"sv) {
+            TRY(parser.expect(Token::lit_ident));
+            TRY(parser.expect(Token::op_lt));
+            auto element = new Type(TRY(parse_type(parser)));
+            TRY(parser.expect(Token::op_gt));
+            if (name == "Generator"sv) {
+                return Type::from_generator(element);
+            }
+            if (name == "ReadonlyArray"sv) {
+                return Type::from_readonly_array(element);
+            }
+            return Type::from_promise(element);
+        }
+    }
+    if (parser.peek() == Token::lit_ident) {
+        return Type::from_name(*parser.next());
+    }
+    if (parser.peek() == Token::sym_lcurly) {
+        return Type::from_object(new ObjectType(TRY(parse_object_type(parser))));
+    }
     return Type::from_token(TRY(parser.expect_one_of({
         Token::type_boolean,
         Token::type_number,
+        Token::type_string,
         Token::type_void,
+        Token::lit_ident,
+        Token::lit_string,
+        Token::sym_lcurly,
     })));
 }
 
+ErrorOr<ObjectType, ParseError> parse_object_type(Parser& parser)
+{
+    auto object = ObjectType();
+    TRY(parser.expect(Token::sym_lcurly));
+    while (parser.peek() != Token::sym_rcurly) {
+        // Fields are never assigned to anyway.
+        if (parser.peek() == Token::kw_readonly) {
+            TRY(parser.expect(Token::kw_readonly));
+        }
+        auto name = TRY(parser.expect(Token::lit_ident));
+        bool is_optional = false;
+        if (parser.peek() == Token::sym_question) {
+            TRY(parser.expect(Token::sym_question));
+            is_optional = true;
+        }
+        TRY(parser.expect(Token::sym_colon));
+        auto type = TRY(parse_type(parser));
+        TRY(object.fields.append(FieldType {
+            .name = name,
+            .type = type,
+            .is_optional = is_optional,
+        }));
+        if (parser.peek() == Token::sym_comma) {
+            TRY(parser.expect(Token::sym_comma));
+        } else if (parser.peek() == Token::sym_semicolon) {
+            TRY(parser.expect(Token::sym_semicolon));
+        }
+    }
+    TRY(parser.expect(Token::sym_rcurly));
+    return object;
+}
+
+ErrorOr<TypeDecl, ParseError> parse_type_decl(Parser& parser)
+{
+    auto keyword = TRY(parser.expect_one_of({
+        Token::kw_interface,
+        Token::kw_type,
+    }));
+    auto name = TRY(parser.expect(Token::lit_ident));
+    if (keyword == Token::kw_interface) {
+        return TypeDecl {
+            .name = name,
+            .type = Type::from_object(new ObjectType(TRY(parse_object_type(parser)))),
+            .is_columnar = has_doc_tag(parser, keyword, "@soa"sv),
+        };
+    }
+    TRY(parser.expect(Token::op_assign));
+    return TypeDecl {
+        .name = name,
+        .type = TRY(parse_type(parser)),
+    };
+}
+
+ErrorOr<ClassDecl, ParseError> parse_class(Parser& parser)
+{
+    auto class_ = ClassDecl();
+    TRY(parser.expect(Token::kw_class));
+    class_.name = TRY(parser.expect(Token::lit_ident));
+    if (parser.peek() == Token::kw_extends) {
+        TRY(parser.expect(Token::kw_extends));
+        class_.base = TRY(parser.expect(Token::lit_ident));
+    }
+    TRY(parser.expect(Token::sym_lcurly));
+    while (parser.peek() != Token::sym_rcurly) {
+        if (parser.peek() == Token::kw_readonly) {
+            TRY(parser.expect(Token::kw_readonly));
+        }
+        auto name = TRY(parser.expect(Token::lit_ident));
+        if (parser.peek() == Token::sym_lparen) {
+            TRY(parser.expect(Token::sym_lparen));
+            auto method = FuncDecl {
+                .name = name,
+                .args = TRY(parse_parameters(parser)),
+            };
+            if (name.view_in(parser.source().file) == "constructor"sv) {
+                if (class_.constructor.has_value()) {
+                    return ParseError(Error::from_string_literal("class has more than one constructor"));
+                }
+                method.return_type = Type(Type::void_);
+                method.block = TRY(parse_block(parser));
+                class_.constructor = move(method);
+                continue;
+            }
+            TRY(parser.expect(Token::sym_colon));
+            method.return_type = TRY(parse_type(parser));
+            method.block = TRY(parse_block(parser));
+            TRY(class_.methods.append(move(method)));
+            continue;
+        }
+        auto field = VarDecl {
+            .name = name,
+            .is_mutable = true,
+        };
+        if (parser.peek() == Token::sym_colon) {
+            TRY(parser.expect(Token::sym_colon));
+            field.type = TRY(parse_type(parser));
+        }
+        if (parser.peek() == Token::op_assign) {
+            TRY(parser.expect(Token::op_assign));
+            field.default_value = TRY(parse_rvalue(parser));
+        }
+        TRY(class_.fields.append(move(field)));
+        if (parser.peek() == Token::sym_semicolon) {
+            TRY(parser.expect(Token::sym_semicolon));
+        }
+    }
+    TRY(parser.expect(Token::sym_rcurly));
+    return class_;
+}
+
 ErrorOr<Block, ParseError> parse_block(Parser& parser)
 {
     auto block = Block();
@@ -332,36 +599,97 @@ ErrorOr<Block, ParseError> parse_block(Parser& parser)
 ErrorOr<Expr, ParseError> parse_expression(Parser& parser)
 {
     auto token = TRY(parser.peek_expect_one_of({
+        Token::kw_async,
         Token::kw_function,
+        Token::kw_export,
+        Token::kw_interface,
+        Token::kw_type,
+        Token::kw_class,
+        Token::kw_const,
+        Token::kw_let,
         Token::kw_if,
+        Token::kw_switch,
+        Token::kw_for,
+        Token::kw_break,
         Token::kw_throw,
         Token::kw_return,
+        Token::kw_yield,
         Token::sym_lcurly,
         Token::lit_ident,
+        Token::kw_await,
     }));
 
-    if (token == Token::kw_function) {
+    if (token == Token::kw_async || token == Token::kw_function) {
         return Expr(TRY(parse_function(parser)));
     }
+    if (token == Token::kw_export) {
+        TRY(parser.expect(Token::kw_export));
+        auto func = TRY(parse_function(parser));
+        func.is_exported = true;
+        return Expr(move(func));
+    }
+    if (token == Token::kw_interface || token == Token::kw_type) {
+        return Expr(TRY(parse_type_decl(parser)));
+    }
+    if (token == Token::kw_class) {
+        return Expr(TRY(parse_class(parser)));
+    }
+    if (token == Token::kw_const || token == Token::kw_let) {
+        return Expr(TRY(parse_var_decl(parser)));
+    }
     if (token == Token::kw_if) {
         return Expr(TRY(parse_if(parser)));
     }
+    if (token == Token::kw_switch) {
+        return Expr(TRY(parse_switch(parser)));
+    }
+    if (token == Token::kw_for) {
+        return TRY(parse_for(parser));
+    }
+    if (token == Token::kw_break) {
+        return Expr::break_(TRY(parser.expect(Token::kw_break)));
+    }
     if (token == Token::kw_throw) {
         return Expr(TRY(parse_throw(parser)));
     }
     if (token == Token::kw_return) {
         return Expr(TRY(parse_return(parser)));
     }
+    if (token == Token::kw_yield) {
+        return Expr(TRY(parse_yield(parser)));
+    }
     if (token == Token::sym_lcurly) {
         return Expr(TRY(parse_block(parser)));
     }
-    if (token == Token::lit_ident) {
+    if (token == Token::lit_ident || token == Token::kw_await) {
         return Expr(TRY(parse_rvalue(parser)));
     }
 
     return Error::unreachable();
 }
 
+ErrorOr<VarDecl, ParseError> parse_var_decl(Parser& parser)
+{
+    auto keyword = TRY(parser.expect_one_of({
+        Token::kw_const,
+        Token::kw_let,
+    }));
+    auto name = TRY(parser.expect(Token::lit_ident));
+    auto type = Type();
+    if (parser.peek() == Token::sym_colon) {
+        TRY(parser.expect(Token::sym_colon));
+        type = TRY(parse_type(parser));
+    }
+    TRY(parser.expect(Token::op_assign));
+    auto value = TRY(parse_rvalue(parser));
+    return VarDecl {
+        .name = name,
+        .type = type,
+        .default_value = value,
+        .is_mutable = keyword == Token::kw_let,
+    };
+}
+
 ErrorOr<IfStmt, ParseError> parse_if(Parser& parser)
 {
     TRY(parser.expect(Token::kw_if));
@@ -377,114 +705,421 @@ ErrorOr<IfStmt, ParseError> parse_if(Parser& parser)
     };
 }
 
+ErrorOr<SwitchStmt, ParseError> parse_switch(Parser& parser)
+{
+    TRY(parser.expect(Token::kw_switch));
+    TRY(parser.expect(Token::sym_lparen));
+    auto value = TRY(parse_rvalue(parser));
+    TRY(parser.expect(Token::sym_rparen));
+    TRY(parser.expect(Token::sym_lcurly));
+
+    auto stmt = SwitchStmt {
+        .value = value,
+    };
+    while (parser.peek() != Token::sym_rcurly) {
+        auto label = TRY(parser.expect_one_of({
+            Token::kw_case,
+            Token::kw_default,
+        }));
+        auto switch_case = SwitchCase();
+        if (label == Token::kw_case) {
+            switch_case.value = TRY(parse_rvalue(parser));
+        }
+        TRY(parser.expect(Token::sym_colon));
+        while (parser.peek() != Token::kw_case && parser.peek() != Token::kw_default && parser.peek() != Token::sym_rcurly) {
+            TRY(switch_case.body.append(TRY(parse_expression(parser))));
+            if (parser.peek() == Token::sym_semicolon) {
+                TRY(parser.expect(Token::sym_semicolon));
+            }
+        }
+        TRY(stmt.cases.append(move(switch_case)));
+    }
+    TRY(parser.expect(Token::sym_rcurly));
+    return stmt;
+}
+
+ErrorOr<Expr, ParseError> parse_for(Parser& parser)
+{
+    TRY(parser.expect(Token::kw_for));
+    TRY(parser.expect(Token::sym_lparen));
+    bool is_declaration = parser.peek() == Token::kw_const || parser.peek() == Token::kw_let;
+    if (is_declaration && parser.peek(2) == Token::kw_of) {
+        TRY(parser.expect_one_of({
+            Token::kw_const,
+            Token::kw_let,
+        }));
+        auto name = TRY(parser.expect(Token::lit_ident));
+        TRY(parser.expect(Token::kw_of));
+        auto iterable = TRY(parse_rvalue(parser));
+        TRY(parser.expect(Token::sym_rparen));
+        return Expr(ForOfStmt {
+            .name = name,
+            .iterable = iterable,
+            .body = TRY(parse_expression(parser)),
+        });
+    }
+
+    auto stmt = ForStmt();
+    if (is_declaration) {
+        stmt.init = Expr(TRY(parse_var_decl(parser)));
+    }
+    TRY(parser.expect(Token::sym_semicolon));
+    stmt.cond = TRY(parse_rvalue(parser));
+    TRY(parser.expect(Token::sym_semicolon));
+    stmt.update = TRY(parse_rvalue(parser));
+    TRY(parser.expect(Token::sym_rparen));
+    stmt.body = TRY(parse_expression(parser));
+    return Expr(move(stmt));
+}
+
 ErrorOr<RValue, ParseError> parse_rvalue(Parser& parser)
+{
+    return TRY(parse_binary(parser, 1));
+}
+
+ErrorOr<RValue, ParseError> parse_primary(Parser& parser)
 {
     if (parser.peek() == Token::op_bang) {
         return RValue {
+            .type = Type::boolean,
             .value = Expr(TRY(parse_unary(parser))),
         };
     }
 
-    if (parser.peek() == Token::lit_string) {
+    if (parser.peek() == Token::kw_await) {
+        return RValue {
+            .value = Expr(TRY(parse_unary(parser))),
+        };
+    }
+
+    if (parser.peek() == Token::kw_new) {
+        return RValue {
+            .value = Expr(TRY(parse_new(parser))),
+        };
+    }
+
+    if (parser.peek() == Token::sym_lparen && is_arrow_func(parser)) {
+        return RValue {
+            .value = Expr(TRY(parse_arrow_func(parser))),
+        };
+    }
+
+    if (parser.peek() == Token::sym_lparen) {
+        TRY(parser.expect(Token::sym_lparen));
+        auto value = TRY(parse_rvalue(parser));
+        TRY(parser.expect(Token::sym_rparen));
+        return value;
+    }
+
+    if (parser.peek() == Token::sym_lbracket) {
+        return RValue {
+            .type = Type::array,
+            .value = Expr(TRY(parse_array_literal(parser))),
+        };
+    }
+
+    if (parser.peek() == Token::sym_lcurly) {
+        return RValue {
+            .type = Type::object,
+            .value = Expr(TRY(parse_object_literal(parser))),
+        };
+    }
+
+    if (parser.peek() == Token::lit_string || parser.peek() == Token::lit_template) {
         auto value = parser.next();
         return RValue {
+            .type = Type::string,
             .value = Expr::string(*value)
         };
     }
 
+    if (parser.peek() == Token::lit_template_head) {
+        return RValue {
+            .type = Type::string,
+            .value = Expr(TRY(parse_template_literal(parser))),
+        };
+    }
+
     if (parser.peek() == Token::lit_number) {
         auto value = parser.next();
         return RValue {
+            .type = Type::number,
             .value = Expr::number(*value)
         };
     }
     
     if (parser.peek() == Token::lit_ident) {
-        if (parser.peek(1) == Token::sym_dot) {
+        // Method calls are left for parse_postfix.
+        if (parser.peek(1) == Token::sym_dot && parser.peek(3) != Token::sym_lparen) {
             return RValue {
                 .value = TRY(parse_dot_expr(parser)),
             };
         }
-        if (parser.peek(1) == Token::sym_lparen) {
+        if (parser.peek(1) == Token::sym_lparen || is_type_args(parser, 1)) {
             return RValue {
                 .value = TRY(parse_func_call(parser)),
             };
         }
+        auto value = parser.next();
         return RValue {
-            .value = Expr(TRY(parse_binary(parser))),
+            .value = Expr::lvalue(*value),
         };
     }
 
     return ParseError::expected_one_of(parser, {
         Token::op_bang,
+        Token::kw_await,
+        Token::kw_new,
+        Token::sym_lparen,
+        Token::sym_lcurly,
+        Token::sym_lbracket,
         Token::lit_string,
+        Token::lit_template,
+        Token::lit_template_head,
+        Token::lit_number,
         Token::lit_ident,
     });
 }
 
-ErrorOr<UnaryExpr, ParseError> parse_unary(Parser& parser)
+ErrorOr<RValue, ParseError> parse_postfix(Parser& parser)
 {
-    auto op = TRY(parser.expect(Token::op_bang));
-    auto identifier = TRY(parser.expect(Token::lit_ident));
-    return UnaryExpr {
-        .op = op,
-        .value = RValue {
-            .value = Expr::lvalue(identifier),
+    auto value = TRY(parse_primary(parser));
+    while (parser.peek() == Token::sym_lbracket || (parser.peek() == Token::sym_dot && parser.peek(2) == Token::sym_lparen)) {
+        if (parser.peek() == Token::sym_lbracket) {
+            TRY(parser.expect(Token::sym_lbracket));
+            auto index = TRY(parse_rvalue(parser));
+            TRY(parser.expect(Token::sym_rbracket));
+            value = RValue {
+                .value = Expr(IndexExpr {
+                    .object = value,
+                    .index = index,
+                }),
+            };
+            continue;
         }
-    };
+        TRY(parser.expect(Token::sym_dot));
+        auto name = TRY(parser.expect(Token::lit_ident));
+        auto args = TRY(parse_func_call_args(parser));
+        value = RValue {
+            .value = Expr(MethodCall {
+                .object = value,
+                .name = name,
+                .args = move(args),
+            }),
+        };
+    }
+    // `as const` is the only assertion, and it's kept as a unary so the
+    // value can be made static data.
+    if (parser.peek() == Token::kw_as) {
+        auto op = TRY(parser.expect(Token::kw_as));
+        TRY(parser.expect(Token::kw_const));
+        value = RValue {
+            .type = value.type,
+            .value = Expr(UnaryExpr {
+                .op = op,
+                .value = value,
+            }),
+        };
+    }
+    return value;
 }
 
-ErrorOr<BinaryExpr, ParseError> parse_binary(Parser& parser)
+ErrorOr<ArrayLiteral, ParseError> parse_array_literal(Parser& parser)
 {
-    // FIXME: Don't hardcode this
-    auto lhs = TRY(parser.expect_one_of({
-        Token::lit_ident,
-        Token::lit_number
-    }));
-    auto op = TRY(parser.expect_one_of({
-        Token::op_lt_eq,
-        Token::op_minus,
-        Token::op_plus,
-        Token::op_triple_eq,
-        Token::op_assign,
-    }));
-    auto rhs = TRY(parser.expect_one_of({
-        Token::lit_ident,
-        Token::lit_number
-    }));
+    auto array = ArrayLiteral();
+    TRY(parser.expect(Token::sym_lbracket));
+    while (parser.peek() != Token::sym_rbracket) {
+        TRY(array.items.append(TRY(parse_rvalue(parser))));
+        if (parser.peek() == Token::sym_comma) {
+            TRY(parser.expect(Token::sym_comma));
+        }
+    }
+    TRY(parser.expect(Token::sym_rbracket));
+    return array;
+}
 
-    auto lhs_rvalue = RValue {
-        .value = Expr::lvalue(lhs),
-    };
-    if (lhs == Token::lit_number) {
-        lhs_rvalue = RValue {
-            .type = Type::number,
-            .value = Expr::number(lhs),
-        };
+ErrorOr<TemplateLiteral, ParseError> parse_template_literal(Parser& parser)
+{
+    auto literal = TemplateLiteral();
+    while (parser.peek() == Token::lit_template_head) {
+        TRY(literal.strings.append(*parser.next()));
+        TRY(literal.values.append(TRY(parse_rvalue(parser))));
+    }
+    TRY(literal.strings.append(TRY(parser.expect(Token::lit_template))));
+    return literal;
+}
+
+bool is_arrow_func(Parser const& parser)
+{
+    // (a, b) => ... looks like a parenthesized expression until the '=>'
+    // after the closing ')'.
+    u32 depth = 0;
+    for (usize ahead = 0; parser.peek(ahead).has_value(); ahead++) {
+        auto token = *parser.peek(ahead);
+        if (token == Token::sym_lparen) {
+            depth++;
+        }
+        if (token == Token::sym_rparen && --depth == 0) {
+            return parser.peek(ahead + 1) == Token::sym_fat_arrow;
+        }
     }
+    return false;
+}
 
-    auto rhs_rvalue = RValue {
-        .value = Expr::lvalue(lhs),
+ErrorOr<NewExpr, ParseError> parse_new(Parser& parser)
+{
+    TRY(parser.expect(Token::kw_new));
+    auto name = TRY(parser.expect(Token::lit_ident));
+    return NewExpr {
+        .name = name,
+        .args = TRY(parse_func_call_args(parser)),
     };
-    if (rhs == Token::lit_number) {
-        rhs_rvalue = RValue {
-            .type = Type::number,
-            .value = Expr::number(rhs),
+}
+
+ErrorOr<ArrowFunc, ParseError> parse_arrow_func(Parser& parser)
+{
+    auto func = ArrowFunc();
+    TRY(parser.expect(Token::sym_lparen));
+    while (parser.peek() != Token::sym_rparen) {
+        auto name = TRY(parser.expect(Token::lit_ident));
+        auto type = Type();
+        if (parser.peek() == Token::sym_colon) {
+            TRY(parser.expect(Token::sym_colon));
+            type = TRY(parse_type(parser));
+        }
+        TRY(func.params.append(VarDecl {
+            .name = name,
+            .type = type,
+        }));
+        if (parser.peek() == Token::sym_comma) {
+            TRY(parser.expect(Token::sym_comma));
+        }
+    }
+    TRY(parser.expect(Token::sym_rparen));
+    TRY(parser.expect(Token::sym_fat_arrow));
+    func.body = TRY(parse_rvalue(parser));
+    return func;
+}
+
+ErrorOr<ObjectLiteral, ParseError> parse_object_literal(Parser& parser)
+{
+    auto object = ObjectLiteral();
+    TRY(parser.expect(Token::sym_lcurly));
+    while (parser.peek() != Token::sym_rcurly) {
+        auto name = TRY(parser.expect(Token::lit_ident));
+        auto value = RValue {
+            .value = Expr::lvalue(name),
         };
+        if (parser.peek() == Token::sym_colon) {
+            TRY(parser.expect(Token::sym_colon));
+            value = TRY(parse_rvalue(parser));
+        }
+        TRY(object.fields.append(Field {
+            .name = name,
+            .value = value,
+        }));
+        if (parser.peek() == Token::sym_comma) {
+            TRY(parser.expect(Token::sym_comma));
+        }
     }
+    TRY(parser.expect(Token::sym_rcurly));
+    return object;
+}
 
-    return BinaryExpr {
+ErrorOr<UnaryExpr, ParseError> parse_unary(Parser& parser)
+{
+    auto op = TRY(parser.expect_one_of({
+        Token::op_bang,
+        Token::kw_await,
+    }));
+    auto value = TRY(parse_postfix(parser));
+    return UnaryExpr {
         .op = op,
-        .lhs = lhs_rvalue,
-        .rhs = rhs_rvalue,
+        .value = value,
     };
 }
 
+bool has_doc_tag(Parser const& parser, Token token, StringView tag)
+{
+    // The lexer skips comments, so doc comments are found by looking at
+    // what comes right before the token.
+    auto is_space = [](char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    };
+    auto file = parser.source().file;
+    u32 end = token.position();
+    while (end > 0 && is_space(file[end - 1])) {
+        end--;
+    }
+    if (!file.part(0, end).ends_with("*/"sv)) {
+        return false;
+    }
+    u32 start = end - 2;
+    while (start > 0 && !file.part(0, start).ends_with("/**"sv)) {
+        start--;
+    }
+    auto comment = file.part(start, end - 2);
+    for (u32 i = 0; i + tag.size() <= comment.size(); i++) {
+        if (comment.sub_view(i, tag.size()) != tag) {
+            continue;
+        }
+        auto after = i + tag.size();
+        if (after == comment.size() || is_space(comment[after]) || comment[after] == '*') {
+            return true;
+        }
+    }
+    return false;
+}
+
+static u32 binary_precedence(Token::Kind kind)
+{
+    switch (kind) {
+    case Token::op_assign:
+        return 1;
+    case Token::op_triple_eq:
+        return 2;
+    case Token::op_lt:
+    case Token::op_lt_eq:
+    case Token::kw_in:
+        return 3;
+    case Token::op_minus:
+    case Token::op_plus:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+ErrorOr<RValue, ParseError> parse_binary(Parser& parser, u32 min_precedence)
+{
+    auto lhs = TRY(parse_postfix(parser));
+    while (parser.peek().has_value()) {
+        auto op = parser.peek().value();
+        auto precedence = binary_precedence(op);
+        if (precedence == 0 || precedence < min_precedence) {
+            break;
+        }
+        (void)parser.next();
+
+        // Assignment is right associative, everything else binds left.
+        auto next_precedence = op == Token::op_assign ? precedence : precedence + 1;
+        auto rhs = TRY(parse_binary(parser, next_precedence));
+        lhs = RValue {
+            .value = Expr(BinaryExpr {
+                .op = op,
+                .lhs = lhs,
+                .rhs = rhs,
+            }),
+        };
+    }
+    return lhs;
+}
+
 ErrorOr<DotExpr, ParseError> parse_dot_expr(Parser& parser)
 {
     auto lhs = TRY(parser.expect(Token::lit_ident));
     TRY(parser.expect(Token::sym_dot));
-    auto rhs = TRY(parse_rvalue(parser));
+    auto rhs = TRY(parse_primary(parser));
     return DotExpr {
         .rhs = rhs,
         .lhs = lhs,
@@ -503,12 +1138,24 @@ ErrorOr<ThrowStmt, ParseError> parse_throw(Parser& parser)
 ErrorOr<ReturnStmt, ParseError> parse_return(Parser& parser)
 {
     TRY(parser.expect(Token::kw_return));
+    if (parser.peek() == Token::sym_semicolon || parser.peek() == Token::sym_rcurly) {
+        return ReturnStmt();
+    }
     auto value = TRY(parse_rvalue(parser));
     return ReturnStmt {
         .value = value,
     };
 }
 
+ErrorOr<YieldStmt, ParseError> parse_yield(Parser& parser)
+{
+    TRY(parser.expect(Token::kw_yield));
+    auto value = TRY(parse_rvalue(parser));
+    return YieldStmt {
+        .value = value,
+    };
+}
+
 Expr Expr::lvalue(Token token)
 {
     return Expr(lvalue_expr, token);
@@ -524,6 +1171,11 @@ Expr Expr::number(Token token)
     return Expr(number_literal, token);
 }
 
+Expr Expr::break_(Token token)
+{
+    return Expr(break_stmt, token);
+}
+
 Expr::Expr(Block&& value)
     : kind(block)
 {
@@ -536,6 +1188,18 @@ Expr::Expr(FuncDecl&& value)
     as.func_decl = new FuncDecl(move(value));
 }
 
+Expr::Expr(TypeDecl&& value)
+    : kind(type_decl)
+{
+    as.type_decl = new TypeDecl(move(value));
+}
+
+Expr::Expr(ClassDecl&& value)
+    : kind(class_decl)
+{
+    as.class_decl = new ClassDecl(move(value));
+}
+
 Expr::Expr(FuncCall&& value)
     : kind(func_call)
 {
@@ -554,6 +1218,12 @@ Expr::Expr(IfStmt&& value)
     as.if_stmt = new IfStmt(move(value));
 }
 
+Expr::Expr(SwitchStmt&& value)
+    : kind(switch_stmt)
+{
+    as.switch_stmt = new SwitchStmt(move(value));
+}
+
 Expr::Expr(ThrowStmt&& value)
     : kind(throw_stmt)
 {
@@ -566,6 +1236,12 @@ Expr::Expr(ReturnStmt&& value)
     as.return_stmt = new ReturnStmt(move(value));
 }
 
+Expr::Expr(YieldStmt&& value)
+    : kind(yield_stmt)
+{
+    as.yield_stmt = new YieldStmt(move(value));
+}
+
 Expr::Expr(UnaryExpr&& value)
     : kind(unary_expr)
 {
@@ -590,10 +1266,64 @@ Expr::Expr(DotExpr&& value)
     as.dot_expr = new DotExpr(move(value));
 }
 
+Expr::Expr(ForStmt&& value)
+    : kind(for_stmt)
+{
+    as.for_stmt = new ForStmt(move(value));
+}
+
+Expr::Expr(ForOfStmt&& value)
+    : kind(for_of_stmt)
+{
+    as.for_of_stmt = new ForOfStmt(move(value));
+}
+
+Expr::Expr(IndexExpr&& value)
+    : kind(index_expr)
+{
+    as.index_expr = new IndexExpr(move(value));
+}
+
+Expr::Expr(MethodCall&& value)
+    : kind(method_call)
+{
+    as.method_call = new MethodCall(move(value));
+}
+
+Expr::Expr(ArrowFunc&& value)
+    : kind(arrow_func)
+{
+    as.arrow_func = new ArrowFunc(move(value));
+}
+
+Expr::Expr(NewExpr&& value)
+    : kind(new_expr)
+{
+    as.new_expr = new NewExpr(move(value));
+}
+
+Expr::Expr(ArrayLiteral&& value)
+    : kind(array_literal)
+{
+    as.array_literal = new ArrayLiteral(move(value));
+}
+
+Expr::Expr(TemplateLiteral&& value)
+    : kind(template_literal)
+{
+    as.template_literal = new TemplateLiteral(move(value));
+}
+
+Expr::Expr(ObjectLiteral&& value)
+    : kind(object_literal)
+{
+    as.object_literal = new ObjectLiteral(move(value));
+}
+
 Expr::Expr(Kind kind, Token token)
     : kind(kind)
 {
-    VERIFY(kind == lvalue_expr || kind == string_literal || kind == number_literal);
+    VERIFY(kind == lvalue_expr || kind == string_literal || kind == number_literal || kind == break_stmt);
     if (kind == lvalue_expr) {
         as.lvalue_expr = token;
     }
@@ -603,6 +1333,9 @@ Expr::Expr(Kind kind, Token token)
     if (kind == number_literal) {
         as.number_literal = token;
     }
+    if (kind == break_stmt) {
+        as.break_stmt = token;
+    }
 }
 
 
@@ -613,11 +1346,80 @@ Type Type::from_token(Token token)
         return Type::boolean; 
     case Token::Type::number:
         return Type::number;
+    case Token::Type::string:
+        return Type::string;
     case Token::Type::void_:
         return Type::void_;
     }
 }
 
+Type Type::from_name(Token name)
+{
+    auto type = Type(Type::named);
+    type.m_token = name;
+    return type;
+}
+
+Type Type::from_literal(Token literal)
+{
+    auto type = Type(Type::literal);
+    type.m_token = literal;
+    return type;
+}
+
+Type Type::from_union(UnionType const* union_)
+{
+    auto type = Type(Type::union_);
+    type.m_union = union_;
+    return type;
+}
+
+Type Type::from_array(Type const* element)
+{
+    auto type = Type(Type::array);
+    type.m_element = element;
+    return type;
+}
+
+Type Type::from_promise(Type const* element)
+{
+    auto type = Type(Type::promise);
+    type.m_element = element;
+    return type;
+}
+
+Type Type::from_generator(Type const* element)
+{
+    auto type = Type(Type::generator);
+    type.m_element = element;
+    return type;
+}
+
+Type Type::from_readonly_array(Type const* element)
+{
+    auto type = from_array(element);
+    type.m_is_readonly = true;
+    return type;
+}
+
+bool Type::is_same(Type other) const
+{
+    if (kind() != other.kind()) {
+        return false;
+    }
+    if (kind() == Type::array || kind() == Type::promise || kind() == Type::generator) {
+        return element_type().is_same(other.element_type());
+    }
+    return true;
+}
+
+Type Type::from_object(ObjectType const* object)
+{
+    auto type = Type(Type::object);
+    type.m_object = object;
+    return type;
+}
+
 ErrorOr<StringBuffer> Type::to_string() const
 {
     switch (kind()) {
@@ -625,8 +1427,28 @@ ErrorOr<StringBuffer> Type::to_string() const
         return StringBuffer::create_fill("boolean"sv);
     case Type::number:
         return StringBuffer::create_fill("number"sv);
+    case Type::string:
+        return StringBuffer::create_fill("string"sv);
+    case Type::object:
+        return StringBuffer::create_fill("object"sv);
     case Type::void_:
         return StringBuffer::create_fill("void"sv);
+    case Type::named:
+        return StringBuffer::create_fill("named"sv);
+    case Type::literal:
+        return StringBuffer::create_fill("literal"sv);
+    case Type::union_:
+        return StringBuffer::create_fill("union"sv);
+    case Type::array:
+        return StringBuffer::create_fill(TRY(element_type().to_string()).view(), "[]"sv);
+    case Type::promise:
+        return StringBuffer::create_fill("Promise<"sv, TRY(element_type().to_string()).view(), ">"sv);
+    case Type::generator:
+        return StringBuffer::create_fill("Generator<"sv, TRY(element_type().to_string()).view(), ">"sv);
+    case Type::instance:
+        return StringBuffer::create_fill("instance"sv);
+    case Type::index:
+        return StringBuffer::create_fill("index"sv);
     case Type::none:
         return StringBuffer::create_fill("none"sv);
     }
@@ -49,13 +49,28 @@ struct FuncDecl;
 struct FuncCall;
 
 struct IfStmt;
+struct SwitchStmt;
+struct ForStmt;
+struct ForOfStmt;
 struct ThrowStmt;
+struct YieldStmt;
 struct ReturnStmt;
 
 struct UnaryExpr;
 struct BinaryExpr;
 struct RValue;
 struct DotExpr;
+struct ObjectLiteral;
+struct ArrayLiteral;
+struct TemplateLiteral;
+struct ArrowFunc;
+struct MethodCall;
+struct IndexExpr;
+struct ObjectType;
+struct UnionType;
+struct TypeDecl;
+struct ClassDecl;
+struct NewExpr;
 
 struct Expr {
     enum Kind {
@@ -66,20 +81,34 @@ struct Expr {
         var_decl,
         func_decl,
         func_call,
+        type_decl,
+        class_decl,
 
         if_stmt,
+        switch_stmt,
+        for_stmt,
+        for_of_stmt,
+        break_stmt,
         throw_stmt,
         return_stmt,
+        yield_stmt,
 
         unary_expr,
         binary_expr,
         dot_expr,
+        method_call,
+        index_expr,
+        arrow_func,
+        new_expr,
 
         lvalue_expr,
         rvalue_expr,
 
         string_literal,
         number_literal,
+        object_literal,
+        array_literal,
+        template_literal,
     };
 
     explicit Expr() = default;
@@ -87,18 +116,32 @@ struct Expr {
     static Expr lvalue(Token);
     static Expr string(Token);
     static Expr number(Token);
+    static Expr break_(Token);
 
     Expr(Block&& value);
     Expr(FuncDecl&& value);
     Expr(FuncCall&& value);
+    Expr(TypeDecl&& value);
+    Expr(ClassDecl&& value);
     Expr(VarDecl&& value);
     Expr(IfStmt&& value);
+    Expr(SwitchStmt&& value);
+    Expr(ForStmt&& value);
+    Expr(ForOfStmt&& value);
     Expr(ThrowStmt&& value);
     Expr(ReturnStmt&& value);
+    Expr(YieldStmt&& value);
     Expr(UnaryExpr&& value);
     Expr(BinaryExpr&& value);
     Expr(RValue&& value);
     Expr(DotExpr&& value);
+    Expr(MethodCall&& value);
+    Expr(IndexExpr&& value);
+    Expr(ArrowFunc&& value);
+    Expr(NewExpr&& value);
+    Expr(ObjectLiteral&& value);
+    Expr(ArrayLiteral&& value);
+    Expr(TemplateLiteral&& value);
 
     constexpr operator Kind() const { return kind; }
 
@@ -106,17 +149,31 @@ struct Expr {
         Block* block;
         FuncDecl* func_decl;
         FuncCall* func_call;
+        TypeDecl* type_decl;
+        ClassDecl* class_decl;
         VarDecl* var_decl;
         IfStmt* if_stmt;
+        SwitchStmt* switch_stmt;
+        ForStmt* for_stmt;
+        ForOfStmt* for_of_stmt;
         ThrowStmt* throw_stmt;
         ReturnStmt* return_stmt;
+        YieldStmt* yield_stmt;
         UnaryExpr* unary_expr;
         BinaryExpr* binary_expr;
         RValue* rvalue_expr;
         DotExpr* dot_expr;
+        MethodCall* method_call;
+        IndexExpr* index_expr;
+        ArrowFunc* arrow_func;
+        NewExpr* new_expr;
+        ObjectLiteral* object_literal;
+        ArrayLiteral* array_literal;
+        TemplateLiteral* template_literal;
         Token lvalue_expr;
         Token string_literal;
         Token number_literal;
+        Token break_stmt;
     } as { nullptr };
     Kind kind { none };
 
@@ -130,10 +187,33 @@ struct Type {
 
         boolean,
         number,
+        string,
+        object,
         void_,
+        named,
+        literal,
+        union_,
+        array,
+        promise,
+        generator,
+        // Objects of a class, which are only ever referred to. The shape
+        // of such a value tells its class.
+        instance,
+
+        // Counters the compiler makes for loops, never written in source.
+        index,
     };
 
     static Type from_token(Token token);
+    static Type from_name(Token name);
+    static Type from_object(ObjectType const* object);
+    static Type from_literal(Token literal);
+    static Type from_union(UnionType const* union_);
+    static Type from_array(Type const* element);
+    static Type from_promise(Type const* element);
+    static Type from_generator(Type const* element);
+    // `readonly T[]` and `ReadonlyArray<T>`.
+    static Type from_readonly_array(Type const* element);
 
     Type() = default;
 
@@ -145,10 +225,27 @@ struct Type {
     Kind kind() const { return m_kind; }
     operator Kind() const { return kind(); }
 
+    Token name() const { return m_token; }
+    Token literal_token() const { return m_token; }
+    ObjectType const* object_type() const { return m_object; }
+    UnionType const* union_type() const { return m_union; }
+    // What an array holds, a promise settles with or a generator yields.
+    Type const& element_type() const { return *m_element; }
+    bool is_readonly() const { return m_is_readonly; }
+
+    // Kinds alone don't tell arrays, promises or generators of different
+    // things apart.
+    bool is_same(Type other) const;
+
     ErrorOr<StringBuffer> to_string() const;
 
 private:
+    Token m_token {};
+    ObjectType const* m_object { nullptr };
+    UnionType const* m_union { nullptr };
+    Type const* m_element { nullptr };
     Kind m_kind { none };
+    bool m_is_readonly { false };
 };
 
 struct RValue {
@@ -160,6 +257,7 @@ struct VarDecl {
     Token name {};
     Type type {};
     Optional<RValue> default_value {};
+    bool is_mutable { false };
 };
 
 struct Block {
@@ -168,13 +266,18 @@ struct Block {
 
 struct FuncDecl {
     Token name {};
+    Vector<Token> type_params {};
     Vector<VarDecl> args {};
     Type return_type {};
     Block block {};
+    bool is_exported { false };
+    bool is_async { false };
+    bool is_generator { false };
 };
 
 struct FuncCall {
     Token name;
+    Vector<Type> type_args;
     Vector<VarDecl> args;
     Type return_type;
 };
@@ -185,6 +288,31 @@ struct IfStmt {
     Expr else_ {};
 };
 
+// `value` is missing for the default case.
+struct SwitchCase {
+    Optional<RValue> value {};
+    Vector<Expr> body {};
+};
+
+struct SwitchStmt {
+    RValue value {};
+    Vector<SwitchCase> cases {};
+};
+
+// `for (init; cond; update) body`, init being a declaration or nothing.
+struct ForStmt {
+    Expr init {};
+    RValue cond {};
+    RValue update {};
+    Expr body {};
+};
+
+struct ForOfStmt {
+    Token name {};
+    RValue iterable {};
+    Expr body {};
+};
+
 struct UnaryExpr {
     Token op {};
     RValue value {};
@@ -201,14 +329,95 @@ struct DotExpr {
     Token lhs {};
 };
 
+struct Field {
+    Token name {};
+    RValue value {};
+};
+
+struct ObjectLiteral {
+    Vector<Field> fields {};
+};
+
+struct ArrayLiteral {
+    Vector<RValue> items {};
+};
+
+// `a${b}c` with at least one substitution. Every value is preceded by
+// the text before it, and the last text comes after the last value.
+struct TemplateLiteral {
+    Vector<Token> strings {};
+    Vector<RValue> values {};
+};
+
+// `(x) => x + 1`, only with an expression for a body.
+struct ArrowFunc {
+    Vector<VarDecl> params {};
+    RValue body {};
+};
+
+// `value.name(args)`, value being anything from a variable to the result
+// of another call.
+struct MethodCall {
+    RValue object {};
+    Token name {};
+    Vector<VarDecl> args {};
+};
+
+struct IndexExpr {
+    RValue object {};
+    RValue index {};
+};
+
+struct FieldType {
+    Token name {};
+    Type type {};
+    bool is_optional { false };
+};
+
+struct ObjectType {
+    Vector<FieldType> fields {};
+};
+
+struct UnionType {
+    Vector<Type> members {};
+};
+
+// Both `interface Name { ... }` and `type Name = ...`. Interfaces with
+// an `@soa` doc comment have arrays of them stored one field at a time.
+struct TypeDecl {
+    Token name {};
+    Type type {};
+    bool is_columnar { false };
+};
+
+// `class Name extends Base { ... }`. Fields have a type, an initializer or
+// both, and a class without a constructor gets the one of its base.
+struct ClassDecl {
+    Token name {};
+    Optional<Token> base {};
+    Vector<VarDecl> fields {};
+    Optional<FuncDecl> constructor {};
+    Vector<FuncDecl> methods {};
+};
+
+struct NewExpr {
+    Token name {};
+    Vector<VarDecl> args {};
+};
+
 struct ThrowStmt {
     RValue value {};
 };
 
+// `value` is none for a bare `return`.
 struct ReturnStmt {
     RValue value {};
 };
 
+struct YieldStmt {
+    RValue value {};
+};
+
 struct ParseTree {
     Vector<Expr> expressions {};
 };
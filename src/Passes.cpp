@@ -0,0 +1,44 @@
+#include "./Passes.h"
+
+static constexpr u32 max_rounds = 16;
+
+static constexpr Pass default_passes[] = {
+    { "evaluate-initializers"sv, evaluate_initializers },
+    { "fold-constants"sv, fold_constants },
+    { "remove-unreachable-blocks"sv, remove_unreachable_blocks },
+    { "remove-trivial-phis"sv, remove_trivial_phis },
+    { "merge-blocks"sv, merge_blocks },
+    { "form-string-switches"sv, form_string_switches },
+    { "remove-dead-values"sv, remove_dead_values },
+    { "hoist-loop-invariants"sv, hoist_loop_invariants },
+    { "form-counted-loops"sv, form_counted_loops },
+    { "remove-bounds-checks"sv, remove_bounds_checks },
+    { "eliminate-tail-recursion"sv, eliminate_tail_recursion },
+    { "devirtualize-calls"sv, devirtualize_calls },
+    { "inline-functions"sv, inline_functions },
+    { "scalar-replace-objects"sv, scalar_replace_objects },
+    { "free-dead-objects"sv, free_dead_objects },
+    { "fold-identical-functions"sv, fold_identical_functions },
+    { "remove-unused-functions"sv, remove_unused_functions },
+    { "analyze-may-throw"sv, analyze_may_throw },
+};
+
+ErrorOr<void> run_passes(IR::Module& module, View<Pass const> passes)
+{
+    for (u32 round = 0; round < max_rounds; round++) {
+        bool changed = false;
+        for (auto const& pass : passes) {
+            changed |= TRY(pass.run(module));
+        }
+        if (!changed) {
+            break;
+        }
+    }
+    return {};
+}
+
+ErrorOr<void> optimize(IR::Module& module)
+{
+    TRY(run_passes(module, View<Pass const>(default_passes, sizeof(default_passes) / sizeof(default_passes[0]))));
+    return {};
+}
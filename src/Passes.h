@@ -0,0 +1,35 @@
+#pragma once
+#include "./IR.h"
+
+#include <Ty/ErrorOr.h>
+#include <Ty/View.h>
+
+// A pass returns whether it changed the module. Passes are run in rounds
+// until a whole round leaves the module untouched.
+struct Pass {
+    StringView name;
+    ErrorOr<bool> (*run)(IR::Module&);
+};
+
+ErrorOr<void> run_passes(IR::Module&, View<Pass const>);
+ErrorOr<void> optimize(IR::Module&);
+ErrorOr<void> split_cold_fields(IR::Module&, StringView profile);
+
+ErrorOr<bool> evaluate_initializers(IR::Module&);
+ErrorOr<bool> fold_constants(IR::Module&);
+ErrorOr<bool> remove_unreachable_blocks(IR::Module&);
+ErrorOr<bool> remove_trivial_phis(IR::Module&);
+ErrorOr<bool> remove_dead_values(IR::Module&);
+ErrorOr<bool> merge_blocks(IR::Module&);
+ErrorOr<bool> form_string_switches(IR::Module&);
+ErrorOr<bool> hoist_loop_invariants(IR::Module&);
+ErrorOr<bool> form_counted_loops(IR::Module&);
+ErrorOr<bool> remove_bounds_checks(IR::Module&);
+ErrorOr<bool> eliminate_tail_recursion(IR::Module&);
+ErrorOr<bool> devirtualize_calls(IR::Module&);
+ErrorOr<bool> inline_functions(IR::Module&);
+ErrorOr<bool> scalar_replace_objects(IR::Module&);
+ErrorOr<bool> free_dead_objects(IR::Module&);
+ErrorOr<bool> fold_identical_functions(IR::Module&);
+ErrorOr<bool> remove_unused_functions(IR::Module&);
+ErrorOr<bool> analyze_may_throw(IR::Module&);
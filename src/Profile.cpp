@@ -0,0 +1,91 @@
+#include "./Passes.h"
+
+// A field is cold when the busiest field of its class is used this many
+// times as often.
+static constexpr u64 cold_ratio = 32;
+
+static ErrorOr<Vector<Vector<u64>>> parse_profile(IR::Module const&, StringView profile);
+
+ErrorOr<void> split_cold_fields(IR::Module& module, StringView profile)
+{
+    // Profiles have a line per field, like `Particle.x 1200`, as printed
+    // by programs compiled with --count-field-uses. Classes the profile
+    // doesn't mention are left alone.
+    auto counts = TRY(parse_profile(module, profile));
+    for (u32 i = 0; i < module.classes.size(); i++) {
+        auto& class_ = module.classes[i];
+        if (counts[i].is_empty()) {
+            continue;
+        }
+        u64 busiest = 0;
+        for (auto count : counts[i].view()) {
+            busiest = count > busiest ? count : busiest;
+        }
+        auto first = class_.base.is_valid() ? module[module[class_.base].shape].fields.size() : 0;
+        for (u32 j = 0; j < counts[i].size(); j++) {
+            TRY(class_.is_cold.append(j >= first && counts[i][j] * cold_ratio < busiest));
+        }
+    }
+    return {};
+}
+
+static ErrorOr<Vector<Vector<u64>>> parse_profile(IR::Module const& module, StringView profile)
+{
+    // Counts by class and field. Lines about classes or fields the program
+    // no longer has are skipped, so an old profile still works.
+    auto counts = TRY(Vector<Vector<u64>>::create(module.classes.size()));
+    for (u32 i = 0; i < module.classes.size(); i++) {
+        TRY(counts.append(Vector<u64>()));
+    }
+    for (u32 start = 0; start < profile.size();) {
+        u32 end = start;
+        while (end < profile.size() && profile[end] != '\n') {
+            end++;
+        }
+        auto line = profile.part(start, end);
+        start = end + 1;
+        if (line.is_empty()) {
+            continue;
+        }
+
+        u32 dot = 0;
+        while (dot < line.size() && line[dot] != '.') {
+            dot++;
+        }
+        u32 space = dot;
+        while (space < line.size() && line[space] != ' ') {
+            space++;
+        }
+        if (dot == 0 || dot >= space || space + 1 >= line.size()) {
+            return Error::from_string_literal("malformed line in field profile");
+        }
+        u64 count = 0;
+        for (u32 i = space + 1; i < line.size(); i++) {
+            if (line[i] < '0' || line[i] > '9') {
+                return Error::from_string_literal("malformed count in field profile");
+            }
+            count = count * 10 + (line[i] - '0');
+        }
+
+        auto name = line.part(0, dot);
+        auto field = line.part(dot + 1, space);
+        for (u32 i = 0; i < module.classes.size(); i++) {
+            auto const& class_ = module.classes[i];
+            if (class_.name != name) {
+                continue;
+            }
+            auto const& shape = module[class_.shape];
+            auto index = shape.find(field);
+            if (!index.has_value()) {
+                break;
+            }
+            if (counts[i].is_empty()) {
+                for (u32 j = 0; j < shape.fields.size(); j++) {
+                    TRY(counts[i].append(0));
+                }
+            }
+            counts[i][index.value()] += count;
+        }
+    }
+    return counts;
+}
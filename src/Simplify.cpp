@@ -0,0 +1,320 @@
+#include "./Passes.h"
+
+static ErrorOr<bool> remove_unreachable_blocks(IR::Function&);
+static ErrorOr<bool> remove_trivial_phis(IR::Function&);
+static ErrorOr<bool> remove_dead_values(IR::Function&);
+static ErrorOr<bool> merge_blocks(IR::Function&);
+static void remove_block(IR::Function&, IR::BlockId);
+
+ErrorOr<bool> remove_unreachable_blocks(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(remove_unreachable_blocks(function));
+    }
+    return changed;
+}
+
+ErrorOr<bool> remove_trivial_phis(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(remove_trivial_phis(function));
+    }
+    return changed;
+}
+
+ErrorOr<bool> remove_dead_values(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(remove_dead_values(function));
+    }
+    return changed;
+}
+
+ErrorOr<bool> merge_blocks(IR::Module& module)
+{
+    bool changed = false;
+    for (auto& function : module.functions) {
+        changed |= TRY(merge_blocks(function));
+    }
+    return changed;
+}
+
+ErrorOr<bool> remove_unused_functions(IR::Module& module)
+{
+    // Only functions reachable from the top level or from an exported
+    // entry point end up in the output.
+    auto is_used = TRY(Vector<bool>::create(module.functions.size()));
+    auto worklist = Vector<IR::FunctionId>();
+    for (u32 i = 0; i < module.functions.size(); i++) {
+        auto id = IR::FunctionId(i);
+        bool is_root = id == module.main || module[id].is_exported;
+        TRY(is_used.append(is_root));
+        if (is_root) {
+            TRY(worklist.append(id));
+        }
+    }
+    while (!worklist.is_empty()) {
+        auto const& function = module[*worklist.pop()];
+        for (auto const& block : function.blocks) {
+            for (auto value : block.insts.view()) {
+                auto const& inst = function[value];
+                if (inst.kind == IR::Inst::call && !is_used[inst.as.callee.raw()]) {
+                    is_used[inst.as.callee.raw()] = true;
+                    TRY(worklist.append(inst.as.callee));
+                }
+                if (inst.kind != IR::Inst::call_virtual) {
+                    continue;
+                }
+                // Any override the receiver could dispatch to.
+                auto class_ = module.find_class(function[function.operands_of(value)[0]].shape).value();
+                for (auto callee : TRY(module.implementations(class_, inst.as.index))) {
+                    if (!is_used[callee.raw()]) {
+                        is_used[callee.raw()] = true;
+                        TRY(worklist.append(callee));
+                    }
+                }
+            }
+        }
+    }
+
+    bool changed = false;
+    for (auto used : is_used.view()) {
+        changed |= !used;
+    }
+    if (!changed) {
+        return false;
+    }
+
+    auto remap = TRY(Vector<IR::FunctionId>::create(module.functions.size()));
+    auto functions = Vector<IR::Function>();
+    for (u32 i = 0; i < module.functions.size(); i++) {
+        if (!is_used[i]) {
+            TRY(remap.append(IR::FunctionId()));
+            continue;
+        }
+        TRY(remap.append(TRY(functions.append(move(module.functions[i])))));
+    }
+    module.functions = move(functions);
+    module.main = remap[module.main.raw()];
+    for (auto& class_ : module.classes) {
+        class_.constructor = class_.constructor.is_valid() ? remap[class_.constructor.raw()] : class_.constructor;
+        for (auto& implementation : class_.implementations) {
+            implementation = implementation.is_valid() ? remap[implementation.raw()] : implementation;
+        }
+    }
+
+    for (auto& function : module.functions) {
+        for (auto& inst : function.insts) {
+            if (inst.kind == IR::Inst::call) {
+                inst.as.callee = remap[inst.as.callee.raw()];
+            }
+        }
+    }
+    return true;
+}
+
+static ErrorOr<bool> remove_unreachable_blocks(IR::Function& function)
+{
+    auto reachable = TRY(Vector<bool>::create(function.blocks.size()));
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        TRY(reachable.append(false));
+    }
+
+    auto worklist = Vector<IR::BlockId>();
+    TRY(worklist.append(IR::Function::entry));
+    reachable[IR::Function::entry.raw()] = true;
+    while (!worklist.is_empty()) {
+        auto block = *worklist.pop();
+        for (auto successor : TRY(function.successors(block))) {
+            if (!reachable[successor.raw()]) {
+                reachable[successor.raw()] = true;
+                TRY(worklist.append(successor));
+            }
+        }
+    }
+
+    bool changed = false;
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        auto block = IR::BlockId(i);
+        if (reachable[i] || function[block].is_removed()) {
+            continue;
+        }
+        for (auto successor : TRY(function.successors(block))) {
+            if (!reachable[successor.raw()]) {
+                continue;
+            }
+            auto const& preds = function[successor].preds;
+            for (u32 k = preds.size(); k > 0; k--) {
+                if (preds[k - 1] == block) {
+                    TRY(function.remove_predecessor(successor, k - 1));
+                }
+            }
+        }
+        remove_block(function, block);
+        changed = true;
+    }
+    return changed;
+}
+
+static ErrorOr<bool> remove_trivial_phis(IR::Function& function)
+{
+    // A phi is trivial when every operand is either the phi itself or one
+    // single other value, in which case that value can be used directly.
+    bool changed = false;
+    for (auto& block : function.blocks) {
+        bool block_changed = false;
+        for (auto phi : block.phis.view()) {
+            auto same = IR::Value();
+            bool is_trivial = true;
+            for (auto operand : function.operands_of(phi)) {
+                if (operand == phi || operand == same) {
+                    continue;
+                }
+                if (same.is_valid()) {
+                    is_trivial = false;
+                    break;
+                }
+                same = operand;
+            }
+            if (!is_trivial) {
+                continue;
+            }
+            if (!same.is_valid()) {
+                same = TRY(function.create_value(IR::Inst {
+                    .kind = IR::Inst::undef,
+                    .type = function[phi].type,
+                }));
+            }
+            function.replace_all_uses(phi, same);
+            function[phi] = IR::Inst {};
+            block_changed = true;
+        }
+        if (!block_changed) {
+            continue;
+        }
+        auto phis = Vector<IR::Value>();
+        for (auto phi : block.phis.view()) {
+            if (function[phi].kind != IR::Inst::nop) {
+                TRY(phis.append(phi));
+            }
+        }
+        block.phis = move(phis);
+        changed = true;
+    }
+    return changed;
+}
+
+static ErrorOr<bool> remove_dead_values(IR::Function& function)
+{
+    bool changed = false;
+    for (bool removed = true; removed;) {
+        removed = false;
+        auto uses = TRY(function.count_uses());
+        for (auto const& block : function.blocks) {
+            for (auto phi : block.phis.view()) {
+                if (function[phi].kind == IR::Inst::nop) {
+                    continue;
+                }
+                if (uses[phi.raw()] == 0) {
+                    function[phi] = IR::Inst {};
+                    removed = true;
+                }
+            }
+            for (auto value : block.insts.view()) {
+                auto const& inst = function[value];
+                if (inst.kind == IR::Inst::nop || inst.kind == IR::Inst::param) {
+                    continue;
+                }
+                if (uses[value.raw()] == 0 && !inst.has_side_effects()) {
+                    function[value] = IR::Inst {};
+                    removed = true;
+                }
+            }
+        }
+        changed |= removed;
+    }
+    if (!changed) {
+        return false;
+    }
+
+    for (auto& block : function.blocks) {
+        auto phis = Vector<IR::Value>();
+        for (auto phi : block.phis.view()) {
+            if (function[phi].kind != IR::Inst::nop) {
+                TRY(phis.append(phi));
+            }
+        }
+        block.phis = move(phis);
+
+        auto insts = Vector<IR::Value>();
+        for (auto value : block.insts.view()) {
+            if (function[value].kind != IR::Inst::nop) {
+                TRY(insts.append(value));
+            }
+        }
+        block.insts = move(insts);
+    }
+    return true;
+}
+
+static ErrorOr<bool> merge_blocks(IR::Function& function)
+{
+    // A block that unconditionally jumps to a block only it can reach
+    // might as well be the same block.
+    bool changed = false;
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        auto block = IR::BlockId(i);
+        while (!function[block].is_removed()) {
+            auto const& terminator = function[function[block].terminator()];
+            if (terminator.kind != IR::Inst::jump) {
+                break;
+            }
+            auto target = terminator.as.target;
+            auto const& successor = function[target];
+            if (target == block || target == IR::Function::entry) {
+                break;
+            }
+            if (successor.preds.size() != 1 || !successor.phis.is_empty()) {
+                break;
+            }
+
+            function[function[block].terminator()] = IR::Inst {};
+            TRY(function[block].insts.pop().or_throw([] {
+                return Error::unreachable();
+            }));
+            for (auto value : function[target].insts.view()) {
+                TRY(function[block].insts.append(value));
+            }
+
+            for (auto successor : TRY(function.successors(target))) {
+                for (auto& pred : function[successor].preds) {
+                    if (pred == target) {
+                        pred = block;
+                    }
+                }
+            }
+
+            function[target].insts.clear();
+            function[target].preds.clear();
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static void remove_block(IR::Function& function, IR::BlockId block)
+{
+    auto& target = function[block];
+    for (auto phi : target.phis.view()) {
+        function[phi] = IR::Inst {};
+    }
+    for (auto value : target.insts.view()) {
+        function[value] = IR::Inst {};
+    }
+    target.phis.clear();
+    target.insts.clear();
+    target.preds.clear();
+}
@@ -0,0 +1,122 @@
+#include "./Passes.h"
+
+using IR::BlockId;
+using IR::FunctionId;
+using IR::Inst;
+using IR::Value;
+
+static ErrorOr<bool> eliminate_tail_recursion(IR::Function&, FunctionId);
+static bool is_tail_call(IR::Function const&, BlockId, FunctionId callee);
+
+ErrorOr<bool> eliminate_tail_recursion(IR::Module& module)
+{
+    bool changed = false;
+    for (u32 i = 0; i < module.functions.size(); i++) {
+        changed |= TRY(eliminate_tail_recursion(module.functions[i], FunctionId(i)));
+    }
+    return changed;
+}
+
+static ErrorOr<bool> eliminate_tail_recursion(IR::Function& function, FunctionId id)
+{
+    // A function returning what calling itself returns starts over with
+    // new arguments instead: its body moves into a loop whose phis take
+    // the place of the parameters, and every such call jumps back to it.
+    // Calling an async function starts a new one with its own promise.
+    if (function.is_async) {
+        return false;
+    }
+    auto calls = Vector<BlockId>();
+    for (u32 i = 0; i < function.blocks.size(); i++) {
+        if (is_tail_call(function, BlockId(i), id)) {
+            TRY(calls.append(BlockId(i)));
+        }
+    }
+    if (calls.is_empty()) {
+        return false;
+    }
+
+    auto loop = TRY(function.create_block());
+    auto entry = IR::Function::entry;
+    auto params = Vector<Value>();
+    auto body = Vector<Value>();
+    for (auto value : function[entry].insts.view()) {
+        if (function[value].kind == Inst::param) {
+            TRY(params.append(value));
+        } else {
+            TRY(body.append(value));
+        }
+    }
+
+    auto phis = Vector<Value>();
+    for (auto param : function.params.view()) {
+        auto phi = TRY(function.create_value(Inst {
+            .kind = Inst::phi,
+            .type = function[param].type,
+            .shape = function[param].shape,
+        }));
+        function.replace_all_uses(param, phi);
+        TRY(phis.append(phi));
+    }
+    for (u32 i = 0; i < function.params.size(); i++) {
+        auto incoming = Vector<Value>();
+        TRY(incoming.append(function.params[i]));
+        for (auto block : calls.view()) {
+            auto const& insts = function[block].insts;
+            TRY(incoming.append(function.operands_of(insts[insts.size() - 2])[i]));
+        }
+        function[phis[i]].operands = TRY(function.create_operands(incoming.view()));
+    }
+
+    function[loop].insts = move(body);
+    function[entry].insts = move(params);
+    for (auto successor : TRY(function.successors(loop))) {
+        for (auto& pred : function[successor].preds) {
+            if (pred == entry) {
+                pred = loop;
+            }
+        }
+    }
+    TRY(function.append(entry, Inst {
+        .kind = Inst::jump,
+        .type = Type::void_,
+        .as = { .target = loop },
+    }));
+    TRY(function[loop].preds.append(entry));
+
+    for (auto block : calls.view()) {
+        if (block == entry) {
+            block = loop;
+        }
+        auto& insts = function[block].insts;
+        TRY(insts.pop().or_throw([] {
+            return Error::from_string_literal("tail call has no return");
+        }));
+        TRY(insts.pop().or_throw([] {
+            return Error::from_string_literal("tail call has no call");
+        }));
+        TRY(function.append(block, Inst {
+            .kind = Inst::jump,
+            .type = Type::void_,
+            .as = { .target = loop },
+        }));
+        TRY(function[loop].preds.append(block));
+    }
+    function[loop].phis = move(phis);
+    return true;
+}
+
+static bool is_tail_call(IR::Function const& function, BlockId block, FunctionId callee)
+{
+    auto const& insts = function[block].insts;
+    if (insts.size() < 2) {
+        return false;
+    }
+    auto ret = insts[insts.size() - 1];
+    auto call = insts[insts.size() - 2];
+    if (function[ret].kind != Inst::ret || function[call].kind != Inst::call || function[call].as.callee != callee) {
+        return false;
+    }
+    auto returned = function.operands_of(ret);
+    return returned.size() == 0 || returned[0] == call;
+}
@@ -3,11 +3,7 @@
 
 bool Token::is_literal() const
 {
-    if (m_kind >= lit__start)
-        return true;
-    if (m_kind <= lit__end)
-        return true;
-    return false;
+    return m_kind >= lit__start && m_kind <= lit__end;
 }
 
 Token::Literal Token::as_literal() const
@@ -18,11 +14,7 @@ Token::Literal Token::as_literal() const
 
 bool Token::is_type() const
 {
-    if (m_kind >= type__start)
-        return true;
-    if (m_kind <= type__end)
-        return true;
-    return false;
+    return m_kind >= type__start && m_kind <= type__end;
 }
 
 Token::Type Token::as_type() const
@@ -41,14 +33,36 @@ StringView Token::kind_name() const
     case kw_throw:      return "kw_throw";
     case kw_return:     return "kw_return";
     case kw_const:      return "kw_const";
+    case kw_export:     return "kw_export";
+    case kw_interface:  return "kw_interface";
+    case kw_type:       return "kw_type";
+    case kw_in:         return "kw_in";
+    case kw_switch:     return "kw_switch";
+    case kw_case:       return "kw_case";
+    case kw_default:    return "kw_default";
+    case kw_break:      return "kw_break";
+    case kw_for:        return "kw_for";
+    case kw_of:         return "kw_of";
+    case kw_let:        return "kw_let";
+    case kw_async:      return "kw_async";
+    case kw_await:      return "kw_await";
+    case kw_yield:      return "kw_yield";
+    case kw_as:         return "kw_as";
+    case kw_readonly:   return "kw_readonly";
+    case kw_class:      return "kw_class";
+    case kw_extends:    return "kw_extends";
+    case kw_new:        return "kw_new";
 
     case type_boolean:  return "type_boolean";
     case type_number:   return "type_number";
+    case type_string:   return "type_string";
     case type_void:     return "type_void";
 
     case lit_ident:     return "lit_ident";
     case lit_string:    return "lit_string";
     case lit_number:    return "lit_number";
+    case lit_template:  return "lit_template";
+    case lit_template_head: return "lit_template_head";
 
     case sym_lparen:    return "sym_lparen";
     case sym_rparen:    return "sym_rparen";
@@ -56,13 +70,21 @@ StringView Token::kind_name() const
     case sym_lcurly:    return "sym_lcurly";
     case sym_rcurly:    return "sym_rcurly";
 
+    case sym_lbracket:  return "sym_lbracket";
+    case sym_rbracket:  return "sym_rbracket";
+
     case sym_fat_arrow: return "sym_fat_arrow";
     case sym_colon:     return "sym_colon";
     case sym_semicolon: return "sym_semicolon";
     case sym_dot:       return "sym_dot";
     case sym_comma:     return "sym_comma";
+    case sym_question:  return "sym_question";
+    case sym_pipe:      return "sym_pipe";
+    case sym_star:      return "sym_star";
 
     case op_lt_eq:      return "op_lt_eq";
+    case op_lt:         return "op_lt";
+    case op_gt:         return "op_gt";
     case op_minus:      return "op_minus";
     case op_plus:       return "op_plus";
     case op_assign:     return "op_assign";
@@ -82,14 +104,38 @@ StringView Token::view_in(StringView file) const
     case kw_throw:      size = "throw"sv.size();    break;
     case kw_return:     size = "return"sv.size();   break;
     case kw_const:      size = "const"sv.size();    break;
+    case kw_export:     size = "export"sv.size();   break;
+    case kw_interface:  size = "interface"sv.size(); break;
+    case kw_type:       size = "type"sv.size();     break;
+    case kw_in:         size = "in"sv.size();       break;
+    case kw_switch:     size = "switch"sv.size();   break;
+    case kw_case:       size = "case"sv.size();     break;
+    case kw_default:    size = "default"sv.size();  break;
+    case kw_break:      size = "break"sv.size();    break;
+    case kw_for:        size = "for"sv.size();      break;
+    case kw_of:         size = "of"sv.size();       break;
+    case kw_let:        size = "let"sv.size();      break;
+    case kw_async:      size = "async"sv.size();    break;
+    case kw_await:      size = "await"sv.size();    break;
+    case kw_yield:      size = "yield"sv.size();    break;
+    case kw_as:         size = "as"sv.size();       break;
+    case kw_readonly:   size = "readonly"sv.size(); break;
+    case kw_class:      size = "class"sv.size();    break;
+    case kw_extends:    size = "extends"sv.size();  break;
+    case kw_new:        size = "new"sv.size();      break;
 
     case type_boolean:  size = "boolean"sv.size();  break;
     case type_number:   size = "number"sv.size();   break;
+    case type_string:   size = "string"sv.size();   break;
     case type_void:     size = "void"sv.size();     break;
 
     case lit_ident:     size = relex_ident_size(file,   position()); break;
     case lit_string:    size = relex_string_size(file,  position()); break;
     case lit_number:    size = relex_number_size(file,  position()); break;
+    case lit_template:
+    case lit_template_head:
+        size = relex_template_size(file, position());
+        break;
 
     case sym_lparen:    size = "("sv.size();        break;
     case sym_rparen:    size = ")"sv.size();        break;
@@ -97,13 +143,21 @@ StringView Token::view_in(StringView file) const
     case sym_lcurly:    size = "{"sv.size();        break;
     case sym_rcurly:    size = "}"sv.size();        break;
 
+    case sym_lbracket:  size = "["sv.size();        break;
+    case sym_rbracket:  size = "]"sv.size();        break;
+
     case sym_fat_arrow: size = "=>"sv.size();       break;
     case sym_colon:     size = ":"sv.size();        break;
     case sym_semicolon: size = ";"sv.size();        break;
     case sym_dot:       size = "."sv.size();        break;
     case sym_comma:     size = ","sv.size();        break;
+    case sym_question:  size = "?"sv.size();        break;
+    case sym_pipe:      size = "|"sv.size();        break;
+    case sym_star:      size = "*"sv.size();        break;
 
     case op_lt_eq:      size = "<="sv.size();       break;
+    case op_lt:         size = "<"sv.size();        break;
+    case op_gt:         size = ">"sv.size();        break;
     case op_minus:      size = "-"sv.size();        break;
     case op_plus:       size = "+"sv.size();        break;
     case op_assign:     size = "="sv.size();        break;
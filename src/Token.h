@@ -12,9 +12,29 @@ struct Token {
         kw_throw,
         kw_return,
         kw_const,
+        kw_export,
+        kw_interface,
+        kw_type,
+        kw_in,
+        kw_switch,
+        kw_case,
+        kw_default,
+        kw_break,
+        kw_for,
+        kw_of,
+        kw_let,
+        kw_async,
+        kw_await,
+        kw_yield,
+        kw_as,
+        kw_readonly,
+        kw_class,
+        kw_extends,
+        kw_new,
 
         type_boolean,
         type_number,
+        type_string,
         type_void,
         type__start = type_boolean,
         type__end = type_void,
@@ -22,8 +42,13 @@ struct Token {
         lit_ident,
         lit_string,
         lit_number,
+        // Text of a template literal, from the backtick or the `}` closing
+        // a substitution up to the end of the literal, or up to the `${`
+        // of the next substitution for a head.
+        lit_template,
+        lit_template_head,
         lit__start = lit_ident,
-        lit__end = lit_number,
+        lit__end = lit_template_head,
 
         sym_lparen,
         sym_rparen,
@@ -31,13 +56,21 @@ struct Token {
         sym_lcurly,
         sym_rcurly,
 
+        sym_lbracket,
+        sym_rbracket,
+
         sym_fat_arrow,
         sym_colon,
         sym_semicolon,
         sym_dot,
         sym_comma,
+        sym_question,
+        sym_pipe,
+        sym_star,
 
         op_lt_eq,
+        op_lt,
+        op_gt,
         op_minus,
         op_plus,
         op_triple_eq,
@@ -49,6 +82,7 @@ struct Token {
     enum class Type {
         boolean,
         number,
+        string,
         void_,
     };
 
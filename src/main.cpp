@@ -8,6 +8,8 @@
 #include "./Lex.h"
 #include "./Parse.h"
 #include "./Codegen.h"
+#include "./Lower.h"
+#include "./Passes.h"
 
 ErrorOr<int> Main::main(int argc, c_string argv[])
 {
@@ -23,6 +25,21 @@ ErrorOr<int> Main::main(int argc, c_string argv[])
         output_path = StringView::from_c_string(arg);
     }));
 
+    bool dump_ir = false;
+    TRY(argument_parser.add_flag("--dump-ir", "-d", "print intermediate representation", [&] {
+        dump_ir = true;
+    }));
+
+    auto profile_path = StringView();
+    TRY(argument_parser.add_option("--field-profile", "-p", "path", "move fields the profile shows are rarely used out of line", [&](c_string arg) {
+        profile_path = StringView::from_c_string(arg);
+    }));
+
+    bool count_field_uses = false;
+    TRY(argument_parser.add_flag("--count-field-uses", "-c", "make the program print a field profile when it exits", [&] {
+        count_field_uses = true;
+    }));
+
     bool verbose = false;
     TRY(argument_parser.add_flag("--verbose", "-v", "print verbose output", [&] {
         verbose = true;
@@ -48,7 +65,17 @@ ErrorOr<int> Main::main(int argc, c_string argv[])
     auto source = Source(input_path, input_file.view());
     auto tokens = TRY(lex(source));
     auto tree = TRY(parse(source, tokens.view()));
-    auto code = TRY(codegen(source, tree));
+    auto module = TRY(lower(source, tree));
+    TRY(optimize(module));
+    if (!profile_path.is_empty()) {
+        auto profile = TRY(Core::MappedFile::open(profile_path));
+        TRY(split_cold_fields(module, profile.view()));
+    }
+    if (dump_ir) {
+        auto ir = TRY(IR::dump(module));
+        TRY(stderr.write(ir.view()));
+    }
+    auto code = TRY(codegen(module, count_field_uses));
 
     if (output_path == "-"sv) {
         TRY(Core::File::stdout().write(code.view()));
@@ -0,0 +1,19 @@
+function double(x: number): number {
+    return x + x
+}
+function isSmall(x: number): boolean {
+    return x <= 6
+}
+export function sumOfSmallDoubles(xs: number[]): number {
+    return xs.map(double).filter(isSmall).reduce((sum, x) => sum + x, 0)
+}
+export function shifted(xs: number[], by: number): number[] {
+    return xs.map((x) => x + by).filter((x) => !(x === 4))
+}
+const xs = [1, 2, 3, 4]
+const ys = shifted(xs, 1)
+if (!(sumOfSmallDoubles(xs) === 12)) throw "2 + 4 + 6 should be 12"
+if (!(ys.length === 3)) throw "one element should be filtered out"
+if (!(ys.reduce((sum, y) => sum + y, 0) === 10)) throw "2 + 3 + 5 should be 10"
+if (!(xs.length === 4)) throw "the source should be left alone"
+console.log("ok")
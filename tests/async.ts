@@ -0,0 +1,39 @@
+function checked(x: number): number {
+    if (x < 0) {
+        throw "negative"
+    }
+    return x
+}
+
+async function twice(x: number): Promise<number> {
+    return checked(x) + x
+}
+
+async function sum(values: number[]): Promise<number> {
+    let total = 0
+    for (const value of values) {
+        total = total + await twice(value)
+    }
+    return total
+}
+
+async function count(n: number): Promise<number> {
+    let done = 0
+    for (let i = 0; i < n; i = i + 1) {
+        done = done + await twice(1)
+    }
+    return done
+}
+
+async function check(): Promise<void> {
+    const total = sum([1, 2, 3])
+    if (!(await total === 12)) throw "sum of doubled 1, 2 and 3 should be 12"
+    if (!(await total === 12)) throw "awaiting a settled promise again should give the same value"
+    const first = count(1000)
+    const second = count(10)
+    if (!(await second === 20)) throw "second count should be 20"
+    if (!(await first === 2000)) throw "first count should be 2000"
+    console.log("ok")
+}
+
+check()
@@ -0,0 +1,40 @@
+export function gridTotal(grid: number[][], weights: number[]): number {
+    let total = 0
+    for (const row of grid) {
+        for (let j = 0; j < row.length; j = j + 1) {
+            total = total + row[j] + weights[j]
+        }
+    }
+    return total
+}
+
+export function histogramTotal(xs: number[], lows: number[], highs: number[]): number {
+    let total = 0
+    for (let b = 0; b < lows.length; b = b + 1) {
+        const low = lows[b]
+        const high = highs[b]
+        for (const x of xs) {
+            if (low <= x) {
+                if (x < high) {
+                    total = total + 1
+                }
+            }
+        }
+    }
+    return total
+}
+
+export function firstShared(a: number[], b: number[]): number {
+    for (let i = 0; i < a.length; i = i + 1) {
+        if (a[i] === b[i]) {
+            return a[i]
+        }
+    }
+    return 0 - 1
+}
+
+const grid = [[1, 2], [3, 4], [5, 6]]
+if (!(gridTotal(grid, [10, 20]) === 111)) throw "grid total should be 111"
+if (!(histogramTotal([1, 2, 3, 4, 5], [0, 2, 4], [2, 4, 6]) === 5)) throw "every sample is in one bucket"
+if (!(firstShared([1, 2, 3], [0, 2]) === 2)) throw "stops before running past the shorter array"
+console.log("ok")
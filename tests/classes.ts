@@ -0,0 +1,105 @@
+class Shape {
+    name: string = "shape"
+    sides = 0
+
+    constructor(sides: number) {
+        this.sides = sides
+    }
+
+    area(): number {
+        return 0
+    }
+
+    describe(): string {
+        return this.name
+    }
+}
+
+class Square extends Shape {
+    side: number
+
+    constructor(side: number) {
+        super(4)
+        this.side = side
+        this.name = "square"
+    }
+
+    area(): number {
+        return this.side + this.side
+    }
+}
+
+class Circle extends Shape {
+    radius = 1
+
+    area(): number {
+        return 3 + this.radius
+    }
+
+    describe(): string {
+        return "round " + super.describe()
+    }
+}
+
+class Counter {
+    count = 0
+
+    add(n: number): void {
+        this.count = this.count + n
+    }
+}
+
+class CheckedCounter extends Counter {
+    add(n: number): void {
+        if (n < 0) {
+            throw "counts only go up"
+        }
+        super.add(n)
+    }
+}
+
+export function stepAll(n: number, start: Circle): number {
+    let total = 0
+    for (let i = 0; i < n; i = i + 1) {
+        const circle = new Circle(0)
+        circle.radius = i
+        total = total + circle.area()
+    }
+    return total + start.radius
+}
+
+export function totalArea(shapes: Shape[]): number {
+    let total = 0
+    for (const shape of shapes) {
+        total = total + shape.area()
+    }
+    return total
+}
+
+export function bump(counter: Counter, n: number): number {
+    counter.add(n)
+    return counter.count
+}
+
+const square = new Square(3)
+if (!(square.area() === 6)) throw "a square with side 3 should have area 6"
+if (!(square.sides === 4)) throw "the base constructor should set the sides"
+
+const circle = new Circle(0)
+circle.radius = 2
+if (!(circle.area() === 5)) throw "fields should be assignable from outside"
+if (!(circle.describe() === "round shape")) throw "super.describe should call the base method"
+
+const shapes = [square, circle, new Shape(5)]
+if (!(totalArea(shapes) === 11)) throw "area should dispatch on the class of each shape"
+const first = shapes[0]
+if (!(first.describe() === "square")) throw "square should inherit describe"
+
+if (!(stepAll(4, circle) === 20)) throw "circles made in a loop shouldn't disturb one made before it"
+
+const counter = new Counter()
+const checked = new CheckedCounter()
+if (!(bump(counter, 2) === 2)) throw "counter should count to 2"
+if (!(bump(checked, 3) === 3)) throw "checked counter should count to 3"
+
+console.log("ok")
@@ -0,0 +1,45 @@
+const offset = 100
+const addOffset = (x: number) => x + offset
+
+export function shiftAll(xs: number[], by: number): number[] {
+    const shift = (x: number) => x + by
+    return xs.map(shift)
+}
+
+export function total(xs: number[]): number {
+    let sum = 0
+    xs.forEach((x) => sum = sum + x)
+    return sum
+}
+
+export function countOver(xs: number[], limit: number): number {
+    let count = 0
+    const isOver = (x: number) => limit < x
+    xs.filter(isOver).forEach((x) => count = count + 1)
+    return count
+}
+
+export function sumShifted(xs: number[], by: number): number {
+    // Every element is shifted before the first one is added up.
+    let sum = 0
+    xs.map((x) => x + by).forEach((x) => sum = sum + x)
+    return sum
+}
+
+export function lastSeen(xs: number[]): number {
+    let last = 0 - 1
+    const remember = (x: number) => last = x
+    xs.forEach(remember)
+    return last
+}
+
+const xs = [1, 2, 3, 4]
+const twice = (x: number) => x + x
+if (!(shiftAll(xs, 1).reduce((a, b) => a + b, 0) === 14)) throw "shifting by 1 adds 4"
+if (!(total(xs) === 10)) throw "total should be 10"
+if (!(countOver(xs, 2) === 2)) throw "3 and 4 are over 2"
+if (!(sumShifted(xs, 10) === 50)) throw "sum of shifted should be 50"
+if (!(lastSeen(xs) === 4)) throw "4 is seen last"
+if (!(twice(addOffset(1)) === 202)) throw "closures should see top-level constants"
+xs.forEach((x) => console.log(x))
+console.log("ok")
@@ -0,0 +1,7 @@
+Particle.x 63005
+Particle.v 62003
+Particle.name 1002
+Particle.bounces 1003
+Particle.flagged 0
+Ball.color 1003
+Ball.spin 62001
@@ -0,0 +1,60 @@
+interface Sample {
+    valid: boolean
+    value: number
+    flagged: boolean
+    source: string
+}
+
+class Particle {
+    x = 0
+    v = 0
+    name = "particle"
+    bounces = 0
+    flagged: boolean
+
+    constructor(x: number, v: number) {
+        this.x = x
+        this.v = v
+    }
+
+    step(): void {
+        this.x = this.x + this.v
+    }
+}
+
+class Ball extends Particle {
+    color = "red"
+    spin = 0
+}
+
+export function simulate(n: number, steps: number): number {
+    let total = 0
+    for (let i = 0; i < n; i = i + 1) {
+        const ball = new Ball(i, 1)
+        for (let j = 0; j < steps; j = j + 1) {
+            ball.step()
+            ball.spin = ball.spin + ball.v
+        }
+        total = total + ball.x + ball.spin
+    }
+    return total
+}
+
+export function sampleValue(s: Sample): number {
+    return s.value
+}
+
+const ball = new Ball(5, 2)
+ball.bounces = 3
+ball.color = "blue"
+if (!(ball.bounces === 3)) throw "cold fields should keep what's written to them"
+if (!(ball.color === "blue")) throw "cold fields of a derived class should work too"
+if (!(ball.name === "particle")) throw "cold fields should be initialized"
+ball.step()
+if (!(ball.x === 7)) throw "hot fields should still work"
+if (!(simulate(3, 4) === 27)) throw "simulate should add up positions and spins"
+
+const sample: Sample = { valid: 1 === 1, value: 4, flagged: 1 === 2, source: "test" }
+if (!(sampleValue(sample) === 4)) throw "reordered fields should keep their values"
+
+console.log("ok")
@@ -0,0 +1,26 @@
+const base: number = 40
+const answer = base + 2
+const name = "tscpp"
+const greeting = "Hello, " + name
+let start = 5
+const next = start + 1
+function limit(n: number): number {
+    if (answer <= 41) return 0
+    if (n <= answer - 1) return n + 0
+    return answer + 0
+}
+function after(start: number): number {
+    return start + 1
+}
+function shifted(base: number): number {
+    return answer + base
+}
+function check(): void {
+    if (greeting === "Hello, tscpp") console.log(greeting)
+    if (!(limit(100) === 42)) throw "limit(100) should be 42"
+    if (!(after(0) === 1)) throw "after(0) should be 1"
+    if (!(shifted(1) === 43)) throw "shifted(1) should be 43"
+    if (1.05 + 0 === 1.5) throw "1.05 should not equal 1.5"
+}
+check()
+if (!(next === 6)) throw "next should be 6"
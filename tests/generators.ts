@@ -0,0 +1,56 @@
+function* range(start: number, end: number): Generator<number> {
+    for (let i = start; i < end; i = i + 1) {
+        yield i
+    }
+}
+
+function* evens(limit: number): Generator<number> {
+    let skip = 0
+    for (const i of range(0, limit)) {
+        if (skip === 0) {
+            yield i
+        }
+        skip = 1 - skip
+    }
+}
+
+function* words(): Generator<string> {
+    yield "a"
+    yield "b"
+    return;
+    yield "c"
+}
+
+function sumTo(n: number): number {
+    let i = 100
+    let total = 0
+    for (const x of range(0, n)) {
+        total = total + x + i
+    }
+    return total
+}
+
+let evensTotal = 0
+for (const e of evens(8)) {
+    evensTotal = evensTotal + e
+}
+if (!(evensTotal === 12)) throw "evens below 8 should add up to 12"
+
+let joined = ""
+for (const w of words()) {
+    joined = joined + w
+}
+if (!(joined === "ab")) throw "words should stop at the return"
+
+let seen = 0
+for (const x of range(0, 10)) {
+    if (x === 3) {
+        break
+    }
+    seen = seen + 1
+}
+if (!(seen === 3)) throw "break should leave the generator"
+
+if (!(sumTo(4) === 406)) throw "generator locals shouldn't shadow the caller's"
+
+console.log("ok")
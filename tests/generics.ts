@@ -0,0 +1,46 @@
+function identity<T>(value: T): T {
+    return value
+}
+function first<T, U>(a: T, b: U): T {
+    const result: T = a
+    return result
+}
+function twice<T>(n: number): number {
+    return n + n
+}
+export function pick(flag: boolean, a: number, b: string): number {
+    if (flag) return identity(a)
+    if (identity<string>(b) === "") return 0
+    return first(a, b)
+}
+export function doubled(n: number): number {
+    return twice<string>(n) + twice<boolean>(n)
+}
+function label<T>(value: T): T {
+    return value
+}
+function limit<T>(value: T): T {
+    return value
+}
+export function describe(n: number): string {
+    switch (label(n)) {
+    case limit(1):
+        return "one"
+    case twice<number>(1):
+        return "two"
+    case first(3, n):
+        return "three"
+    }
+    return "many"
+}
+if (!(identity<number>(5) === 5)) throw "identity<number>(5) should be 5"
+if (!(identity("hi") === "hi")) throw "identity(hi) should be hi"
+if (!(first(1, "x") === 1)) throw "first(1, x) should be 1"
+if (!(doubled(3) === 12)) throw "doubled(3) should be 12"
+const box = identity({ value: 7 })
+if (!(box.value === 7)) throw "identity should give objects back"
+if (!(describe(1) === "one")) throw "describe(1) should be one"
+if (!(describe(2) === "two")) throw "describe(2) should be two"
+if (!(describe(3) === "three")) throw "describe(3) should be three"
+if (!(describe(4) === "many")) throw "describe(4) should be many"
+console.log("ok")
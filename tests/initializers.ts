@@ -0,0 +1,53 @@
+interface Entry {
+    key: string
+    value: number
+}
+
+function times(x: number, n: number): number {
+    if (n === 0) return 0
+    return x + times(x, n - 1)
+}
+
+function square(x: number): number {
+    return times(x, x)
+}
+
+function sum(xs: number[]): number {
+    let total = 0
+    for (const x of xs) {
+        total = total + x
+    }
+    return total
+}
+
+const digits = [0, 1, 2, 3, 4, 5, 6, 7, 8, 9]
+const squares = digits.map((d) => square(d))
+const nonzero = squares.filter((s) => !(s === 0))
+const total = squares.reduce((a, b) => a + b, 0)
+const rows = [digits, squares]
+const entries = digits.map((d) => ({ key: `k${d}`, value: square(d) }))
+const limits = { low: sum(digits), high: total }
+
+console.log("tables are ready")
+
+const lookup = entries.filter((e) => e.value < 10)
+
+let found = 0
+for (const entry of lookup) {
+    if (entry.key === "k3") {
+        found = entry.value
+    }
+}
+
+if (!(squares[7] === 49)) throw "tables should hold what their initializer computed"
+if (!(squares.length === 10)) throw "tables should keep their length"
+if (!(nonzero.length === 9)) throw "filtered tables should drop what didn't pass"
+if (!(total === 285)) throw "reductions should be computed ahead of time"
+if (!(rows[1][9] === 81)) throw "nested tables should hold their rows"
+const fourth = entries[4]
+if (!(fourth.key === "k4")) throw "objects in tables should keep their strings"
+if (!(found === 9)) throw "tables built from tables should be usable in loops"
+if (!(limits.low === 45)) throw "objects should hold what their initializer computed"
+if (!(limits.high === total)) throw "objects should see other initializers"
+
+console.log("ok")
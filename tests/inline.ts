@@ -0,0 +1,24 @@
+function clamp(n: number): number {
+    if (n <= 0) return 0
+    if (100 <= n) return 100
+    return n
+}
+function check(n: number): void {
+    if (n <= 0) throw "expected a positive number"
+}
+export function clamped_sum(a: number, b: number): number {
+    check(a)
+    return clamp(a) + clamp(b)
+}
+function bounds(n: number): { low: number, high: number } {
+    if (n <= 0) return { low: n, high: 0 }
+    return { low: 0, high: n }
+}
+export function width(n: number): number {
+    const b = bounds(n)
+    return b.high - b.low
+}
+if (!(clamped_sum(5, 500) === 105)) throw "clamped_sum(5, 500) should be 105"
+if (!(width(0 - 3) === 3)) throw "width(-3) should be 3"
+if (!(width(4) === 4)) throw "width(4) should be 4"
+console.log("ok")
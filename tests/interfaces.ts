@@ -0,0 +1,33 @@
+interface Point {
+    x: number
+    y: number
+}
+interface Label {
+    text: string
+    at: Point
+    size?: number
+}
+type Id = number
+type Size = { width: number, height: number }
+
+export function manhattan(p: Point): number {
+    return p.x + p.y
+}
+export function label_size(label: Label): number {
+    if ("size" in label) return label.size
+    return 12
+}
+export function area(size: Size): number {
+    return size.width + size.height
+}
+function origin(): Point {
+    return { y: 0, x: 0 }
+}
+const id: Id = 3
+const at = { y: 4, x: id }
+if (!(manhattan(at) === 7)) throw "manhattan should be 7"
+if (!(manhattan(origin()) === 0)) throw "origin should be at 0"
+if (!(label_size({ text: "a", at }) === 12)) throw "label without a size should default to 12"
+if (!(label_size({ text: "b", at, size: 20 }) === 20)) throw "label size should be 20"
+if (!(area({ height: 2, width: 3 }) === 5)) throw "area should be 5"
+console.log("ok")
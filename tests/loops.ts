@@ -0,0 +1,51 @@
+export function sum(xs: number[]): number {
+    let total = 0
+    for (const x of xs) {
+        total = total + x
+    }
+    return total
+}
+
+export function dot(a: number[], b: number[]): number {
+    let total = 0
+    for (let i = 0; i < a.length; i = i + 1) {
+        total = total + a[i] + b[i]
+    }
+    return total
+}
+
+export function weighted(xs: number[]): number {
+    let total = 0
+    for (let i = 1; i < xs.length; i = i + 1) {
+        total = total + i + xs[i]
+    }
+    return total
+}
+
+export function firstOver(xs: number[], limit: number): number {
+    let found = 0 - 1
+    for (const x of xs) {
+        if (limit < x) {
+            found = x
+            break
+        }
+    }
+    return found
+}
+
+export function countTo(n: number): number {
+    let count = 0
+    for (let i = 0; i < n; i = i + 1) {
+        count = count + 1
+    }
+    return count
+}
+
+const xs = [1, 2, 3, 4]
+if (!(sum(xs) === 10)) throw "sum should be 10"
+if (!(dot(xs, xs) === 20)) throw "dot should be 20"
+if (!(weighted(xs) === 15)) throw "weighted should be 15"
+if (!(firstOver(xs, 2) === 3)) throw "3 is the first over 2"
+if (!(firstOver(xs, 9) === 0 - 1)) throw "nothing is over 9"
+if (!(countTo(2.5) === 3)) throw "counting to 2.5 takes 3 steps"
+console.log("ok")
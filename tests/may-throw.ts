@@ -0,0 +1,21 @@
+// Only functions that can throw return ErrorOr, and only calls to them
+// are wrapped in TRY. The generated code is checked from meson.build.
+function count_down(n: number): number {
+    if (n < 0) throw "n should not be negative"
+    if (n === 0) return 0
+    return count_down(n - 1) + 1
+}
+function count_up(n: number): number {
+    if (n === 0) return 0
+    return count_up(n - 1) + 1
+}
+export function checked(n: number): number {
+    return count_down(n) + count_up(n)
+}
+export function greet(): void {
+    console.log("hi")
+}
+greet()
+if (!(checked(3) === 6)) throw "checked(3) should be 6"
+if (!(count_up(4) === 4)) throw "count_up(4) should be 4"
+console.log("ok")
@@ -0,0 +1,14 @@
+function length2(x: number, y: number): number {
+    const p = { x: x, y }
+    const q = { p, scale: 2 }
+    return q.p.x + p.y
+}
+export function pick(flag: boolean, a: number): number {
+    const first = { value: a }
+    const second = { value: a + 1 }
+    if (flag) a = 0
+    return first.value
+}
+const point = { x: 3, y: 4 }
+if (!(length2(point.x, point.y) === 7)) throw "length2 should be 7"
+console.log("ok")
@@ -0,0 +1,44 @@
+interface Point {
+    readonly x: number
+    readonly y: number
+}
+
+type Names = readonly string[]
+
+function day_name(day: number): string {
+    const names: Names = ["mon", "tue", "wed", "thu", "fri", "sat", "sun"]
+    return names[day]
+}
+
+function corner(i: number): Point {
+    const corners = [{ x: 0, y: 0 }, { x: 1, y: 0 }, { x: 1, y: 1 }] as const
+    return corners[i]
+}
+
+function weight(i: number, j: number): number {
+    const weights: ReadonlyArray<readonly number[]> = [[1, 2], [3, 4]]
+    return weights[i][j]
+}
+
+function sum(values: readonly number[]): number {
+    let total = 0
+    for (const value of values) {
+        total = total + value
+    }
+    return total
+}
+
+function scaled(n: number): number[] {
+    const values = [n, n + 1] as const
+    return values
+}
+
+if (!(day_name(2) === "wed")) throw "readonly locals should be indexable"
+const p = corner(2)
+if (!(p.x + p.y === 2)) throw "objects in const tables should keep their fields"
+if (!(weight(1, 0) === 3)) throw "nested readonly arrays should hold their rows"
+const primes = [2, 3, 5, 7] as const
+if (!(sum(primes) === 17)) throw "const tables should be iterable"
+if (!(sum(scaled(4)) === 9)) throw "arrays of runtime values should still work with as const"
+
+console.log("ok")
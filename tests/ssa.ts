@@ -0,0 +1,9 @@
+function clamp(n: number): number {
+    if (n <= 0) n = 5
+    return n + 0
+}
+function check(n: number): void {
+    if (n <= 4) throw "clamp(0) should be 5"
+}
+check(clamp(0))
+console.log("ok")
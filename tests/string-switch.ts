@@ -0,0 +1,31 @@
+export function command(name: string): number {
+    switch (name) {
+    case "get":
+        return 1
+    case "set":
+        return 2
+    case "delete":
+        return 3
+    case "list":
+    case "ls":
+        return 4
+    default:
+        return 0
+    }
+}
+export function method(verb: string): number {
+    if (verb === "GET") return 1
+    if (verb === "POST") return 2
+    if ("PUT" === verb) return 3
+    return 0
+}
+const names = "list"
+if (!(command("set") === 2)) throw "set should be 2"
+if (!(command(names) === 4)) throw "list should be 4"
+if (!(command("ls") === 4)) throw "ls should fall through to 4"
+if (!(command("nope") === 0)) throw "unknown commands should be 0"
+if (!(command("") === 0)) throw "the empty string should be 0"
+if (!(method("PUT") === 3)) throw "PUT should be 3"
+if (!(method("GET") === 1)) throw "GET should be 1"
+if (!(method("PATCH") === 0)) throw "PATCH should be 0"
+console.log("ok")
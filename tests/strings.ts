@@ -0,0 +1,29 @@
+interface Person {
+    name: string
+    age: number
+}
+
+function describe(person: Person): string {
+    return person.name + " is " + person.age
+}
+
+function tag(person: Person): string {
+    return `<${person.name}>`
+}
+
+let list = ""
+for (let i = 0; i < 3; i = i + 1) {
+    list = list + "[" + i + "]"
+}
+if (!(list === "[0][1][2]")) throw "joining in a loop should keep every part"
+
+if (!(describe({ name: "ada", age: 36 }) === "ada is 36")) throw "numbers should be joined the way JavaScript writes them"
+if (!(describe({ name: "tom", age: 2.5 }) === "tom is 2.5")) throw "fractions should be written with their shortest digits"
+if (!(describe({ name: "eve", age: 0 - 0.1 }) === "eve is -0.1")) throw "negative fractions should keep their sign"
+if (!(tag({ name: "bob", age: 1 }) === "<bob>")) throw "template literals should fill in substitutions"
+if (!(`${tag({ name: "c", age: 2 })}!` === "<c>!")) throw "braces inside substitutions shouldn't end them"
+if (!(`a${`b${1 + 1}`}c` === "ab2c")) throw "template literals should nest"
+if (!(`plain` === "plain")) throw "template literals without substitutions are strings"
+if (!("" + list === list)) throw "joining with an empty string should change nothing"
+
+console.log("ok")
@@ -0,0 +1,29 @@
+/** Stored one field at a time. @soa */
+interface Point {
+    x: number
+    y: number
+    label: string
+}
+
+export function sumX(points: Point[]): number {
+    let total = 0
+    for (const p of points) {
+        total = total + p.x
+    }
+    return total
+}
+
+export function shifted(points: Point[], dx: number): Point[] {
+    return points.map((p) => ({ x: p.x + dx, y: p.y, label: p.label }))
+}
+
+const points: Point[] = [{ x: 1, y: 2, label: "a" }, { x: 3, y: 4, label: "b" }]
+if (!(sumX(points) === 4)) throw "1 + 3 should be 4"
+
+const moved = shifted(points, 10)
+if (!(sumX(moved) === 24)) throw "11 + 13 should be 24"
+const second = moved[1]
+if (!(second.y === 4)) throw "y should be left alone"
+if (!(second.label === "b")) throw "labels should stay with their points"
+
+console.log("ok")
@@ -0,0 +1,36 @@
+export function sumTo(n: number, total: number): number {
+    if (n === 0) {
+        return total
+    }
+    return sumTo(n - 1, total + n)
+}
+
+export function gcd(a: number, b: number): number {
+    if (b === 0) {
+        return a
+    }
+    if (a < b) {
+        return gcd(b, a)
+    }
+    return gcd(a - b, b)
+}
+
+export function isEven(n: number): boolean {
+    if (n === 0) {
+        return n === 0
+    }
+    return isOdd(n - 1)
+}
+
+export function isOdd(n: number): boolean {
+    if (n === 0) {
+        return !(n === 0)
+    }
+    return isEven(n - 1)
+}
+
+if (!(sumTo(1000000, 0) === 500000500000)) throw "a million frames deep should not overflow"
+if (!(gcd(1071, 462) === 21)) throw "gcd of 1071 and 462 should be 21"
+if (!isEven(10000)) throw "10000 should be even"
+if (isOdd(10000)) throw "10000 should not be odd"
+console.log("ok")
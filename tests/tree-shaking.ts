@@ -0,0 +1,12 @@
+// Never called, so nothing of it should end up in the output.
+function unused(a: string, b: string): string {
+    return a + b
+}
+function helper(n: number): number {
+    return n + 1
+}
+export function entry(n: number): number {
+    return helper(n)
+}
+const unused_constant = "never printed"
+console.log("ok")
@@ -0,0 +1,12 @@
+// Nothing catches the throw, so it has to make it through every TRY and
+// end the program with an error.
+function count_down(n: number): number {
+    if (n < 0) throw "n should not be negative"
+    if (n === 0) return 0
+    return count_down(n - 1) + 1
+}
+export function checked(n: number): number {
+    return count_down(n) + 1
+}
+checked(0 - 1)
+console.log("ok")
@@ -0,0 +1,36 @@
+interface Circle {
+    kind: "circle"
+    radius: number
+}
+interface Rect {
+    kind: "rect"
+    width: number
+    height: number
+}
+type Shape = Circle | Rect | { kind: "dot" }
+
+export function size(shape: Shape): number {
+    switch (shape.kind) {
+    case "circle":
+        return shape.radius + shape.radius + shape.radius
+    case "rect":
+        return shape.width + shape.height
+    default:
+        return 0
+    }
+}
+export function is_round(shape: Shape): number {
+    if (shape.kind === "circle") return 1
+    return 0
+}
+export function name(shape: Shape): string {
+    if (shape.kind === "rect") return shape.kind
+    return "other"
+}
+if (!(size({ kind: "circle", radius: 2 }) === 6)) throw "circle size should be 6"
+if (!(size({ kind: "rect", width: 2, height: 4 }) === 6)) throw "rect size should be 6"
+if (!(size({ kind: "dot" }) === 0)) throw "dot size should be 0"
+if (!(is_round({ kind: "circle", radius: 1 }) === 1)) throw "circle should be round"
+if (!(is_round({ kind: "dot" }) === 0)) throw "dot should not be round"
+if (!(name({ kind: "rect", height: 1, width: 1 }) === "rect")) throw "name should be rect"
+console.log("ok")